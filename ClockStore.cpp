@@ -0,0 +1,221 @@
+// Summary:
+//    Contains the implementation of the ClockStore class.
+
+#include "ClockStore.h"
+
+#include <iostream>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+
+#include "rinex.h"
+#include "NRinexUtils.h"
+
+namespace
+{
+   const double C = 299792458.0;               // m/s
+   const double SECSPERWEEK = 604800.0;
+
+   // satellite systems with a clock table, in table order
+   const char SYSTEMCODES[] = "GRESCJ";
+
+   bool earlier( const ClockRecord &record, double t )
+   {
+      return record.t < t;
+   }
+}
+
+//============================= ClockStore Class ==============================
+
+ClockStore::ClockStore()
+{
+   baseWeek = -1;
+   numPoints = 2;
+   maxGap = 5.0 * 60.0;
+}
+
+
+bool ClockStore::load( const std::string& filename )
+{
+   NGSrinex::ClockDataFile clockFile;
+   if (!NRinexUtils::OpenRinexClockFileForInput(clockFile, filename))
+   {
+      std::cerr << "Error opening clock file: " << filename << "\n";
+      return false;
+   }
+
+   NGSrinex::ClkEpoch epoch;
+   try
+   {
+      while (clockFile.readEpoch(epoch) != 0)
+      {
+         if (epoch.getClockDataType() != NGSrinex::AS || epoch.getNumberDataValues() < 1)
+            continue;
+
+         // "G05 " in RINEX clock 2.00; a bare number is a GPS satellite
+         std::string name = epoch.getRecvrSatName();
+         char system = 'G';
+         if (!name.empty() && isalpha(static_cast<unsigned char>(name[0])))
+         {
+            system = name[0];
+            name.erase(0, 1);
+         }
+         int satNum = atoi(name.c_str());
+
+         NGSdatetime::GPSTime gpsTime = epoch.getEpochTime().GetGPSTime();
+         add(system, satNum, gpsTime.GPSWeek, gpsTime.secsOfWeek, epoch.getClockBias());
+      }
+   }
+   catch (NGSrinex::RinexReadingException &readingExcep)
+   {
+      std::cerr << "Error reading clock file: " << filename << "\n"
+                << readingExcep.getMessage() << "\n";
+      return false;
+   }
+
+   return true;
+}
+
+
+void ClockStore::add( char system, int satNum, long gpsWeek, double secsOfWeek, double bias )
+{
+   int index = tableIndex(system, satNum);
+   if (index < 0)
+      return;
+   if (baseWeek < 0)
+      baseWeek = gpsWeek;
+   if (tables.size() <= static_cast<size_t>(index))
+      tables.resize(index + 1);
+
+   ClockRecord record;
+   record.t = toStoreTime(gpsWeek, secsOfWeek);
+   record.bias = bias;
+
+   // consecutive daily files repeat the epoch at midnight
+   std::vector<ClockRecord> &table = tables[index];
+   if (table.empty() || table.back().t < record.t)
+   {
+      table.push_back(record);
+      return;
+   }
+   auto it = std::lower_bound(table.begin(), table.end(), record.t, earlier);
+   if (it->t != record.t)
+      table.insert(it, record);
+}
+
+
+void ClockStore::setNumPoints( int points )
+{
+   numPoints = std::max(2, std::min(points, static_cast<int>(MAXPOINTS)));
+}
+
+
+bool ClockStore::interpolate( char system, int satNum, long gpsWeek, double secsOfWeek,
+                              double &bias ) const
+{
+   int index = tableIndex(system, satNum);
+   if (index < 0 || static_cast<size_t>(index) >= tables.size())
+      return false;
+
+   const std::vector<ClockRecord> &table = tables[index];
+   double t = toStoreTime(gpsWeek, secsOfWeek);
+   auto it = std::lower_bound(table.begin(), table.end(), t, earlier);
+   if (it == table.end())
+      return false;
+   if (it->t == t)
+   {
+      bias = it->bias;
+      return true;
+   }
+   if (it == table.begin())
+      return false;
+
+   // the records around t, widened to numPoints records centred on them
+   // where the table allows
+   long next = it - table.begin();
+   if (table[next].t - table[next - 1].t > maxGap)
+      return false;
+   long size = static_cast<long>(table.size());
+   long count = std::min(static_cast<long>(numPoints), size);
+   long first = std::max(0L, std::min(next - count / 2, size - count));
+   for (long i = first + 1; i < first + count; ++i)
+   {
+      if (table[i].t - table[i - 1].t > maxGap)
+      {
+         // a gap elsewhere in the window: fall back to the two records around t
+         first = next - 1;
+         count = 2;
+         break;
+      }
+   }
+
+   // Lagrange interpolation, relative to the first record for precision
+   const ClockRecord *records = &table[first];
+   double base = records[0].bias;
+   bias = base;
+   for (long i = 0; i < count; ++i)
+   {
+      double weight = 1.0;
+      for (long j = 0; j < count; ++j)
+         if (j != i)
+            weight *= (t - records[j].t) / (records[i].t - records[j].t);
+      bias += weight * (records[i].bias - base);
+   }
+   return true;
+}
+
+
+bool ClockStore::correctSatellite( SatelliteData &satellite, long gpsWeek, double secsOfWeek,
+                                   double pseudorange ) const
+{
+   // r.v is the same in the ECEF and the inertial frame, as the Earth's
+   // rotation only adds a velocity perpendicular to r
+   double rv = satellite.x * satellite.vx + satellite.y * satellite.vy
+             + satellite.z * satellite.vz;
+   if (std::isnan(rv))
+      return false;
+
+   double bias;
+   if (!interpolate(satellite.system, satellite.prn, gpsWeek, secsOfWeek - pseudorange / C, bias))
+      return false;
+
+   double relativistic = -2.0 * rv / (C * C);
+   satellite.correction = -C * (bias + relativistic);
+   return true;
+}
+
+
+size_t ClockStore::getNumRecords() const
+{
+   size_t count = 0;
+   for (size_t i = 0; i < tables.size(); ++i)
+      count += tables[i].size();
+   return count;
+}
+
+
+size_t ClockStore::getNumSatellites() const
+{
+   size_t count = 0;
+   for (size_t i = 0; i < tables.size(); ++i)
+      if (!tables[i].empty())
+         count++;
+   return count;
+}
+
+
+int ClockStore::tableIndex( char system, int satNum )
+{
+   const char *code = system != '\0' ? strchr(SYSTEMCODES, system) : nullptr;
+   if (!code || satNum <= 0 || satNum >= MAXSATNUM)
+      return -1;
+   return static_cast<int>(code - SYSTEMCODES) * MAXSATNUM + satNum;
+}
+
+
+double ClockStore::toStoreTime( long gpsWeek, double secsOfWeek ) const
+{
+   return static_cast<double>(gpsWeek - baseWeek) * SECSPERWEEK + secsOfWeek;
+}
@@ -0,0 +1,122 @@
+// Summary:
+//    Precise satellite clocks read from RINEX clock files (the AS records of
+//    IGS and analysis centre clock products).  The records of each satellite
+//    are kept sorted by time, so a query is a binary search for the records
+//    around the requested time followed by linear interpolation, or Lagrange
+//    interpolation over a few neighbouring records; a 30 s product spanning
+//    several days costs a handful of comparisons per query.
+//
+//    The clocks follow the IGS convention and exclude the periodic
+//    relativistic effect, so correctSatellite() adds -2 r.v / c^2 to them,
+//    from the satellite's position and velocity.  Times are GPS system time.
+
+#ifndef ClockStore_H
+#define ClockStore_H
+
+#include <string>
+#include <vector>
+
+#include "SatPosStore.h"
+
+// One satellite clock record
+struct ClockRecord
+{
+   double t;                      // seconds since the start of the store's base week
+   double bias;                   // satellite clock minus GPS time (s)
+};
+
+class ClockStore
+{
+   public:
+      enum { MAXSATNUM = 100, MAXPOINTS = 10 };
+
+      ClockStore();
+
+      //**
+      // Summary:
+      //    Add the AS records of a RINEX clock file to the store.  May be
+      //    called for several files (e.g. consecutive days); records that
+      //    repeat an epoch already in the store are dropped.
+      //
+      // Arguments:
+      //    filename - The name of the file.
+      //
+      // Returns:
+      //    True if successful and false otherwise.
+      bool load( const std::string& filename );
+
+      //**
+      // Summary:
+      //    Add one clock record, keeping its satellite's table sorted by
+      //    time.  Records arriving in time order are appended.
+      //
+      // Arguments:
+      //    system - RINEX satellite system code ('G', 'R', 'S', ...).
+      //    satNum - Satellite number within the system.
+      //    gpsWeek, secsOfWeek - GPS time of the record.
+      //    bias - Satellite clock bias (s).
+      void add( char system, int satNum, long gpsWeek, double secsOfWeek, double bias );
+
+      //**
+      // Summary:
+      //    Set the number of records used for interpolation: 2 (the default)
+      //    is linear interpolation between the records around the requested
+      //    time, more is Lagrange interpolation over that many records
+      //    centred on it.  Clock products are noisy, so few points are best.
+      void setNumPoints( int points );
+
+      //**
+      // Summary:
+      //    Set the largest spacing of the records used for interpolation.
+      //    The default of 5 minutes accepts 5 minute products and 30 s ones
+      //    with a few missing records.
+      void setMaxGap( double seconds ) { maxGap = seconds; }
+
+      //**
+      // Summary:
+      //    Interpolate a satellite's clock bias.
+      //
+      // Arguments:
+      //    system, satNum - The satellite.
+      //    gpsWeek, secsOfWeek - GPS time.
+      //    bias - Receives the clock bias (s).
+      //
+      // Returns:
+      //    True if the time lies within the satellite's records and no
+      //    record spacing used exceeds the maximum gap.
+      bool interpolate( char system, int satNum, long gpsWeek, double secsOfWeek,
+                        double &bias ) const;
+
+      //**
+      // Summary:
+      //    Replace the correction of a satellite by -c times its precise
+      //    clock plus the relativistic effect, at the transmit time of its
+      //    pseudorange.
+      //
+      // Arguments:
+      //    satellite - The satellite, whose position and velocity are at
+      //                transmit time.
+      //    gpsWeek, secsOfWeek - GPS receive time.
+      //    pseudorange - The satellite's pseudorange (m).
+      //
+      // Returns:
+      //    True if the correction was replaced; false if the clock could not
+      //    be interpolated or the satellite has no velocity (a satpos.txt
+      //    satellite with no neighbouring epoch within a minute).
+      bool correctSatellite( SatelliteData &satellite, long gpsWeek, double secsOfWeek,
+                             double pseudorange ) const;
+
+      size_t getNumRecords() const;
+      size_t getNumSatellites() const;
+
+   private:
+      std::vector< std::vector<ClockRecord> >   tables;    // indexed by tableIndex()
+      long                                      baseWeek;  // -1 until the first record
+      int                                       numPoints;
+      double                                    maxGap;
+
+      static int tableIndex( char system, int satNum );
+      double toStoreTime( long gpsWeek, double secsOfWeek ) const;
+};
+
+#endif //ClockStore_H
@@ -0,0 +1,237 @@
+// Summary:
+//    Contains the implementation of the EphemerisBatch class.
+
+#include "EphemerisBatch.h"
+
+#include <cmath>
+
+// The kernels are compiled for AVX-512, AVX2 and the baseline x86-64, and
+// the loader picks the version for the CPU; elsewhere there is one version
+#if defined(__x86_64__) && defined(__GNUC__) && defined(__has_attribute)
+#if __has_attribute(target_clones)
+#define BATCH_KERNEL __attribute__((target_clones("avx512f", "avx2", "default")))
+#endif
+#endif
+#ifndef BATCH_KERNEL
+#define BATCH_KERNEL
+#endif
+
+namespace
+{
+   // IS-GPS-200 constants
+   const double GM = 3.986005e14;              // m^3/s^2
+   const double OMEGAE = 7.2921151467e-5;      // rad/s
+   const double F = -4.442807633e-10;          // s/m^(1/2)
+   const double SECSPERWEEK = 604800.0;
+
+   // Newton's method from E = M converges to double precision in four
+   // iterations for e < 0.1; one more covers the rounding
+   const int KEPLERITERATIONS = 5;
+
+   // Each transcendental function gets a loop of its own: a sin and a cos of
+   // the same argument in one loop are merged into a sincos call, which the
+   // compiler does not vectorize.
+   BATCH_KERNEL void sinColumn( const double *in, double *out, size_t count )
+   {
+      for (size_t i = 0; i < count; ++i)
+         out[i] = sin(in[i]);
+   }
+
+   BATCH_KERNEL void cosColumn( const double *in, double *out, size_t count )
+   {
+      for (size_t i = 0; i < count; ++i)
+         out[i] = cos(in[i]);
+   }
+}
+
+//========================== EphemerisBatch Class =============================
+
+EphemerisBatch::EphemerisBatch()
+{
+}
+
+
+void EphemerisBatch::clear()
+{
+   prn.clear();
+   week.clear();     tocWeek.clear();
+   toe.clear();      toc.clear();
+   A.clear();        n.clear();        sqrtA.clear();
+   e.clear();        sqrt1me2.clear(); M0.clear();
+   omega0.clear();   omegaDotRel.clear(); omegaToe.clear();
+   i0.clear();       idot.clear();     omega.clear();
+   cuc.clear();      cus.clear();      crc.clear();
+   crs.clear();      cic.clear();      cis.clear();
+   af0.clear();      af1.clear();      af2.clear();   tgd.clear();
+   tk.clear();       tc.clear();
+}
+
+
+size_t EphemerisBatch::add( const GpsEphemeris &eph )
+{
+   double a = eph.sqrtA * eph.sqrtA;
+
+   prn.push_back(eph.prn);
+   week.push_back(eph.week);
+   tocWeek.push_back(eph.tocWeek);
+   toe.push_back(eph.toe);
+   toc.push_back(eph.toc);
+   A.push_back(a);
+   n.push_back(sqrt(GM / (a * a * a)) + eph.deltaN);
+   sqrtA.push_back(eph.sqrtA);
+   e.push_back(eph.e);
+   sqrt1me2.push_back(sqrt(1.0 - eph.e * eph.e));
+   M0.push_back(eph.M0);
+   omega0.push_back(eph.omega0);
+   omegaDotRel.push_back(eph.omegaDot - OMEGAE);
+   omegaToe.push_back(OMEGAE * eph.toe);
+   i0.push_back(eph.i0);
+   idot.push_back(eph.idot);
+   omega.push_back(eph.omega);
+   cuc.push_back(eph.cuc);
+   cus.push_back(eph.cus);
+   crc.push_back(eph.crc);
+   crs.push_back(eph.crs);
+   cic.push_back(eph.cic);
+   cis.push_back(eph.cis);
+   af0.push_back(eph.af0);
+   af1.push_back(eph.af1);
+   af2.push_back(eph.af2);
+   tgd.push_back(eph.tgd);
+   tk.push_back(0.0);
+   tc.push_back(0.0);
+
+   return prn.size() - 1;
+}
+
+
+void EphemerisBatch::setTime( size_t i, long gpsWeek, double secsOfWeek )
+{
+   tk[i] = static_cast<double>(gpsWeek - week[i]) * SECSPERWEEK + (secsOfWeek - toe[i]);
+   tc[i] = static_cast<double>(gpsWeek - tocWeek[i]) * SECSPERWEEK + (secsOfWeek - toc[i]);
+}
+
+
+BATCH_KERNEL void EphemerisBatch::evaluate()
+{
+   const size_t count = prn.size();
+   x.resize(count);
+   y.resize(count);
+   z.resize(count);
+   vx.resize(count);        vy.resize(count);        vz.resize(count);
+   clockBias.resize(count);
+   E.resize(count);
+   sinE.resize(count);      cosE.resize(count);
+   phi.resize(count);       sin2phi.resize(count);   cos2phi.resize(count);
+   u.resize(count);         sinu.resize(count);      cosu.resize(count);
+   r.resize(count);
+   inc.resize(count);       sini.resize(count);      cosi.resize(count);
+   Omega.resize(count);     sinOmega.resize(count);  cosOmega.resize(count);
+   nuDot.resize(count);     uDot.resize(count);      rDot.resize(count);
+   iDot.resize(count);      xpDot.resize(count);     ypDot.resize(count);
+
+   // plain pointers, so that the loops below do not reload the vectors'
+   // data pointers on every iteration
+   const double *pA = A.data(), *pn = n.data(), *psqrtA = sqrtA.data();
+   const double *pe = e.data(), *psqrt1me2 = sqrt1me2.data(), *pM0 = M0.data();
+   const double *pomega0 = omega0.data(), *pomegaDotRel = omegaDotRel.data();
+   const double *pomegaToe = omegaToe.data(), *pi0 = i0.data(), *pidot = idot.data();
+   const double *pomega = omega.data();
+   const double *pcuc = cuc.data(), *pcus = cus.data(), *pcrc = crc.data();
+   const double *pcrs = crs.data(), *pcic = cic.data(), *pcis = cis.data();
+   const double *paf0 = af0.data(), *paf1 = af1.data(), *paf2 = af2.data();
+   const double *ptgd = tgd.data(), *ptk = tk.data(), *ptc = tc.data();
+   double *pE = E.data(), *psinE = sinE.data(), *pcosE = cosE.data();
+   double *pphi = phi.data(), *psin2phi = sin2phi.data(), *pcos2phi = cos2phi.data();
+   double *pu = u.data(), *psinu = sinu.data(), *pcosu = cosu.data(), *pr = r.data();
+   double *pinc = inc.data(), *psini = sini.data(), *pcosi = cosi.data();
+   double *pOmega = Omega.data(), *psinOmega = sinOmega.data(), *pcosOmega = cosOmega.data();
+   double *px = x.data(), *py = y.data(), *pz = z.data();
+   double *pvx = vx.data(), *pvy = vy.data(), *pvz = vz.data();
+   double *pnuDot = nuDot.data(), *puDot = uDot.data(), *prDot = rDot.data();
+   double *piDot = iDot.data(), *pxpDot = xpDot.data(), *pypDot = ypDot.data();
+   double *pclockBias = clockBias.data();
+
+   // mean anomaly, then Kepler's equation with the same number of Newton
+   // steps for every satellite
+   for (size_t i = 0; i < count; ++i)
+      pE[i] = pM0[i] + pn[i] * ptk[i];
+   for (int iter = 0; iter < KEPLERITERATIONS; ++iter)
+   {
+      sinColumn(pE, psinE, count);
+      cosColumn(pE, pcosE, count);
+      for (size_t i = 0; i < count; ++i)
+      {
+         double M = pM0[i] + pn[i] * ptk[i];
+         pE[i] += (M - pE[i] + pe[i] * psinE[i]) / (1.0 - pe[i] * pcosE[i]);
+      }
+   }
+   sinColumn(pE, psinE, count);
+   cosColumn(pE, pcosE, count);
+
+   // argument of latitude
+   for (size_t i = 0; i < count; ++i)
+      pphi[i] = atan2(psqrt1me2[i] * psinE[i], pcosE[i] - pe[i]) + pomega[i];
+   for (size_t i = 0; i < count; ++i)
+      pu[i] = 2.0 * pphi[i];
+   sinColumn(pu, psin2phi, count);
+   cosColumn(pu, pcos2phi, count);
+
+   // harmonic corrections
+   for (size_t i = 0; i < count; ++i)
+   {
+      pu[i] = pphi[i] + pcus[i] * psin2phi[i] + pcuc[i] * pcos2phi[i];
+      pr[i] = pA[i] * (1.0 - pe[i] * pcosE[i]) + pcrs[i] * psin2phi[i] + pcrc[i] * pcos2phi[i];
+      pinc[i] = pi0[i] + pidot[i] * ptk[i] + pcis[i] * psin2phi[i] + pcic[i] * pcos2phi[i];
+      pOmega[i] = pomega0[i] + pomegaDotRel[i] * ptk[i] - pomegaToe[i];
+   }
+   sinColumn(pu, psinu, count);
+   cosColumn(pu, pcosu, count);
+   sinColumn(pinc, psini, count);
+   cosColumn(pinc, pcosi, count);
+   sinColumn(pOmega, psinOmega, count);
+   cosColumn(pOmega, pcosOmega, count);
+
+   // position in the orbital plane (r cos u, r sin u), then in ECEF; one
+   // output per loop keeps the aliasing checks few enough to vectorize
+   for (size_t i = 0; i < count; ++i)
+      px[i] = pr[i] * (pcosu[i] * pcosOmega[i] - psinu[i] * pcosi[i] * psinOmega[i]);
+   for (size_t i = 0; i < count; ++i)
+      py[i] = pr[i] * (pcosu[i] * psinOmega[i] + psinu[i] * pcosi[i] * pcosOmega[i]);
+   for (size_t i = 0; i < count; ++i)
+      pz[i] = pr[i] * psinu[i] * psini[i];
+
+   // velocity: the rates of the true anomaly and of the corrected argument
+   // of latitude, radius and inclination, then the derivative of the above
+   for (size_t i = 0; i < count; ++i)
+   {
+      double d = 1.0 - pe[i] * pcosE[i];
+      pnuDot[i] = pn[i] * psqrt1me2[i] / (d * d);
+   }
+   for (size_t i = 0; i < count; ++i)
+      puDot[i] = pnuDot[i] * (1.0 + 2.0 * (pcus[i] * pcos2phi[i] - pcuc[i] * psin2phi[i]));
+   for (size_t i = 0; i < count; ++i)
+      prDot[i] = pA[i] * pe[i] * psinE[i] * pn[i] / (1.0 - pe[i] * pcosE[i])
+               + 2.0 * pnuDot[i] * (pcrs[i] * pcos2phi[i] - pcrc[i] * psin2phi[i]);
+   for (size_t i = 0; i < count; ++i)
+      piDot[i] = pidot[i] + 2.0 * pnuDot[i] * (pcis[i] * pcos2phi[i] - pcic[i] * psin2phi[i]);
+   for (size_t i = 0; i < count; ++i)
+      pxpDot[i] = prDot[i] * pcosu[i] - pr[i] * psinu[i] * puDot[i];
+   for (size_t i = 0; i < count; ++i)
+      pypDot[i] = prDot[i] * psinu[i] + pr[i] * pcosu[i] * puDot[i];
+   for (size_t i = 0; i < count; ++i)
+      pvx[i] = pxpDot[i] * pcosOmega[i] - pypDot[i] * pcosi[i] * psinOmega[i]
+             + pr[i] * psinu[i] * psini[i] * piDot[i] * psinOmega[i]
+             - pomegaDotRel[i] * py[i];
+   for (size_t i = 0; i < count; ++i)
+      pvy[i] = pxpDot[i] * psinOmega[i] + pypDot[i] * pcosi[i] * pcosOmega[i]
+             - pr[i] * psinu[i] * psini[i] * piDot[i] * pcosOmega[i]
+             + pomegaDotRel[i] * px[i];
+   for (size_t i = 0; i < count; ++i)
+      pvz[i] = pypDot[i] * psini[i] + pr[i] * psinu[i] * pcosi[i] * piDot[i];
+
+   // SV clock polynomial plus relativity, minus TGD
+   for (size_t i = 0; i < count; ++i)
+      pclockBias[i] = paf0[i] + (paf1[i] + paf2[i] * ptc[i]) * ptc[i]
+                    + F * pe[i] * psqrtA[i] * psinE[i] - ptgd[i];
+}
@@ -0,0 +1,84 @@
+// Summary:
+//    Batched broadcast orbit evaluation.  The ephemerides of all satellites of
+//    an epoch are gathered into structure-of-arrays columns and evaluated
+//    together: each step of the IS-GPS-200 algorithm (Kepler's equation, the
+//    harmonic corrections, the rotation to ECEF, its time derivative and the
+//    clock polynomial) runs as branch-free loops over the satellites, with a
+//    fixed number of Newton iterations for the eccentric anomaly, so that the
+//    compiler can vectorize them (with vector sin/cos from the C library
+//    where it has them, e.g. glibc's libmvec).  The build compiles this file
+//    with -O3 -ffast-math in every build type, and on x86-64 the kernels are
+//    cloned for AVX-512 and AVX2 and picked for the CPU at load time.
+
+#ifndef EphemerisBatch_H
+#define EphemerisBatch_H
+
+#include <vector>
+
+#include "EphemerisStore.h"
+
+class EphemerisBatch
+{
+   public:
+      EphemerisBatch();
+
+      //**
+      // Summary:
+      //    Remove all satellites, keeping the allocated columns.
+      void clear();
+
+      //**
+      // Summary:
+      //    Append the ephemeris of one satellite.
+      //
+      // Returns:
+      //    The index of the satellite in the batch.
+      size_t add( const GpsEphemeris &ephemeris );
+
+      //**
+      // Summary:
+      //    Set the GPS system time at which a satellite is evaluated.  Each
+      //    satellite has its own time, e.g. its signal transmission time.
+      void setTime( size_t i, long gpsWeek, double secsOfWeek );
+
+      //**
+      // Summary:
+      //    Evaluate the orbit, velocity and SV clock of every satellite at
+      //    its time.
+      //    The results agree with EphemerisStore::evaluate().
+      void evaluate();
+
+      size_t size() const { return prn.size(); }
+
+      const int    *getPRNs() const { return prn.data(); }
+      const double *getX() const { return x.data(); }
+      const double *getY() const { return y.data(); }
+      const double *getZ() const { return z.data(); }
+      const double *getVX() const { return vx.data(); }
+      const double *getVY() const { return vy.data(); }
+      const double *getVZ() const { return vz.data(); }
+      const double *getClockBias() const { return clockBias.data(); }
+
+   private:
+      // ephemeris columns, with the per-satellite constants precomputed
+      std::vector<int>      prn;
+      std::vector<long>     week, tocWeek;
+      std::vector<double>   toe, toc;
+      std::vector<double>   A, n, sqrtA, e, sqrt1me2, M0;
+      std::vector<double>   omega0, omegaDotRel, omegaToe, i0, idot, omega;
+      std::vector<double>   cuc, cus, crc, crs, cic, cis;
+      std::vector<double>   af0, af1, af2, tgd;
+
+      // evaluation times: seconds from toe and from toc
+      std::vector<double>   tk, tc;
+
+      // results
+      std::vector<double>   x, y, z, vx, vy, vz, clockBias;
+
+      // intermediate columns
+      std::vector<double>   E, sinE, cosE, phi, sin2phi, cos2phi;
+      std::vector<double>   u, sinu, cosu, r, inc, sini, cosi, Omega, sinOmega, cosOmega;
+      std::vector<double>   nuDot, uDot, rDot, iDot, xpDot, ypDot;
+};
+
+#endif //EphemerisBatch_H
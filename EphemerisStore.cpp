@@ -0,0 +1,368 @@
+// Summary:
+//    Contains the implementation of the EphemerisStore class.
+
+#include "EphemerisStore.h"
+#include "EphemerisBatch.h"
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cmath>
+
+#include "rinex.h"
+#include "NRinexUtils.h"
+
+namespace
+{
+   // IS-GPS-200 constants
+   const double GM = 3.986005e14;              // m^3/s^2
+   const double OMEGAE = 7.2921151467e-5;      // rad/s
+   const double F = -4.442807633e-10;          // s/m^(1/2)
+   const double C = 299792458.0;               // m/s
+   const double SECSPERWEEK = 604800.0;
+
+   // seconds from (week1, sow1) to (week2, sow2), kept apart so that the
+   // difference does not lose the sub-microsecond part of the time
+   double timeDiff( long week2, double sow2, long week1, double sow1 )
+   {
+      return static_cast<double>(week2 - week1) * SECSPERWEEK + (sow2 - sow1);
+   }
+
+   bool earlier( const GpsEphemeris &a, const GpsEphemeris &b )
+   {
+      if (a.week != b.week) return a.week < b.week;
+      if (a.toe != b.toe) return a.toe < b.toe;
+      if (a.transmitTime != b.transmitTime) return a.transmitTime < b.transmitTime;
+      return a.iode < b.iode;
+   }
+}
+
+//========================== EphemerisStore Class =============================
+
+EphemerisStore::EphemerisStore()
+{
+   maxAge = 4.0 * 3600.0;
+}
+
+
+bool EphemerisStore::load( const std::string& filename )
+{
+   NGSrinex::RinexNavFile navFile;
+   if (!NRinexUtils::OpenRinexNavigationFileForInput(navFile, filename))
+   {
+      std::cerr << "Error opening navigation file: " << filename << "\n";
+      return false;
+   }
+
+   NGSrinex::PRNBlock block;
+   GpsEphemeris ephemeris;
+   try
+   {
+      while (navFile.readPRNBlock(block) != 0)
+      {
+         fromPRNBlock(block, ephemeris);
+         add(ephemeris);
+      }
+   }
+   catch (NGSrinex::RinexReadingException &readingExcep)
+   {
+      std::cerr << "Error reading navigation file: " << filename << "\n"
+                << readingExcep.getMessage() << "\n";
+      return false;
+   }
+
+   return true;
+}
+
+
+void EphemerisStore::fromPRNBlock( NGSrinex::PRNBlock &block, GpsEphemeris &ephemeris )
+{
+   NGSdatetime::DateTime toc;
+   toc.SetYMDHMS(block.getTocYear(), block.getTocMonth(), block.getTocDay(),
+                 block.getTocHour(), block.getTocMin(), block.getTocSec());
+   NGSdatetime::GPSTime tocGPS = toc.GetGPSTime();
+
+   ephemeris.prn = block.getSatellitePRN();
+   ephemeris.week = static_cast<long>(block.getToeGPSWeek());
+   ephemeris.toe = block.getToe();
+   ephemeris.tocWeek = tocGPS.GPSWeek;
+   ephemeris.toc = tocGPS.secsOfWeek;
+   ephemeris.af0 = block.getClockBias();
+   ephemeris.af1 = block.getClockDrift();
+   ephemeris.af2 = block.getClockDriftRate();
+   ephemeris.tgd = block.getTgd();
+   ephemeris.iode = block.getIode();
+   ephemeris.iodc = block.getIodc();
+   ephemeris.transmitTime = block.getTransmTime();
+   ephemeris.health = block.getSvHealth();
+   ephemeris.sqrtA = block.getSqrtA();
+   ephemeris.e = block.getEccen();
+   ephemeris.M0 = block.getMo();
+   ephemeris.deltaN = block.getDeltan();
+   ephemeris.omega0 = block.getBigOmega();
+   ephemeris.omegaDot = block.getBigOmegaDot();
+   ephemeris.i0 = block.getIo();
+   ephemeris.idot = block.getIdot();
+   ephemeris.omega = block.getLilOmega();
+   ephemeris.cuc = block.getCuc();
+   ephemeris.cus = block.getCus();
+   ephemeris.crc = block.getCrc();
+   ephemeris.crs = block.getCrs();
+   ephemeris.cic = block.getCic();
+   ephemeris.cis = block.getCis();
+}
+
+
+void EphemerisStore::add( const GpsEphemeris &ephemeris )
+{
+   if (ephemeris.prn <= 0)
+      return;
+   if (tables.size() <= static_cast<size_t>(ephemeris.prn))
+      tables.resize(ephemeris.prn + 1);
+
+   std::vector<GpsEphemeris> &table = tables[ephemeris.prn];
+   auto it = std::upper_bound(table.begin(), table.end(), ephemeris, earlier);
+
+   // merged navigation files repeat the same ephemeris many times
+   if (it != table.begin())
+   {
+      const GpsEphemeris &previous = *(it - 1);
+      if (previous.week == ephemeris.week && previous.toe == ephemeris.toe &&
+          previous.iode == ephemeris.iode && previous.af0 == ephemeris.af0)
+         return;
+   }
+   table.insert(it, ephemeris);
+}
+
+
+const GpsEphemeris* EphemerisStore::select( int prn, long gpsWeek, double secsOfWeek ) const
+{
+   if (prn <= 0 || static_cast<size_t>(prn) >= tables.size())
+      return nullptr;
+
+   const std::vector<GpsEphemeris> &table = tables[prn];
+   const GpsEphemeris *best = nullptr;
+   double bestAge = 0.0;
+
+   // the table is sorted by toe: start at the first one within maxAge
+   GpsEphemeris key;
+   key.week = gpsWeek;
+   key.toe = secsOfWeek - maxAge;
+   while (key.toe < 0.0)
+   {
+      key.week--;
+      key.toe += SECSPERWEEK;
+   }
+   key.transmitTime = -SECSPERWEEK;
+   key.iode = -1.0;
+   auto it = std::lower_bound(table.begin(), table.end(), key, earlier);
+
+   for (; it != table.end(); ++it)
+   {
+      double age = timeDiff(gpsWeek, secsOfWeek, it->week, it->toe);
+      if (age < -maxAge)
+         break;
+      if (it->health != 0.0 || fabs(age) > maxAge)
+         continue;
+
+      // later entries with the same toe were sent later, so '<=' keeps them
+      if (best == nullptr || fabs(age) <= bestAge)
+      {
+         best = &*it;
+         bestAge = fabs(age);
+      }
+   }
+
+   return best;
+}
+
+
+void EphemerisStore::evaluate( const GpsEphemeris &eph, long gpsWeek,
+                               double secsOfWeek, SatelliteState &state )
+{
+   double tk = timeDiff(gpsWeek, secsOfWeek, eph.week, eph.toe);
+
+   // mean motion and mean anomaly
+   double A = eph.sqrtA * eph.sqrtA;
+   double n = sqrt(GM / (A * A * A)) + eph.deltaN;
+   double M = eph.M0 + n * tk;
+
+   // Kepler's equation for the eccentric anomaly
+   double E = M;
+   for (int i = 0; i < 10; ++i)
+   {
+      double dE = (M - E + eph.e * sin(E)) / (1.0 - eph.e * cos(E));
+      E += dE;
+      if (fabs(dE) < 1e-14)
+         break;
+   }
+   double sinE = sin(E);
+   double cosE = cos(E);
+
+   // argument of latitude, radius and inclination with harmonic corrections
+   double nu = atan2(sqrt(1.0 - eph.e * eph.e) * sinE, cosE - eph.e);
+   double phi = nu + eph.omega;
+   double sin2phi = sin(2.0 * phi);
+   double cos2phi = cos(2.0 * phi);
+   double u = phi + eph.cus * sin2phi + eph.cuc * cos2phi;
+   double r = A * (1.0 - eph.e * cosE) + eph.crs * sin2phi + eph.crc * cos2phi;
+   double i = eph.i0 + eph.idot * tk + eph.cis * sin2phi + eph.cic * cos2phi;
+
+   // position in the orbital plane, then in ECEF
+   double xp = r * cos(u);
+   double yp = r * sin(u);
+   double Omega = eph.omega0 + (eph.omegaDot - OMEGAE) * tk - OMEGAE * eph.toe;
+   double sinOmega = sin(Omega);
+   double cosOmega = cos(Omega);
+   double cosi = cos(i);
+
+   double sini = sin(i);
+   state.x = xp * cosOmega - yp * cosi * sinOmega;
+   state.y = xp * sinOmega + yp * cosi * cosOmega;
+   state.z = yp * sini;
+
+   // velocity: the time derivatives of the above
+   double EDot = n / (1.0 - eph.e * cosE);
+   double nuDot = EDot * sqrt(1.0 - eph.e * eph.e) / (1.0 - eph.e * cosE);
+   double uDot = nuDot * (1.0 + 2.0 * (eph.cus * cos2phi - eph.cuc * sin2phi));
+   double rDot = A * eph.e * sinE * EDot + 2.0 * nuDot * (eph.crs * cos2phi - eph.crc * sin2phi);
+   double iDot = eph.idot + 2.0 * nuDot * (eph.cis * cos2phi - eph.cic * sin2phi);
+   double OmegaDot = eph.omegaDot - OMEGAE;
+   double xpDot = rDot * cos(u) - yp * uDot;
+   double ypDot = rDot * sin(u) + xp * uDot;
+
+   state.vx = xpDot * cosOmega - ypDot * cosi * sinOmega + yp * sini * iDot * sinOmega
+            - OmegaDot * state.y;
+   state.vy = xpDot * sinOmega + ypDot * cosi * cosOmega - yp * sini * iDot * cosOmega
+            + OmegaDot * state.x;
+   state.vz = ypDot * sini + yp * cosi * iDot;
+
+   // SV clock polynomial plus relativity; TGD for an L1 C/A user
+   double dt = timeDiff(gpsWeek, secsOfWeek, eph.tocWeek, eph.toc);
+   state.relativistic = F * eph.e * eph.sqrtA * sinE;
+   state.clockBias = eph.af0 + eph.af1 * dt + eph.af2 * dt * dt
+                   + state.relativistic - eph.tgd;
+}
+
+
+bool EphemerisStore::computeSatellite( int prn, long gpsWeek, double secsOfWeek,
+                                       double pseudorange, SatelliteData &satellite ) const
+{
+   const GpsEphemeris *eph = select(prn, gpsWeek, secsOfWeek);
+   if (!eph)
+      return false;
+
+   // transmit time by SV time, then corrected to GPS system time
+   SatelliteState state;
+   double travel = pseudorange / C;
+   evaluate(*eph, gpsWeek, secsOfWeek - travel, state);
+   travel += state.clockBias;
+   evaluate(*eph, gpsWeek, secsOfWeek - travel, state);
+
+   toSatelliteData(prn, 'G', state, travel, satellite);
+   return true;
+}
+
+
+void EphemerisStore::toSatelliteData( int prn, char system, const SatelliteState &state,
+                                      double travel, SatelliteData &satellite )
+{
+   // rotate the transmit-time position into the receive-time ECEF frame
+   double theta = OMEGAE * travel;
+   double sinTheta = sin(theta);
+   double cosTheta = cos(theta);
+
+   satellite.prn = prn;
+   satellite.system = system;
+   satellite.x = state.x * cosTheta + state.y * sinTheta;
+   satellite.y = -state.x * sinTheta + state.y * cosTheta;
+   satellite.z = state.z;
+   satellite.vx = state.vx * cosTheta + state.vy * sinTheta;
+   satellite.vy = -state.vx * sinTheta + state.vy * cosTheta;
+   satellite.vz = state.vz;
+   satellite.correction = -C * state.clockBias;
+}
+
+
+void EphemerisStore::computeSatellites( const int *prns, const double *pseudoranges,
+                                        size_t count, long gpsWeek, double secsOfWeek,
+                                        EphemerisBatch &batch,
+                                        std::vector<SatelliteData> &satellites,
+                                        std::vector<double> &ranges ) const
+{
+   batch.clear();
+   ranges.clear();
+   satellites.clear();
+   for (size_t i = 0; i < count; ++i)
+   {
+      const GpsEphemeris *eph = select(prns[i], gpsWeek, secsOfWeek);
+      if (!eph)
+         continue;
+      batch.add(*eph);
+      ranges.push_back(pseudoranges[i]);
+   }
+
+   // the same two-pass transmit time as computeSatellite()
+   const size_t numSats = batch.size();
+   for (size_t i = 0; i < numSats; ++i)
+      batch.setTime(i, gpsWeek, secsOfWeek - ranges[i] / C);
+   batch.evaluate();
+   for (size_t i = 0; i < numSats; ++i)
+      batch.setTime(i, gpsWeek, secsOfWeek - (ranges[i] / C + batch.getClockBias()[i]));
+   batch.evaluate();
+
+   satellites.resize(numSats);
+   SatelliteState state;
+   for (size_t i = 0; i < numSats; ++i)
+   {
+      state.x = batch.getX()[i];
+      state.y = batch.getY()[i];
+      state.z = batch.getZ()[i];
+      state.vx = batch.getVX()[i];
+      state.vy = batch.getVY()[i];
+      state.vz = batch.getVZ()[i];
+      state.clockBias = batch.getClockBias()[i];
+      toSatelliteData(batch.getPRNs()[i], 'G', state, ranges[i] / C + state.clockBias, satellites[i]);
+   }
+}
+
+
+bool EphemerisStore::isNavigationFile( const std::string& filename )
+{
+   std::ifstream file(filename);
+   std::string line;
+   if (!std::getline(file, line))
+      return false;
+
+   // RINEX 2: "N" in column 21 of RINEX VERSION / TYPE
+   return line.length() > 20 && line[20] == 'N' &&
+          line.find("RINEX VERSION / TYPE") != std::string::npos;
+}
+
+
+const std::vector<GpsEphemeris>& EphemerisStore::getEphemerides( int prn ) const
+{
+   static const std::vector<GpsEphemeris> none;
+   if (prn <= 0 || static_cast<size_t>(prn) >= tables.size())
+      return none;
+   return tables[prn];
+}
+
+
+size_t EphemerisStore::getNumEphemerides() const
+{
+   size_t count = 0;
+   for (size_t i = 0; i < tables.size(); ++i)
+      count += tables[i].size();
+   return count;
+}
+
+
+size_t EphemerisStore::getNumSatellites() const
+{
+   size_t count = 0;
+   for (size_t i = 0; i < tables.size(); ++i)
+      if (!tables[i].empty())
+         count++;
+   return count;
+}
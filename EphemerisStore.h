@@ -0,0 +1,169 @@
+// Summary:
+//    GPS broadcast ephemerides read from RINEX navigation files.  Every
+//    PRNBlock is kept in a per-PRN table sorted by time of ephemeris, and the
+//    satellite position and clock correction for an observation are computed
+//    from the IS-GPS-200 user algorithms (sections 20.3.3.3.3 and 20.3.3.4.3)
+//    at the signal transmission time.  This replaces the precomputed
+//    satpos.txt when a navigation file is available.
+
+#ifndef EphemerisStore_H
+#define EphemerisStore_H
+
+#include <string>
+#include <vector>
+
+#include "SatPosStore.h"
+
+namespace NGSrinex { class PRNBlock; }
+class EphemerisBatch;
+
+// One broadcast ephemeris (subframes 1-3) in SI units
+struct GpsEphemeris
+{
+   int prn;
+   long week;                     // GPS week of toe (continuous, not mod 1024)
+   double toe;                    // time of ephemeris (s of week)
+   long tocWeek;
+   double toc;                    // time of clock (s of week)
+   double af0, af1, af2;          // SV clock polynomial (s, s/s, s/s^2)
+   double tgd;                    // L1-L2 group delay (s)
+   double iode, iodc;
+   double transmitTime;           // s of week the ephemeris was sent
+   double health;
+   double sqrtA, e, M0, deltaN;
+   double omega0, omegaDot, i0, idot, omega;
+   double cuc, cus, crc, crs, cic, cis;
+};
+
+// Satellite position and clock at one instant
+struct SatelliteState
+{
+   double x, y, z;                // ECEF at the evaluation time (m)
+   double vx, vy, vz;             // ECEF velocity (m/s)
+   double clockBias;              // SV clock offset incl. relativity, minus TGD (s)
+   double relativistic;           // relativistic part of clockBias (s)
+};
+
+class EphemerisStore
+{
+   public:
+      enum { MAXPRN = 32 };
+
+      EphemerisStore();
+
+      //**
+      // Summary:
+      //    Add the ephemerides of a RINEX GPS navigation file to the store.
+      //    May be called for several files; duplicates are dropped.
+      //
+      // Arguments:
+      //    filename - The name of the file.
+      //
+      // Returns:
+      //    True if successful and false otherwise.
+      bool load( const std::string& filename );
+
+      //**
+      // Summary:
+      //    Add one ephemeris, keeping its PRN's table sorted.
+      void add( const GpsEphemeris &ephemeris );
+
+      //**
+      // Summary:
+      //    Set the largest |t - toe| for which an ephemeris is used.  The
+      //    default of 4 hours is the normal curve fit interval.
+      void setMaxAge( double seconds ) { maxAge = seconds; }
+
+      //**
+      // Summary:
+      //    Find the healthy ephemeris with toe closest to the given time.  Of
+      //    ephemerides with the same toe the one sent last (then the higher
+      //    IODE) wins, so an upload that changed the IODE replaces the old one.
+      //
+      // Returns:
+      //    A pointer into the store, or nullptr if no ephemeris is in range.
+      const GpsEphemeris* select( int prn, long gpsWeek, double secsOfWeek ) const;
+
+      //**
+      // Summary:
+      //    Evaluate the orbit and the SV clock of an ephemeris.
+      //
+      // Arguments:
+      //    ephemeris - The ephemeris.
+      //    gpsWeek, secsOfWeek - GPS system time of evaluation.
+      //    state - Receives the position, velocity and clock.
+      static void evaluate( const GpsEphemeris &ephemeris, long gpsWeek,
+                            double secsOfWeek, SatelliteState &state );
+
+      //**
+      // Summary:
+      //    Compute the satellite position and pseudorange correction for a
+      //    pseudorange observed at the given receive time.  The position is at
+      //    transmission time, rotated into the ECEF frame of the receive time.
+      //
+      // Arguments:
+      //    prn - Satellite PRN.
+      //    gpsWeek, secsOfWeek - Receive time.
+      //    pseudorange - Observed pseudorange (m), to find the transmit time.
+      //    satellite - Receives the position and the correction, which uses
+      //                the satpos.txt convention: pseudorange - correction is
+      //                the range plus the receiver clock (correction = -c*dt).
+      //
+      // Returns:
+      //    True if an ephemeris was available.
+      bool computeSatellite( int prn, long gpsWeek, double secsOfWeek,
+                             double pseudorange, SatelliteData &satellite ) const;
+
+      //**
+      // Summary:
+      //    Turn a satellite state at transmission time into the position and
+      //    velocity in the receive-time ECEF frame and the pseudorange
+      //    correction.
+      //
+      // Arguments:
+      //    prn - Satellite PRN (or GLONASS slot).
+      //    system - RINEX satellite system code.
+      //    state - Position, velocity and clock at transmission time.
+      //    travel - Signal travel time (s), for the Earth rotation correction.
+      //    satellite - Receives the result.
+      static void toSatelliteData( int prn, char system, const SatelliteState &state,
+                                   double travel, SatelliteData &satellite );
+
+      //**
+      // Summary:
+      //    computeSatellite() for all satellites of an epoch at once, using
+      //    the vectorizable EphemerisBatch evaluator.
+      //
+      // Arguments:
+      //    prns, pseudoranges, count - The observed satellites.
+      //    gpsWeek, secsOfWeek - Receive time.
+      //    batch - Scratch space, reused from epoch to epoch.
+      //    satellites - Receives the satellites that have an ephemeris.
+      //    ranges - Receives their pseudoranges, in the same order.
+      void computeSatellites( const int *prns, const double *pseudoranges, size_t count,
+                              long gpsWeek, double secsOfWeek, EphemerisBatch &batch,
+                              std::vector<SatelliteData> &satellites,
+                              std::vector<double> &ranges ) const;
+
+      //**
+      // Summary:
+      //    Check the RINEX VERSION / TYPE record of a file for a GPS
+      //    navigation file.
+      static bool isNavigationFile( const std::string& filename );
+
+      //**
+      // Summary:
+      //    The ephemerides of one PRN, sorted by toe (empty if none).
+      const std::vector<GpsEphemeris>& getEphemerides( int prn ) const;
+
+      size_t getNumEphemerides() const;
+      size_t getNumSatellites() const;
+
+      static void fromPRNBlock( NGSrinex::PRNBlock &block, GpsEphemeris &ephemeris );
+
+   private:
+      std::vector< std::vector<GpsEphemeris> >   tables;   // indexed by PRN
+      double                                     maxAge;
+};
+
+#endif //EphemerisStore_H
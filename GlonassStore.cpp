@@ -0,0 +1,367 @@
+// Summary:
+//    Contains the implementation of the GlonassStore class.
+
+#include "GlonassStore.h"
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cmath>
+
+#include "rinex.h"
+#include "NRinexUtils.h"
+
+namespace
+{
+   // GLONASS ICD (PZ-90) constants
+   const double MU = 398600.4418e9;            // m^3/s^2
+   const double AE = 6378136.0;                // m
+   const double J2 = 1.0826257e-3;
+   const double OMEGAE = 7.292115e-5;          // rad/s
+   const double C = 299792458.0;               // m/s
+   const double SECSPERWEEK = 604800.0;
+
+   // the ICD's integration step; Runge-Kutta 4 at 60 s is accurate to
+   // millimetres over the 15 minute validity of an ephemeris
+   const double STEPSECS = 60.0;
+
+   // files without a LEAP SECONDS record (valid since 2017-01-01)
+   const long DEFAULTLEAPSECONDS = 18;
+
+   double timeDiff( long week2, double sow2, long week1, double sow1 )
+   {
+      return static_cast<double>(week2 - week1) * SECSPERWEEK + (sow2 - sow1);
+   }
+
+   bool earlier( const GlonassEphemeris &a, const GlonassEphemeris &b )
+   {
+      if (a.week != b.week) return a.week < b.week;
+      if (a.tb != b.tb) return a.tb < b.tb;
+      return a.frameTime < b.frameTime;
+   }
+
+   // Equations of motion in the Earth-fixed frame: central body, J2,
+   // centrifugal and Coriolis terms, plus the broadcast luni-solar term
+   void derivatives( const double pos[3], const double vel[3], const double acc[3],
+                     double dpos[3], double dvel[3] )
+   {
+      double r2 = pos[0] * pos[0] + pos[1] * pos[1] + pos[2] * pos[2];
+      double r3 = r2 * sqrt(r2);
+      double a = 1.5 * J2 * MU * AE * AE / (r2 * r3);
+      double b = 5.0 * pos[2] * pos[2] / r2;
+      double c = -MU / r3 - a * (1.0 - b);
+      double omega2 = OMEGAE * OMEGAE;
+
+      dpos[0] = vel[0];
+      dpos[1] = vel[1];
+      dpos[2] = vel[2];
+      dvel[0] = (c + omega2) * pos[0] + 2.0 * OMEGAE * vel[1] + acc[0];
+      dvel[1] = (c + omega2) * pos[1] - 2.0 * OMEGAE * vel[0] + acc[1];
+      dvel[2] = (c - 2.0 * a) * pos[2] + acc[2];
+   }
+}
+
+//=========================== GlonassStore Class ==============================
+
+GlonassStore::GlonassStore()
+{
+   maxAge = 15.0 * 60.0;
+   numSteps = 0;
+}
+
+
+bool GlonassStore::load( const std::string& filename )
+{
+   NGSrinex::GlonassNavFile navFile;
+   if (!NRinexUtils::OpenRinexGlonassNavigationFileForInput(navFile, filename))
+   {
+      std::cerr << "Error opening GLONASS navigation file: " << filename << "\n";
+      return false;
+   }
+
+   long leapSeconds = navFile.getLeapSec();
+   if (leapSeconds == 0)
+      leapSeconds = DEFAULTLEAPSECONDS;
+
+   NGSrinex::GlonassEphemEpoch epoch;
+   GlonassEphemeris ephemeris;
+   try
+   {
+      while (navFile.readEphemEpoch(epoch) != 0)
+      {
+         fromEphemEpoch(epoch, leapSeconds, ephemeris);
+         add(ephemeris);
+      }
+   }
+   catch (NGSrinex::RinexReadingException &readingExcep)
+   {
+      std::cerr << "Error reading GLONASS navigation file: " << filename << "\n"
+                << readingExcep.getMessage() << "\n";
+      return false;
+   }
+
+   return true;
+}
+
+
+void GlonassStore::fromEphemEpoch( NGSrinex::GlonassEphemEpoch &epoch, long leapSeconds,
+                                   GlonassEphemeris &ephemeris )
+{
+   // the epoch is UTC; GPS time is ahead by the leap seconds
+   NGSdatetime::DateTime tb;
+   tb.SetYMDHMS(epoch.getEpochYear(), epoch.getEpochMonth(), epoch.getEpochDay(),
+                epoch.getEpochHour(), epoch.getEpochMin(), epoch.getEpochSec());
+   NGSdatetime::GPSTime tbGPS = tb.GetGPSTime();
+
+   ephemeris.slot = epoch.getSatelliteAlmanacNumber();
+   ephemeris.frequencyNumber = static_cast<int>(epoch.getFreqNumber());
+   ephemeris.week = tbGPS.GPSWeek;
+   ephemeris.tb = tbGPS.secsOfWeek + static_cast<double>(leapSeconds);
+   if (ephemeris.tb >= SECSPERWEEK)
+   {
+      ephemeris.week++;
+      ephemeris.tb -= SECSPERWEEK;
+   }
+   ephemeris.clockBias = epoch.getSvClockBias();
+   ephemeris.relFreqBias = epoch.getSvRelFreqBias();
+   ephemeris.frameTime = epoch.getMessageFrameTime();
+   ephemeris.health = epoch.getSvHealth();
+
+   // the file is in km, km/s and km/s^2
+   ephemeris.pos[0] = epoch.getPosX() * 1000.0;
+   ephemeris.pos[1] = epoch.getPosY() * 1000.0;
+   ephemeris.pos[2] = epoch.getPosZ() * 1000.0;
+   ephemeris.vel[0] = epoch.getVelX() * 1000.0;
+   ephemeris.vel[1] = epoch.getVelY() * 1000.0;
+   ephemeris.vel[2] = epoch.getVelZ() * 1000.0;
+   ephemeris.acc[0] = epoch.getAccX() * 1000.0;
+   ephemeris.acc[1] = epoch.getAccY() * 1000.0;
+   ephemeris.acc[2] = epoch.getAccZ() * 1000.0;
+}
+
+
+void GlonassStore::add( const GlonassEphemeris &ephemeris )
+{
+   if (ephemeris.slot <= 0)
+      return;
+   if (tables.size() <= static_cast<size_t>(ephemeris.slot))
+      tables.resize(ephemeris.slot + 1);
+
+   std::vector<GlonassEphemeris> &table = tables[ephemeris.slot];
+   auto it = std::upper_bound(table.begin(), table.end(), ephemeris, earlier);
+
+   // merged navigation files repeat the same ephemeris many times
+   if (it != table.begin())
+   {
+      const GlonassEphemeris &previous = *(it - 1);
+      if (previous.week == ephemeris.week && previous.tb == ephemeris.tb &&
+          previous.pos[0] == ephemeris.pos[0] && previous.clockBias == ephemeris.clockBias)
+         return;
+   }
+
+   // the cached integrator states may point into this table
+   tracks.clear();
+   table.insert(it, ephemeris);
+}
+
+
+const GlonassEphemeris* GlonassStore::select( int slot, long gpsWeek, double secsOfWeek ) const
+{
+   if (slot <= 0 || static_cast<size_t>(slot) >= tables.size())
+      return nullptr;
+
+   const std::vector<GlonassEphemeris> &table = tables[slot];
+   const GlonassEphemeris *best = nullptr;
+   double bestAge = 0.0;
+
+   // the table is sorted by tb: start at the first one within maxAge
+   GlonassEphemeris key;
+   key.week = gpsWeek;
+   key.tb = secsOfWeek - maxAge;
+   while (key.tb < 0.0)
+   {
+      key.week--;
+      key.tb += SECSPERWEEK;
+   }
+   key.frameTime = -SECSPERWEEK;
+   auto it = std::lower_bound(table.begin(), table.end(), key, earlier);
+
+   for (; it != table.end(); ++it)
+   {
+      double age = timeDiff(gpsWeek, secsOfWeek, it->week, it->tb);
+      if (age < -maxAge)
+         break;
+      if (it->health != 0.0 || fabs(age) > maxAge)
+         continue;
+
+      // later entries with the same tb were sent later, so '<=' keeps them
+      if (best == nullptr || fabs(age) <= bestAge)
+      {
+         best = &*it;
+         bestAge = fabs(age);
+      }
+   }
+
+   return best;
+}
+
+
+// Runge-Kutta 4 from fromSecs to toSecs (seconds from tb) in steps of at most
+// STEPSECS.  Returns the number of steps taken.
+int GlonassStore::integrate( const GlonassEphemeris &eph, double fromSecs, double toSecs,
+                             double pos[3], double vel[3] )
+{
+   int steps = 0;
+   double t = fromSecs;
+   while (t != toSecs)
+   {
+      double h = toSecs - t;
+      if (h > STEPSECS)
+         h = STEPSECS;
+      else if (h < -STEPSECS)
+         h = -STEPSECS;
+
+      double k1p[3], k1v[3], k2p[3], k2v[3], k3p[3], k3v[3], k4p[3], k4v[3];
+      double p[3], v[3];
+      int i;
+
+      derivatives(pos, vel, eph.acc, k1p, k1v);
+      for (i = 0; i < 3; ++i)
+      {
+         p[i] = pos[i] + 0.5 * h * k1p[i];
+         v[i] = vel[i] + 0.5 * h * k1v[i];
+      }
+      derivatives(p, v, eph.acc, k2p, k2v);
+      for (i = 0; i < 3; ++i)
+      {
+         p[i] = pos[i] + 0.5 * h * k2p[i];
+         v[i] = vel[i] + 0.5 * h * k2v[i];
+      }
+      derivatives(p, v, eph.acc, k3p, k3v);
+      for (i = 0; i < 3; ++i)
+      {
+         p[i] = pos[i] + h * k3p[i];
+         v[i] = vel[i] + h * k3v[i];
+      }
+      derivatives(p, v, eph.acc, k4p, k4v);
+      for (i = 0; i < 3; ++i)
+      {
+         pos[i] += h / 6.0 * (k1p[i] + 2.0 * k2p[i] + 2.0 * k3p[i] + k4p[i]);
+         vel[i] += h / 6.0 * (k1v[i] + 2.0 * k2v[i] + 2.0 * k3v[i] + k4v[i]);
+      }
+
+      t = (h == toSecs - t) ? toSecs : t + h;
+      steps++;
+   }
+   return steps;
+}
+
+
+void GlonassStore::evaluate( const GlonassEphemeris &eph, long gpsWeek,
+                             double secsOfWeek, SatelliteState &state )
+{
+   double dt = timeDiff(gpsWeek, secsOfWeek, eph.week, eph.tb);
+   double pos[3] = { eph.pos[0], eph.pos[1], eph.pos[2] };
+   double vel[3] = { eph.vel[0], eph.vel[1], eph.vel[2] };
+   integrate(eph, 0.0, dt, pos, vel);
+
+   // the broadcast clock includes the relativistic effect
+   state.x = pos[0];
+   state.y = pos[1];
+   state.z = pos[2];
+   state.vx = vel[0];
+   state.vy = vel[1];
+   state.vz = vel[2];
+   state.relativistic = 0.0;
+   state.clockBias = eph.clockBias + eph.relFreqBias * dt;
+}
+
+
+bool GlonassStore::evaluate( int slot, long gpsWeek, double secsOfWeek, SatelliteState &state )
+{
+   const GlonassEphemeris *eph = select(slot, gpsWeek, secsOfWeek);
+   if (!eph)
+      return false;
+
+   if (tracks.size() <= static_cast<size_t>(slot))
+   {
+      Track empty;
+      empty.ephemeris = nullptr;
+      tracks.resize(slot + 1, empty);
+   }
+   Track &track = tracks[slot];
+
+   // restart from tb for a new ephemeris, or when tb is closer than the
+   // last integrated time
+   double dt = timeDiff(gpsWeek, secsOfWeek, eph->week, eph->tb);
+   if (track.ephemeris != eph || fabs(dt - track.t) > fabs(dt))
+   {
+      track.ephemeris = eph;
+      track.t = 0.0;
+      for (int i = 0; i < 3; ++i)
+      {
+         track.pos[i] = eph->pos[i];
+         track.vel[i] = eph->vel[i];
+      }
+   }
+   numSteps += integrate(*eph, track.t, dt, track.pos, track.vel);
+   track.t = dt;
+
+   state.x = track.pos[0];
+   state.y = track.pos[1];
+   state.z = track.pos[2];
+   state.vx = track.vel[0];
+   state.vy = track.vel[1];
+   state.vz = track.vel[2];
+   state.relativistic = 0.0;
+   state.clockBias = eph->clockBias + eph->relFreqBias * dt;
+   return true;
+}
+
+
+bool GlonassStore::computeSatellite( int slot, long gpsWeek, double secsOfWeek,
+                                     double pseudorange, SatelliteData &satellite )
+{
+   // transmit time by SV time, then corrected to system time
+   SatelliteState state;
+   double travel = pseudorange / C;
+   if (!evaluate(slot, gpsWeek, secsOfWeek - travel, state))
+      return false;
+   travel += state.clockBias;
+   evaluate(slot, gpsWeek, secsOfWeek - travel, state);
+
+   EphemerisStore::toSatelliteData(slot, 'R', state, travel, satellite);
+   return true;
+}
+
+
+bool GlonassStore::isNavigationFile( const std::string& filename )
+{
+   std::ifstream file(filename);
+   std::string line;
+   if (!std::getline(file, line))
+      return false;
+
+   // RINEX 2: "G" in column 21 of RINEX VERSION / TYPE
+   return line.length() > 20 && line[20] == 'G' &&
+          line.find("RINEX VERSION / TYPE") != std::string::npos;
+}
+
+
+size_t GlonassStore::getNumEphemerides() const
+{
+   size_t count = 0;
+   for (size_t i = 0; i < tables.size(); ++i)
+      count += tables[i].size();
+   return count;
+}
+
+
+size_t GlonassStore::getNumSatellites() const
+{
+   size_t count = 0;
+   for (size_t i = 0; i < tables.size(); ++i)
+      if (!tables[i].empty())
+         count++;
+   return count;
+}
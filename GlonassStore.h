@@ -0,0 +1,143 @@
+// Summary:
+//    GLONASS broadcast ephemerides read from RINEX GLONASS navigation files.
+//    A GLONASS ephemeris is a PZ-90 state vector (position, velocity and the
+//    luni-solar acceleration) at its reference time tb, so the satellite
+//    position at another time comes from integrating the equations of motion
+//    of the GLONASS ICD (central body plus J2, in the rotating Earth-fixed
+//    frame) with a fourth-order Runge-Kutta integrator.  The integrator state
+//    of each satellite is cached, so the next epoch continues from the last
+//    one instead of integrating from tb again.
+//
+//    Times are GPS system time: the UTC epochs of the file are shifted by the
+//    leap seconds of the header.  PZ-90.11 and WGS84 agree to a few
+//    centimetres, so no frame transformation is applied.
+
+#ifndef GlonassStore_H
+#define GlonassStore_H
+
+#include <string>
+#include <vector>
+
+#include "EphemerisStore.h"
+
+namespace NGSrinex { class GlonassEphemEpoch; }
+
+// One GLONASS broadcast ephemeris in SI units
+struct GlonassEphemeris
+{
+   int slot;                      // almanac (slot) number
+   int frequencyNumber;
+   long week;                     // GPS week and seconds of week of tb
+   double tb;
+   double clockBias;              // -TauN (s)
+   double relFreqBias;            // +GammaN
+   double frameTime;              // message frame time (s of UTC week)
+   double health;
+   double pos[3];                 // PZ-90 position (m)
+   double vel[3];                 // velocity (m/s)
+   double acc[3];                 // luni-solar acceleration (m/s^2)
+};
+
+class GlonassStore
+{
+   public:
+      enum { MAXSLOT = 32 };
+
+      GlonassStore();
+
+      //**
+      // Summary:
+      //    Add the ephemerides of a RINEX GLONASS navigation file to the
+      //    store.  May be called for several files; duplicates are dropped.
+      //
+      // Arguments:
+      //    filename - The name of the file.
+      //
+      // Returns:
+      //    True if successful and false otherwise.
+      bool load( const std::string& filename );
+
+      //**
+      // Summary:
+      //    Add one ephemeris, keeping its slot's table sorted by tb.
+      void add( const GlonassEphemeris &ephemeris );
+
+      //**
+      // Summary:
+      //    Set the largest |t - tb| for which an ephemeris is used.  The
+      //    default is 15 minutes, half the 30 minute update interval plus
+      //    margin for a missed update.
+      void setMaxAge( double seconds ) { maxAge = seconds; }
+
+      //**
+      // Summary:
+      //    Find the healthy ephemeris with tb closest to the given time.
+      //
+      // Returns:
+      //    A pointer into the store, or nullptr if no ephemeris is in range.
+      const GlonassEphemeris* select( int slot, long gpsWeek, double secsOfWeek ) const;
+
+      //**
+      // Summary:
+      //    Integrate an ephemeris from tb to the given time.
+      //
+      // Arguments:
+      //    ephemeris - The ephemeris.
+      //    gpsWeek, secsOfWeek - GPS system time of evaluation.
+      //    state - Receives the position and clock.
+      static void evaluate( const GlonassEphemeris &ephemeris, long gpsWeek,
+                            double secsOfWeek, SatelliteState &state );
+
+      //**
+      // Summary:
+      //    evaluate() for the ephemeris the store selects at the given time,
+      //    continuing from the cached integrator state of the satellite when
+      //    it is closer to the requested time than tb is.
+      //
+      // Returns:
+      //    True if an ephemeris was available.
+      bool evaluate( int slot, long gpsWeek, double secsOfWeek, SatelliteState &state );
+
+      //**
+      // Summary:
+      //    The GLONASS counterpart of EphemerisStore::computeSatellite(): the
+      //    position at transmission time in the receive-time frame, and the
+      //    correction = -c*dt in the satpos.txt convention.
+      //
+      // Returns:
+      //    True if an ephemeris was available.
+      bool computeSatellite( int slot, long gpsWeek, double secsOfWeek,
+                             double pseudorange, SatelliteData &satellite );
+
+      //**
+      // Summary:
+      //    Check the RINEX VERSION / TYPE record of a file for a GLONASS
+      //    navigation file.
+      static bool isNavigationFile( const std::string& filename );
+
+      size_t getNumEphemerides() const;
+      size_t getNumSatellites() const;
+      unsigned long getNumSteps() const { return numSteps; }
+
+      static void fromEphemEpoch( NGSrinex::GlonassEphemEpoch &epoch, long leapSeconds,
+                                  GlonassEphemeris &ephemeris );
+
+   private:
+      // integrator state of one satellite
+      struct Track
+      {
+         const GlonassEphemeris *ephemeris;   // nullptr: no state
+         double t;                            // seconds from tb
+         double pos[3], vel[3];
+      };
+
+      std::vector< std::vector<GlonassEphemeris> >   tables;   // indexed by slot
+      std::vector<Track>                             tracks;   // indexed by slot
+      double                                         maxAge;
+      unsigned long                                  numSteps;
+
+      static int integrate( const GlonassEphemeris &ephemeris, double fromSecs, double toSecs,
+                            double pos[3], double vel[3] );
+};
+
+#endif //GlonassStore_H
@@ -0,0 +1,239 @@
+// Summary:
+//    Contains the implementation of the least-squares single point
+//    positioning solution.
+
+#include "LeastSquares.h"
+
+#include <chrono>
+#include <cmath>
+
+int systemIndex(char code)
+{
+   for (int k = 0; k < MAXSYSTEMS; ++k)
+      if (SYSTEMCODES[k] == code)
+         return k;
+   return 0;   // unknown codes are treated as GPS
+}
+
+
+void findSystemStates(const std::vector<SatelliteData> &satellites, SystemStates &states)
+{
+   bool inView[MAXSYSTEMS] = { false };
+   for (size_t i = 0; i < satellites.size(); ++i)
+      inView[systemIndex(satellites[i].system)] = true;
+
+   states.numSystems = 0;
+   for (int k = 0; k < MAXSYSTEMS; ++k)
+      states.clockIndex[k] = inView[k] ? states.numSystems++ : -1;
+}
+
+
+void accumulateNormalEquations(
+    const std::vector<SatelliteData> &satellites,
+    const std::vector<double> &pseudoranges,
+    const std::vector<double> &weights,
+    const ReceiverState &receiver,
+    const SystemStates &systems,
+    StateMatrix &N,
+    StateVector &U)
+{
+   int numSat = satellites.size();
+   int numStates = 3 + systems.numSystems;
+   N.setZero(numStates, numStates);
+   U.setZero(numStates);
+
+   for (int i = 0; i < numSat; ++i)
+   {
+      const SatelliteData &sat = satellites[i];
+      double dx = receiver.x - sat.x;
+      double dy = receiver.y - sat.y;
+      double dz = receiver.z - sat.z;
+
+      // Compute geometric range (ρ_0)
+      double rho_0 = sqrt(dx * dx + dy * dy + dz * dz);
+
+      // Compute design matrix row
+      StateVector a = StateVector::Zero(numStates);
+      a(0) = dx / rho_0;
+      a(1) = dy / rho_0;
+      a(2) = dz / rho_0;
+      a(3) = -1.0;
+      double cdt = receiver.cdt;
+      int clock = systems.clockIndex[systemIndex(sat.system)];
+      if (clock > 0)
+      {
+         a(3 + clock) = -1.0;
+         cdt += receiver.systemCdt[clock - 1];
+      }
+
+
+      // Compute misclosure (w)
+      double correctedPseudorange = pseudoranges[i] - sat.correction;
+      double w = (rho_0 - cdt) - correctedPseudorange;
+
+      double p = weights.empty() ? 1.0 : weights[i];
+      N.noalias() += (p * a) * a.transpose();
+      U.noalias() += (p * w) * a;
+   }
+}
+
+
+Eigen::Vector3d computeENUError(
+    double x_est, double y_est, double z_est,
+    double x_ref, double y_ref, double z_ref,
+    double lat_deg, double lon_deg)
+{
+    // Convert lat/lon to radians
+    double lat = lat_deg * M_PI / 180.0;
+    double lon = lon_deg * M_PI / 180.0;
+
+    // Position difference in ECEF
+    Eigen::Vector3d d_xyz;
+    d_xyz << x_est - x_ref,
+             y_est - y_ref,
+             z_est - z_ref;
+
+    // Rotation matrix from ECEF to ENU
+    double sinLat = sin(lat);
+    double cosLat = cos(lat);
+    double sinLon = sin(lon);
+    double cosLon = cos(lon);
+
+    Eigen::Matrix3d R_enu;
+    R_enu << -sinLon,             cosLon,              0,
+            -sinLat * cosLon, -sinLat * sinLon,  cosLat,
+             cosLat * cosLon,  cosLat * sinLon,  sinLat;
+
+    return R_enu * d_xyz;
+}
+
+
+void completeSolutionRow(
+   const ReceiverState &receiver,
+   const Eigen::Matrix4d &Qx,
+   double epochTime,
+   int numSats,
+   const ReferencePosition &reference,
+   SolutionRow &row
+)
+{
+   // Convert to radians
+   double latitude = reference.lat;
+   double longitude = reference.lon;
+   double latRad = latitude * M_PI / 180.0;
+   double lonRad = longitude * M_PI / 180.0;
+
+   double sinLat = sin(latRad);
+   double cosLat = cos(latRad);
+   double sinLon = sin(lonRad);
+   double cosLon = cos(lonRad);
+
+   Eigen::Matrix4d R;
+   R << -sinLat * cosLon, -sinLat * sinLon, cosLat, 0,
+         sinLon,           cosLon,          0,      0,
+         cosLat * cosLon,  cosLat * sinLon, sinLat, 0,
+         0,                0,               0,      1;
+
+   Eigen::Matrix4d QL = R * Qx * R.transpose();
+
+   double NDOP = sqrt(QL(0, 0));
+   double EDOP = sqrt(QL(1, 1));
+   double VDOP = sqrt(QL(2, 2));
+   double TDOP = sqrt(QL(3, 3));
+   double HDOP = sqrt(NDOP * NDOP + EDOP * EDOP);
+   double PDOP = sqrt(HDOP * HDOP + VDOP * VDOP);
+   double GDOP = sqrt(HDOP * HDOP + VDOP * VDOP + TDOP * TDOP);
+
+   // Reference ECEF coordinates (true position)
+   const double X_ref = reference.x;
+   const double Y_ref = reference.y;
+   const double Z_ref = reference.z;
+
+   // Reference lat/lon (needed for ENU)
+   double lat_ref = reference.lat;
+   double lon_ref = reference.lon;
+
+   // Compute ENU error vector
+   Eigen::Vector3d enu_error = computeENUError(
+       receiver.x, receiver.y, receiver.z,
+       X_ref, Y_ref, Z_ref,
+       lat_ref, lon_ref);
+
+   row.epochTime = epochTime;
+   row.x = receiver.x;
+   row.y = receiver.y;
+   row.z = receiver.z;
+   row.cdt = receiver.cdt;
+   row.HDOP = HDOP;
+   row.VDOP = VDOP;
+   row.PDOP = PDOP;
+   row.GDOP = GDOP;
+   row.east = enu_error(0);
+   row.north = enu_error(1);
+   row.up = enu_error(2);
+   row.numSats = numSats;
+}
+
+
+void leastSquaresSolution(
+   const std::vector<SatelliteData> &satellites,
+   const std::vector<double> &pseudoranges,
+   double epochTime,
+   const ReferencePosition &reference,
+   const ReceiverState *start,
+   SolutionRow &row
+)
+{
+   auto solveStart = std::chrono::steady_clock::now();
+   ReceiverState receiver = {0.0, 0.0, 0.0, 0.0, {0.0, 0.0, 0.0}};
+   if (start)
+   {
+      // the inter-system biases depend on the systems in view, so only the
+      // position and first clock carry over
+      receiver.x = start->x;
+      receiver.y = start->y;
+      receiver.z = start->z;
+      receiver.cdt = start->cdt;
+   }
+   int maxIterations = 100;
+   double threshold = 1e-5;
+   const std::vector<double> unitWeights;   // P = I
+   SystemStates systems;
+   findSystemStates(satellites, systems);
+   int numStates = 3 + systems.numSystems;
+   StateVector dR;
+   StateVector U;
+   StateMatrix N;
+   Eigen::LDLT<StateMatrix> ldlt(numStates);
+   int numSats = satellites.size();
+   int iterations = 0;
+
+   for (int iter = 0; iter < maxIterations; ++iter)
+   {
+       iterations++;
+       accumulateNormalEquations(satellites, pseudoranges, unitWeights, receiver, systems, N, U);
+
+       ldlt.compute(N);
+       dR = -ldlt.solve(U);
+
+       receiver.x += dR(0);
+       receiver.y += dR(1);
+       receiver.z += dR(2);
+       receiver.cdt += dR(3);
+       for (int k = 1; k < systems.numSystems; ++k)
+           receiver.systemCdt[k - 1] += dR(3 + k);
+
+       if (dR.norm() < threshold)
+           break;
+   }
+
+
+   // Compute DOPs after convergence, from the position and first clock
+   StateMatrix Qfull = ldlt.solve(StateMatrix::Identity(numStates, numStates));
+   Eigen::Matrix4d Qx = Qfull.topLeftCorner<4, 4>();
+   completeSolutionRow(receiver, Qx, epochTime, numSats, reference, row);
+
+   row.iterations = iterations;
+   row.correctionNorm = dR.norm();
+   row.solveSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - solveStart).count();
+}
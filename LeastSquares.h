@@ -0,0 +1,114 @@
+// Summary:
+//    The epoch-by-epoch least-squares single point positioning solution.
+//    The states are the receiver position, its clock and one inter-system
+//    clock bias for each further satellite system in view.  Every matrix has
+//    a bounded size on the stack, so solving an epoch uses no heap memory.
+
+#ifndef LeastSquares_H
+#define LeastSquares_H
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "SatPosStore.h"
+#include "SolutionPool.h"
+
+// Satellite systems that can be mixed in one solution, in the order their
+// clock states are assigned
+const int MAXSYSTEMS = 3;
+const char SYSTEMCODES[MAXSYSTEMS + 1] = "GRS";   // GPS, GLONASS, SBAS
+const int MAXSTATES = 3 + MAXSYSTEMS;
+
+// Bounded dynamic sizes: the state count follows the systems in view, but
+// the storage stays on the stack
+typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, 0, MAXSTATES, MAXSTATES> StateMatrix;
+typedef Eigen::Matrix<double, Eigen::Dynamic, 1, 0, MAXSTATES, 1> StateVector;
+
+struct ReceiverState
+{
+   double x, y, z, cdt; // Initial receiver guess (position + clock bias)
+   double systemCdt[MAXSYSTEMS];   // clock of each further system in view minus cdt (m)
+};
+
+// Which clock state each satellite of an epoch uses: the first system in
+// view (in SYSTEMCODES order) owns cdt, every other one adds a bias state
+struct SystemStates
+{
+   int numSystems;
+   int clockIndex[MAXSYSTEMS];   // 0 = cdt only, k > 0 = systemCdt[k - 1]; -1 = not in view
+};
+
+// Known (true) antenna position that the solutions are compared against
+struct ReferencePosition
+{
+   double x, y, z;      // ECEF (m)
+   double lat, lon;     // geodetic (deg), for the local ENU frame and DOPs
+};
+
+//**
+// Summary:
+//    The position of a RINEX satellite system code in SYSTEMCODES.  Unknown
+//    codes are treated as GPS.
+int systemIndex( char code );
+
+//**
+// Summary:
+//    Assign the clock states of the systems in view of an epoch.
+void findSystemStates( const std::vector<SatelliteData> &satellites, SystemStates &states );
+
+//**
+// Summary:
+//    Accumulate the normal equations N = A^T P A and U = A^T P w directly
+//    from the design matrix row and misclosure of each satellite.  P is
+//    diagonal, so only the weight of each row is needed.
+//
+// Arguments:
+//    weights - One per satellite, or empty for P = I.
+//    receiver - The point the observation equations are linearised at.
+void accumulateNormalEquations( const std::vector<SatelliteData> &satellites,
+                                const std::vector<double> &pseudoranges,
+                                const std::vector<double> &weights,
+                                const ReceiverState &receiver,
+                                const SystemStates &systems,
+                                StateMatrix &N,
+                                StateVector &U );
+
+//**
+// Summary:
+//    The east, north and up difference of an estimated position from a
+//    reference position, in the local frame at lat_deg, lon_deg.
+Eigen::Vector3d computeENUError( double x_est, double y_est, double z_est,
+                                 double x_ref, double y_ref, double z_ref,
+                                 double lat_deg, double lon_deg );
+
+//**
+// Summary:
+//    Fill a solution row from the estimated receiver state and the cofactor
+//    matrix Qx of the position and first clock: DOPs and the ENU error
+//    w.r.t. the reference position.  The solver statistics are left as is.
+void completeSolutionRow( const ReceiverState &receiver,
+                          const Eigen::Matrix4d &Qx,
+                          double epochTime,
+                          int numSats,
+                          const ReferencePosition &reference,
+                          SolutionRow &row );
+
+//**
+// Summary:
+//    Compute the position, clock bias, DOPs and ENU error of one epoch and
+//    the solver statistics of the row.  Uses no shared state, so epochs can
+//    be solved concurrently.
+//
+// Arguments:
+//    pseudoranges - One per satellite, same order.
+//    start - Where the iteration starts, or nullptr for the centre of the
+//            Earth.  Only its position and first clock are used.
+void leastSquaresSolution( const std::vector<SatelliteData> &satellites,
+                           const std::vector<double> &pseudoranges,
+                           double epochTime,
+                           const ReferencePosition &reference,
+                           const ReceiverState *start,
+                           SolutionRow &row );
+
+#endif
@@ -0,0 +1,313 @@
+// Summary:
+//    Contains the implementation of the ObsCacheWriter and ObsCacheReader
+//    classes.
+
+#include "ObsCache.h"
+
+#include <cstring>
+#include <cstddef>
+#include <cstdio>
+#include <chrono>
+#include <filesystem>
+#include <algorithm>
+
+using namespace ObsCache;
+using namespace NGSrinex;
+
+namespace
+{
+   const char MAGIC[8] = { 'S', 'P', 'P', 'O', 'B', 'S', 'C', '\n' };
+   const uint32_t BYTEORDER = 0x01020304;
+
+   // the code byte of an observation: present ones carry their LLI (0-7)
+   // and signal strength (0-9); blank ones are either cleared or rejected
+   // by ObsBatch::setObservation()
+   const uint8_t PRESENT = 0x80;
+   const uint8_t CLEARED = 0x00;
+   const uint8_t REJECTED = 0x7F;
+   const unsigned short BLANK = 9999;
+
+   uint64_t fnv1a( uint64_t hash, const char *bytes, size_t count )
+   {
+      for (size_t i = 0; i < count; ++i)
+         hash = (hash ^ static_cast<unsigned char>(bytes[i])) * 1099511628211ULL;
+      return hash;
+   }
+
+   template <class T> void append( std::vector<char> &record, const T &value )
+   {
+      const char *bytes = reinterpret_cast<const char*>(&value);
+      record.insert(record.end(), bytes, bytes + sizeof(value));
+   }
+}
+
+
+bool ObsCache::stampSource( const std::string& filename, SourceStamp &stamp )
+{
+   std::error_code error;
+   stamp.size = std::filesystem::file_size(filename, error);
+   if (error)
+      return false;
+   stamp.modified = std::filesystem::last_write_time(filename, error).time_since_epoch().count();
+   if (error)
+      return false;
+
+   std::ifstream file(filename, std::ios::binary);
+   if (!file)
+      return false;
+   std::vector<char> sample(static_cast<size_t>(std::min<uint64_t>(stamp.size, SAMPLEBYTES)));
+   stamp.checksum = 1469598103934665603ULL;
+   if (!file.read(sample.data(), sample.size()))
+      return false;
+   stamp.checksum = fnv1a(stamp.checksum, sample.data(), sample.size());
+   if (stamp.size > SAMPLEBYTES)
+   {
+      uint64_t last = std::max<uint64_t>(stamp.size - SAMPLEBYTES, SAMPLEBYTES);
+      sample.resize(static_cast<size_t>(stamp.size - last));
+      file.seekg(static_cast<std::streamoff>(last));
+      if (!file.read(sample.data(), sample.size()))
+         return false;
+      stamp.checksum = fnv1a(stamp.checksum, sample.data(), sample.size());
+   }
+   return true;
+}
+
+//=========================== ObsCacheWriter Class ============================
+
+ObsCacheWriter::ObsCacheWriter()
+{
+   failed = false;
+}
+
+
+ObsCacheWriter::~ObsCacheWriter()
+{
+   if (file.is_open())
+      abandon();
+}
+
+
+bool ObsCacheWriter::open( const std::string& cacheFilename, const SourceStamp &source,
+                           RinexObsFile &obsFile )
+{
+   unsigned numTypes = obsFile.getNumObsTypes();
+   if (numTypes > MAXTYPES)
+      return false;
+
+   // unique among the jobs of this and other processes writing the same cache
+   filename = cacheFilename;
+   tempFilename = cacheFilename + ".tmp" +
+      std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) +
+      std::to_string(reinterpret_cast<uintptr_t>(this) % 100000);
+   file.open(tempFilename, std::ios::binary | std::ios::trunc);
+   if (!file)
+      return false;
+
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, MAGIC, sizeof(MAGIC));
+   header.byteOrder = BYTEORDER;
+   header.version = VERSION;
+   header.source = source;
+   header.numObsTypes = numTypes;
+   for (unsigned j = 0; j < numTypes; ++j)
+      header.obsTypes[j] = static_cast<uint8_t>(obsFile.getObsTypeListElement(j));
+
+   // the header is written again, complete, by close()
+   file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+   failed = !file;
+   return !failed;
+}
+
+
+void ObsCacheWriter::write( ObsBatch &batch )
+{
+   if (failed)
+      return;
+
+   EpochHeader epoch;
+   NGSdatetime::MJD mjd = batch.getEpochTime().GetMJD();
+   epoch.mjd = mjd.mjd;
+   epoch.fractionOfDay = mjd.fracOfDay;
+   epoch.clockOffset = batch.getRecClockOffset();
+   epoch.epochFlag = batch.getEpochFlag();
+   epoch.numSat = batch.getNumSat();
+
+   record.clear();
+   append(record, epoch);
+   const char *satCodes = batch.getSatCodes();
+   const unsigned short *satNums = batch.getSatNums();
+   record.insert(record.end(), satCodes, satCodes + epoch.numSat);
+   for (unsigned short i = 0; i < epoch.numSat; ++i)
+      append(record, static_cast<uint16_t>(satNums[i]));
+
+   for (unsigned short i = 0; i < epoch.numSat; ++i)
+   {
+      for (uint32_t j = 0; j < header.numObsTypes; ++j)
+      {
+         unsigned short lli = batch.getLLI(j)[i];
+         unsigned short strength = batch.getSigStrength(j)[i];
+         if (batch.getPresent(j)[i])
+         {
+            record.push_back(static_cast<char>(PRESENT | (lli << 4) | strength));
+            append(record, batch.getValues(j)[i]);
+         }
+         else if (lli == 0 && strength == 0)
+            record.push_back(static_cast<char>(CLEARED));
+         else if (lli == BLANK && strength == BLANK)
+            record.push_back(static_cast<char>(REJECTED));
+         else
+         {
+            failed = true;   // not something the parser produces
+            return;
+         }
+      }
+   }
+
+   uint32_t bytes = static_cast<uint32_t>(record.size());
+   memcpy(record.data() + offsetof(EpochHeader, bytes), &bytes, sizeof(bytes));
+   file.write(record.data(), record.size());
+   header.numEpochs++;
+   failed = !file;
+}
+
+
+bool ObsCacheWriter::close( unsigned long numWarnings )
+{
+   if (!file.is_open())
+      return false;
+   if (failed)
+   {
+      abandon();
+      return false;
+   }
+
+   header.numWarnings = numWarnings;
+   header.cacheBytes = static_cast<uint64_t>(file.tellp());
+   file.seekp(0);
+   file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+   file.close();
+
+   std::error_code error;
+   if (file.fail() || (std::filesystem::rename(tempFilename, filename, error), error))
+   {
+      std::remove(tempFilename.c_str());
+      return false;
+   }
+   return true;
+}
+
+
+void ObsCacheWriter::abandon()
+{
+   file.close();
+   std::remove(tempFilename.c_str());
+   failed = false;
+}
+
+//=========================== ObsCacheReader Class ============================
+
+ObsCacheReader::ObsCacheReader()
+{
+   data = nullptr;
+   size = 0;
+   position = 0;
+   memset(&header, 0, sizeof(header));
+}
+
+
+bool ObsCacheReader::open( const std::string& filename, const SourceStamp &source )
+{
+   if (mapping.open(filename))
+   {
+      data = mapping.getData();
+      size = mapping.getSize();
+   }
+   else
+   {
+      std::ifstream file(filename, std::ios::binary | std::ios::ate);
+      if (!file)
+         return false;
+      buffer.resize(static_cast<size_t>(file.tellg()));
+      file.seekg(0);
+      if (!file.read(buffer.data(), buffer.size()))
+         return false;
+      data = buffer.data();
+      size = buffer.size();
+   }
+
+   if (size < sizeof(header))
+      return false;
+   memcpy(&header, data, sizeof(header));
+   if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.byteOrder != BYTEORDER ||
+       header.version != VERSION || header.cacheBytes != size || header.numObsTypes > MAXTYPES ||
+       header.source.size != source.size || header.source.modified != source.modified ||
+       header.source.checksum != source.checksum)
+      return false;
+
+   for (uint32_t j = 0; j < MAXTYPES; ++j)
+      obsTypes[j] = j < header.numObsTypes ? static_cast<OBSTYPE>(header.obsTypes[j]) : NOOBS;
+   position = sizeof(header);
+   return true;
+}
+
+
+unsigned short ObsCacheReader::readEpoch( ObsBatch &batch )
+{
+   if (position >= size)
+      return 0;
+
+   EpochHeader epoch;
+   if (size - position < sizeof(epoch))
+      throw RinexReadingException("Truncated observation cache");
+   memcpy(&epoch, data + position, sizeof(epoch));
+   if (epoch.bytes < sizeof(epoch) || epoch.bytes > size - position)
+      throw RinexReadingException("Corrupt observation cache");
+   const char *record = data + position + sizeof(epoch);
+   const char *end = data + position + epoch.bytes;
+   position += epoch.bytes;
+
+   NGSdatetime::MJD mjd;
+   mjd.mjd = static_cast<long>(epoch.mjd);
+   mjd.fracOfDay = epoch.fractionOfDay;
+   batch.reset(static_cast<unsigned short>(header.numObsTypes), obsTypes);
+   batch.setEpochHeader(NGSdatetime::DateTime(mjd), epoch.epochFlag, epoch.clockOffset);
+   if (epoch.numSat == 0)
+      return 1;
+
+   if (end - record < 3 * static_cast<long>(epoch.numSat))
+      throw RinexReadingException("Corrupt observation cache");
+   batch.setNumSat(epoch.numSat);
+   const char *satCodes = record;
+   record += epoch.numSat;
+   for (unsigned short i = 0; i < epoch.numSat; ++i)
+   {
+      uint16_t satNum;
+      memcpy(&satNum, record + 2 * i, sizeof(satNum));
+      batch.setSatellite(i, satCodes[i], satNum);
+   }
+   record += 2 * epoch.numSat;
+
+   for (unsigned short i = 0; i < epoch.numSat; ++i)
+   {
+      for (uint32_t j = 0; j < header.numObsTypes; ++j)
+      {
+         if (record >= end)
+            throw RinexReadingException("Corrupt observation cache");
+         uint8_t code = static_cast<uint8_t>(*record++);
+         if (code & PRESENT)
+         {
+            double value;
+            if (end - record < static_cast<long>(sizeof(value)))
+               throw RinexReadingException("Corrupt observation cache");
+            memcpy(&value, record, sizeof(value));
+            record += sizeof(value);
+            batch.setObservation(j, i, value, (code >> 4) & 0x7, code & 0xF);
+         }
+         else if (code == REJECTED)
+            batch.setObservation(j, i, 0.0, BLANK, BLANK);
+         else
+            batch.setObservation(j, i, 0.0, 0, 0);
+      }
+   }
+   return 1;
+}
@@ -0,0 +1,180 @@
+// Summary:
+//    Binary cache of the decoded epochs of a RINEX observation file, so that
+//    runs after the first skip the text parsing.  The cache holds exactly
+//    what RinexObsFile::readEpoch(ObsBatch &) returns: the epoch time,
+//    flag and receiver clock offset, the satellite IDs, and for every
+//    observation type of every satellite its value, LLI and signal
+//    strength.  A blank observation takes one byte and a present one nine,
+//    against sixteen characters in the text.
+//
+//    The header records the observation file's size, modification time and
+//    a checksum of its first and last 64 KiB (which hold its RINEX header
+//    and its first and last epochs), and the cache is only used while all
+//    three match.  A cache is written under a temporary name and renamed
+//    when complete, so a reader never sees a partial one.
+
+#ifndef ObsCache_H
+#define ObsCache_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+
+#include "rinex.h"
+
+namespace ObsCache
+{
+   enum
+   {
+      VERSION = 1,
+      MAXTYPES = 16,
+      SAMPLEBYTES = 64 * 1024       // bytes checksummed at each end of the file
+   };
+
+   // What ties a cache to its observation file
+   struct SourceStamp
+   {
+      uint64_t size;
+      int64_t  modified;            // file clock ticks
+      uint64_t checksum;            // FNV-1a of the sampled bytes
+   };
+
+   // "SPPOBSC\n" followed by the fields below
+   struct FileHeader
+   {
+      char magic[8];
+      uint32_t byteOrder;           // 0x01020304 as written
+      uint32_t version;
+      SourceStamp source;
+      uint64_t numEpochs;
+      uint64_t cacheBytes;          // of the whole cache, header included
+      uint64_t numWarnings;         // of the epochs, when they were parsed
+      uint32_t numObsTypes;
+      uint8_t obsTypes[MAXTYPES];   // NGSrinex::OBSTYPE
+      uint32_t reserved;
+   };
+
+   // Each epoch: this header, then numSat satellite codes, numSat
+   // satellite numbers, and for each satellite and observation type one
+   // code byte, followed by the value (8 bytes) when it is present
+   struct EpochHeader
+   {
+      int64_t mjd;
+      double fractionOfDay;
+      double clockOffset;
+      uint16_t epochFlag;
+      uint16_t numSat;
+      uint32_t bytes;               // of the whole epoch record
+   };
+
+   //**
+   // Summary:
+   //    Stamp an observation file.
+   //
+   // Returns:
+   //    False if the file cannot be read.
+   bool stampSource( const std::string& filename, SourceStamp &stamp );
+}
+
+class ObsCacheWriter
+{
+   public:
+      ObsCacheWriter();
+      ~ObsCacheWriter();
+
+      //**
+      // Summary:
+      //    Start a cache of an observation file, under a temporary name.
+      //
+      // Arguments:
+      //    filename - The name of the cache.
+      //    source - The stamp of the observation file.
+      //    obsFile - The observation file, its header read.
+      //
+      // Returns:
+      //    True if successful and false otherwise.
+      bool open( const std::string& filename, const ObsCache::SourceStamp &source,
+                 NGSrinex::RinexObsFile &obsFile );
+
+      //**
+      // Summary:
+      //    Append the next epoch of the file.
+      void write( NGSrinex::ObsBatch &batch );
+
+      //**
+      // Summary:
+      //    Finish the cache and give it its name.
+      //
+      // Arguments:
+      //    numWarnings - Warnings of the epochs' parsing, reported on the
+      //                  runs that use the cache.
+      //
+      // Returns:
+      //    True if every write succeeded.
+      bool close( unsigned long numWarnings );
+
+      //**
+      // Summary:
+      //    Drop the partial cache, e.g. after a reading error.
+      void abandon();
+
+      bool isOpen() const { return file.is_open(); }
+
+   private:
+      std::ofstream          file;
+      std::string            filename;
+      std::string            tempFilename;
+      ObsCache::FileHeader   header;
+      std::vector<char>      record;       // epoch being encoded
+      bool                   failed;
+
+      ObsCacheWriter( const ObsCacheWriter & );            // not copyable
+      ObsCacheWriter &operator=( const ObsCacheWriter & );
+};
+
+class ObsCacheReader
+{
+   public:
+      ObsCacheReader();
+
+      //**
+      // Summary:
+      //    Map (or, where that is not possible, read) a cache.
+      //
+      // Arguments:
+      //    filename - The name of the cache.
+      //    source - The stamp the observation file has now.
+      //
+      // Returns:
+      //    True if the cache is complete, of a known version and was made
+      //    from the file as it is now; otherwise the caller parses the file.
+      bool open( const std::string& filename, const ObsCache::SourceStamp &source );
+
+      //**
+      // Summary:
+      //    Decode the next epoch.
+      //
+      // Returns:
+      //    1, or 0 at the end of the cache.  Throws a RinexReadingException
+      //    if the cache is corrupt.
+      unsigned short readEpoch( NGSrinex::ObsBatch &batch );
+
+      uint64_t getNumEpochs() const { return header.numEpochs; }
+      unsigned long getNumberWarnings() const { return static_cast<unsigned long>(header.numWarnings); }
+      size_t getSize() const { return size; }
+
+   private:
+      NGSrinex::MappedLineSource   mapping;
+      std::vector<char>            buffer;     // when the file is not mapped
+      const char                  *data;
+      size_t                       size;
+      size_t                       position;   // of the next epoch
+      ObsCache::FileHeader         header;
+      NGSrinex::OBSTYPE            obsTypes[ObsCache::MAXTYPES];
+
+      ObsCacheReader( const ObsCacheReader & );            // not copyable
+      ObsCacheReader &operator=( const ObsCacheReader & );
+};
+
+#endif //ObsCache_H
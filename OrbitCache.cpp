@@ -0,0 +1,135 @@
+// Summary:
+//    Contains the implementation of the OrbitCache class.
+
+#include "OrbitCache.h"
+
+#include <cmath>
+
+namespace
+{
+   const double PI = 3.14159265358979323846;
+   const double C = 299792458.0;               // m/s
+   const double SECSPERWEEK = 604800.0;
+
+   // part of the window kept before the epoch that triggered a fit, for the
+   // signal transmission times and small steps back
+   const double WINDOWLEAD = 0.1;
+}
+
+//========================== OrbitCache Class =================================
+
+OrbitCache::OrbitCache( const EphemerisStore &ephemerides, double window, int seriesDegree )
+   : store(ephemerides), windowSecs(window), degree(seriesDegree)
+{
+   numFits = 0;
+   numEvaluations = 0;
+}
+
+
+void OrbitCache::clear()
+{
+   windows.clear();
+}
+
+
+bool OrbitCache::evaluate( int prn, long gpsWeek, double secsOfWeek, SatelliteState &state )
+{
+   const GpsEphemeris *eph = store.select(prn, gpsWeek, secsOfWeek);
+   if (!eph)
+      return false;
+
+   if (windows.size() <= static_cast<size_t>(prn))
+   {
+      Window empty;
+      empty.ephemeris = nullptr;
+      windows.resize(prn + 1, empty);
+   }
+   Window &window = windows[prn];
+
+   // map the time onto [-1, 1]; refit outside the window or on a new ephemeris
+   double tau = static_cast<double>(gpsWeek - window.week) * SECSPERWEEK
+              + (secsOfWeek - window.start);
+   if (window.ephemeris != eph || tau < 0.0 || tau > windowSecs)
+   {
+      fit(window, *eph, gpsWeek, secsOfWeek);
+      tau = static_cast<double>(gpsWeek - window.week) * SECSPERWEEK
+          + (secsOfWeek - window.start);
+   }
+   double x = 2.0 * tau / windowSecs - 1.0;
+
+   // Clenshaw recurrence for each series
+   double values[NUMSERIES];
+   const int numTerms = degree + 1;
+   for (int s = 0; s < NUMSERIES; ++s)
+   {
+      const double *c = &window.coefficients[s * numTerms];
+      double b1 = 0.0, b2 = 0.0;
+      for (int j = degree; j >= 1; --j)
+      {
+         double b0 = 2.0 * x * b1 - b2 + c[j];
+         b2 = b1;
+         b1 = b0;
+      }
+      values[s] = x * b1 - b2 + 0.5 * c[0];
+   }
+
+   state.x = values[0];
+   state.y = values[1];
+   state.z = values[2];
+   state.vx = values[3];
+   state.vy = values[4];
+   state.vz = values[5];
+   state.clockBias = values[6];
+   state.relativistic = values[7];
+   numEvaluations++;
+   return true;
+}
+
+
+bool OrbitCache::computeSatellite( int prn, long gpsWeek, double secsOfWeek,
+                                   double pseudorange, SatelliteData &satellite )
+{
+   // the same transmit time as EphemerisStore::computeSatellite()
+   SatelliteState state;
+   double travel = pseudorange / C;
+   if (!evaluate(prn, gpsWeek, secsOfWeek - travel, state))
+      return false;
+   travel += state.clockBias;
+   evaluate(prn, gpsWeek, secsOfWeek - travel, state);
+
+   EphemerisStore::toSatelliteData(prn, 'G', state, travel, satellite);
+   return true;
+}
+
+
+// Sample the ephemeris at the Chebyshev nodes of a new window starting a
+// little before the given time, and compute the coefficients of each series
+void OrbitCache::fit( Window &window, const GpsEphemeris &ephemeris,
+                      long gpsWeek, double secsOfWeek )
+{
+   const int numTerms = degree + 1;
+   window.ephemeris = &ephemeris;
+   window.week = gpsWeek;
+   window.start = secsOfWeek - WINDOWLEAD * windowSecs;
+   window.coefficients.assign(NUMSERIES * numTerms, 0.0);
+
+   SatelliteState state;
+   for (int k = 0; k < numTerms; ++k)
+   {
+      double angle = PI * (k + 0.5) / numTerms;
+      double t = window.start + 0.5 * (cos(angle) + 1.0) * windowSecs;
+      EphemerisStore::evaluate(ephemeris, gpsWeek, t, state);
+
+      const double values[NUMSERIES] =
+         { state.x, state.y, state.z, state.vx, state.vy, state.vz,
+           state.clockBias, state.relativistic };
+      for (int j = 0; j < numTerms; ++j)
+      {
+         double weight = 2.0 / numTerms * cos(j * angle);
+         for (int s = 0; s < NUMSERIES; ++s)
+            window.coefficients[s * numTerms + j] += weight * values[s];
+      }
+   }
+
+   numFits++;
+}
@@ -0,0 +1,85 @@
+// Summary:
+//    Interpolated broadcast orbits for high-rate processing.  For each PRN
+//    the cache fits Chebyshev polynomials to the satellite position, velocity
+//    and clock over a window of a few minutes, sampling the ephemeris at the
+//    Chebyshev nodes, so that every later epoch in the window costs one
+//    polynomial evaluation instead of a Kepler solution.  A window is
+//    refitted when the epoch leaves it or when the store selects a different
+//    ephemeris (a new IODE or toe).
+//
+//    Accuracy: the series are truncated at degree 'degree' over a window of
+//    'windowSecs'.  Orbital motion at twice the orbit frequency (the harmonic
+//    corrections) decays in Chebyshev coefficients like (w T / 4)^n / n!, with
+//    w = 2.9e-4 rad/s and T the window length, so the default degree 9 over
+//    600 s leaves a truncation error below 1e-6 m in position and below
+//    1e-15 s in the clock, far under the rounding of the broadcast values.
+//    --bench-ephemeris reports the largest difference actually seen.
+
+#ifndef OrbitCache_H
+#define OrbitCache_H
+
+#include <vector>
+
+#include "EphemerisStore.h"
+
+class OrbitCache
+{
+   public:
+      //**
+      // Summary:
+      //    Create an empty cache.
+      //
+      // Arguments:
+      //    store - The ephemerides to interpolate.  Must outlive the cache.
+      //    windowSecs - Length of a fitted window (s).
+      //    degree - Degree of the Chebyshev series.
+      OrbitCache( const EphemerisStore &store, double windowSecs = 600.0, int degree = 9 );
+
+      //**
+      // Summary:
+      //    Interpolated EphemerisStore::evaluate() for the ephemeris that the
+      //    store selects at the given time.
+      //
+      // Returns:
+      //    True if an ephemeris was available.
+      bool evaluate( int prn, long gpsWeek, double secsOfWeek, SatelliteState &state );
+
+      //**
+      // Summary:
+      //    Interpolated EphemerisStore::computeSatellite().
+      bool computeSatellite( int prn, long gpsWeek, double secsOfWeek,
+                             double pseudorange, SatelliteData &satellite );
+
+      //**
+      // Summary:
+      //    Drop all fitted windows.
+      void clear();
+
+      unsigned long getNumFits() const { return numFits; }
+      unsigned long getNumEvaluations() const { return numEvaluations; }
+
+   private:
+      enum { NUMSERIES = 8 };   // x, y, z, vx, vy, vz, clockBias, relativistic
+
+      struct Window
+      {
+         const GpsEphemeris *ephemeris;   // nullptr: not fitted
+         long week;
+         double start;                    // s of week at the window start
+         std::vector<double> coefficients;   // NUMSERIES series of degree + 1
+      };
+
+      const EphemerisStore   &store;
+      double                 windowSecs;
+      int                    degree;
+      std::vector<Window>    windows;    // indexed by PRN
+      unsigned long          numFits;
+      unsigned long          numEvaluations;
+
+      void fit( Window &window, const GpsEphemeris &ephemeris, long gpsWeek, double secsOfWeek );
+
+      OrbitCache( const OrbitCache & );            // not copyable
+      OrbitCache &operator=( const OrbitCache & );
+};
+
+#endif //OrbitCache_H
@@ -0,0 +1,336 @@
+// Summary:
+//    Contains the implementation of the ParallelObsReader class.
+
+#include "ParallelObsReader.h"
+
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+
+using namespace NGSrinex;
+
+namespace
+{
+   // smallest range worth a thread of its own
+   const size_t MINRANGEBYTES = 64 * 1024;
+
+   // the start of the record after the one containing offset
+   size_t nextRecord( const char *data, size_t size, size_t offset )
+   {
+      if (offset >= size)
+         return size;
+      const void *newline = memchr(data + offset, '\n', size - offset);
+      return newline ? static_cast<const char*>(newline) - data + 1 : size;
+   }
+
+   // the length of the record at offset, without its line end
+   size_t recordLength( const char *data, size_t size, size_t offset )
+   {
+      size_t end = nextRecord(data, size, offset);
+      size_t length = end - offset;
+      while (length > 0 && (data[offset + length - 1] == '\n' || data[offset + length - 1] == '\r'))
+         length--;
+      return length;
+   }
+
+   // A RINEX 2 EPOCH/SAT or event flag record: blanks between the time
+   // fields, a flag of 0 to 6 in column 29 and a count in columns 30-32.
+   // Events may leave out the time; epochs that start a range may not.
+   bool isTimeTag( const char *data, size_t size, size_t offset, bool needTime,
+                   int &flag, int &count )
+   {
+      if (offset >= size)
+         return false;
+      const char *line = data + offset;
+      size_t length = recordLength(data, size, offset);
+      if (length < 32)
+         return false;
+
+      static const int BLANKS[] = { 0, 3, 6, 9, 12, 15, 26, 27 };
+      for (int column : BLANKS)
+         if (line[column] != ' ')
+            return false;
+      if (line[28] < '0' || line[28] > '6')
+         return false;
+
+      bool haveTime = line[18] == '.';
+      if (needTime && !haveTime)
+         return false;
+      if (haveTime && !(isdigit(static_cast<unsigned char>(line[2])) &&
+                        isdigit(static_cast<unsigned char>(line[5])) &&
+                        isdigit(static_cast<unsigned char>(line[17]))))
+         return false;
+
+      count = 0;
+      bool digits = false;
+      for (int column = 29; column < 32; ++column)
+      {
+         if (isdigit(static_cast<unsigned char>(line[column])))
+         {
+            count = count * 10 + (line[column] - '0');
+            digits = true;
+         }
+         else if (line[column] != ' ' || digits)
+            return false;
+      }
+      flag = line[28] - '0';
+      return digits;
+   }
+
+   // the records of an epoch after its time-tag record
+   size_t epochRecords( int flag, int count, unsigned numTypes )
+   {
+      if (flag >= 2 && flag <= 5)
+         return count;   // special records
+      size_t prnRecords = count > 0 ? (count - 1) / 12 : 0;
+      return prnRecords + static_cast<size_t>(count) * ((numTypes + 4) / 5);
+   }
+
+   // The first time-tag record at or after the record starting at offset
+   // whose epoch is followed by another time-tag record or the end of the
+   // data, or size if there is none
+   size_t findRangeStart( const char *data, size_t size, size_t offset, unsigned numTypes )
+   {
+      int flag, count;
+      for (; offset < size; offset = nextRecord(data, size, offset))
+      {
+         if (!isTimeTag(data, size, offset, true, flag, count))
+            continue;
+
+         size_t next = nextRecord(data, size, offset);
+         for (size_t i = epochRecords(flag, count, numTypes); i > 0 && next < size; --i)
+            next = nextRecord(data, size, next);
+         if (next >= size || isTimeTag(data, size, next, false, flag, count))
+            return offset;
+      }
+      return size;
+   }
+
+   // the offset of the first data record
+   size_t findHeaderEnd( const char *data, size_t size )
+   {
+      static const char LABEL[] = "END OF HEADER";
+      for (size_t offset = 0; offset < size; offset = nextRecord(data, size, offset))
+      {
+         size_t length = recordLength(data, size, offset);
+         if (length >= 60 + sizeof(LABEL) - 1 &&
+             memcmp(data + offset + 60, LABEL, sizeof(LABEL) - 1) == 0)
+            return nextRecord(data, size, offset);
+      }
+      return size;
+   }
+}
+
+//======================== ParallelObsReader Class ============================
+
+ParallelObsReader::ParallelObsReader()
+{
+   nextTake = 0;
+   nextRead = 0;
+   readIndex = 0;
+   reading = false;
+   stopping = false;
+   numberWarnings = 0;
+}
+
+
+ParallelObsReader::~ParallelObsReader()
+{
+   stop();
+}
+
+
+bool ParallelObsReader::open( RinexObsFile &headerFile, unsigned numThreads, size_t rangeBytes )
+{
+   stop();
+   pathFilename = headerFile.getPathFilename();
+   if (headerFile.getFormatVersion() >= 3.0f || headerFile.isDecodedInput() ||
+       !mapping.open(pathFilename))
+      return false;
+   const char *data = mapping.getData();
+   size_t size = mapping.getSize();
+
+   if (numThreads == 0)
+      numThreads = std::thread::hardware_concurrency();
+   if (numThreads == 0)
+      numThreads = 1;   // the core count is not known
+
+   size_t first = findHeaderEnd(data, size);
+   if (rangeBytes == 0)
+      rangeBytes = DEFAULTRANGEBYTES;
+   rangeBytes = std::min(rangeBytes, std::max(MINRANGEBYTES, (size - first) / (4 * numThreads)));
+
+   unsigned numTypes = headerFile.getNumObsTypes();
+   ranges.clear();
+   Range range;
+   range.begin = first;
+   while (range.begin < size)
+   {
+      range.end = size;
+      if (size - range.begin > rangeBytes)
+         range.end = findRangeStart(data, size, nextRecord(data, size, range.begin + rangeBytes - 1),
+                                    numTypes);
+      ranges.push_back(range);
+      range.begin = range.end;
+   }
+
+   // the workers' readers share the header's observation types and projection
+   numThreads = std::max(1u, std::min(numThreads, static_cast<unsigned>(ranges.size())));
+   readers.clear();
+   for (unsigned i = 0; i < numThreads; ++i)
+   {
+      std::unique_ptr<RinexObsFile> reader(new RinexObsFile());
+      reader->setNumObsTypes(numTypes);
+      for (unsigned j = 0; j < numTypes; ++j)
+         reader->setObsTypeListElement(headerFile.getObsTypeListElement(j), j);
+      reader->setFastParse(headerFile.getFastParse());
+      if (headerFile.getProjected())
+         reader->setProjection(headerFile.getProjectedSystems(), headerFile.getProjectedTypes());
+      readers.push_back(std::move(reader));
+   }
+
+   slots.clear();
+   slots.resize(SLOTSPERTHREAD * static_cast<size_t>(numThreads));
+   for (size_t i = 0; i < slots.size(); ++i)
+      slots[i].state = SLOT_EMPTY;
+   nextTake = 0;
+   nextRead = 0;
+   readIndex = 0;
+   reading = false;
+   stopping = false;
+   numberWarnings = 0;
+
+   for (unsigned i = 0; i < numThreads; ++i)
+      workers.push_back(std::thread(&ParallelObsReader::workerLoop, this, readers[i].get()));
+   return true;
+}
+
+
+size_t ParallelObsReader::estimateMemory( unsigned numThreads, size_t rangeBytes,
+                                          unsigned numObsTypes )
+{
+   if (numThreads == 0)
+      numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+   // a satellite is 16 columns of text per observation type, and a column
+   // of MAXOBSTYPES values, flags and LLI/signal strengths in an ObsBatch
+   size_t textPerSat = 16 * static_cast<size_t>(numObsTypes) + 2 * ((numObsTypes + 4) / 5);
+   size_t batchPerSat = MAXOBSTYPES * (sizeof(double) + sizeof(unsigned char) +
+                                       2 * sizeof(unsigned short)) + 3;
+   return SLOTSPERTHREAD * static_cast<size_t>(numThreads) *
+          (rangeBytes / std::max<size_t>(textPerSat, 1) + 1) * batchPerSat;
+}
+
+
+unsigned short ParallelObsReader::readEpoch( ObsBatch &batch )
+{
+   for (;;)
+   {
+      if (reading)
+      {
+         // the slot is DONE, so no worker touches it until it is released
+         Slot &slot = slots[nextRead % slots.size()];
+         if (readIndex < slot.numEpochs)
+         {
+            batch.swap(slot.epochs[readIndex++]);
+            return 1;
+         }
+         bool failed = slot.failed;
+         std::string error = slot.error;
+         releaseRange();
+         if (failed)
+            throw RinexReadingException(error);
+      }
+
+      if (nextRead >= ranges.size())
+         return 0;
+
+      std::unique_lock<std::mutex> lock(mutex);
+      rangeDone.wait(lock, [this] { return slots[nextRead % slots.size()].state == SLOT_DONE; });
+      reading = true;
+      readIndex = 0;
+   }
+}
+
+
+// Hand the slot of the range that has been read back to the workers
+void ParallelObsReader::releaseRange()
+{
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      Slot &slot = slots[nextRead % slots.size()];
+      numberWarnings += slot.numWarnings;
+      slot.state = SLOT_EMPTY;
+      nextRead++;
+      reading = false;
+   }
+   slotFree.notify_all();
+}
+
+
+void ParallelObsReader::workerLoop( RinexObsFile *reader )
+{
+   std::unique_lock<std::mutex> lock(mutex);
+
+   for (;;)
+   {
+      // at most slots.size() ranges are parsed ahead of the one being read
+      slotFree.wait(lock, [this] { return stopping || nextTake >= ranges.size() ||
+                                          nextTake - nextRead < slots.size(); });
+      if (stopping || nextTake >= ranges.size())
+         return;
+
+      const Range &range = ranges[nextTake];
+      Slot &slot = slots[nextTake % slots.size()];
+      slot.state = SLOT_PARSING;
+      nextTake++;
+
+      lock.unlock();
+      parseRange(*reader, range, slot);
+      lock.lock();
+
+      slot.state = SLOT_DONE;
+      rangeDone.notify_all();
+   }
+}
+
+
+void ParallelObsReader::parseRange( RinexObsFile &reader, const Range &range, Slot &slot )
+{
+   reader.setInputSpan(pathFilename, mapping.getData() + range.begin, range.end - range.begin);
+   unsigned long warnings = reader.getNumberWarnings();
+
+   slot.numEpochs = 0;
+   slot.failed = false;
+   slot.error.clear();
+   try
+   {
+      for (;;)
+      {
+         if (slot.numEpochs == slot.epochs.size())
+            slot.epochs.emplace_back();
+         if (reader.readEpoch(slot.epochs[slot.numEpochs]) == 0)
+            break;
+         slot.numEpochs++;
+      }
+   }
+   catch (RinexReadingException &readingExcep)
+   {
+      slot.failed = true;
+      slot.error = readingExcep.getMessage();
+   }
+   slot.numWarnings = reader.getNumberWarnings() - warnings;
+}
+
+
+void ParallelObsReader::stop()
+{
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+   }
+   slotFree.notify_all();
+   for (size_t i = 0; i < workers.size(); ++i)
+      workers[i].join();
+   workers.clear();
+}
@@ -0,0 +1,135 @@
+// Summary:
+//    Parallel parsing of one RINEX 2 observation file.  The data records are
+//    split into byte ranges at time-tag (EPOCH/SAT) records, each range is
+//    parsed into ObsBatch epochs on a worker thread, and the epochs are
+//    handed back in file order, just as RinexObsFile::readEpoch(ObsBatch &)
+//    would return them.
+//
+//    The file is mapped once and the workers read their ranges in place.
+//    The header is read once, by the caller's RinexObsFile; each worker's
+//    reader is given its observation types before the workers start and
+//    never changes them.
+//
+//    A range only starts at a time-tag record whose epoch (its satellite
+//    count, the PRN continuation records and one record per five
+//    observation types per satellite) ends exactly at another time-tag
+//    record or at the end of the file, so a data record that happens to
+//    look like a time tag does not split the file.
+
+#ifndef ParallelObsReader_H
+#define ParallelObsReader_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "rinex.h"
+
+class ParallelObsReader
+{
+   public:
+      enum { DEFAULTRANGEBYTES = 4 << 20, SLOTSPERTHREAD = 2 };
+
+      ParallelObsReader();
+      ~ParallelObsReader();
+
+      //**
+      // Summary:
+      //    Map the observation file, split its data records into ranges and
+      //    start parsing them.
+      //
+      // Arguments:
+      //    headerFile - The observation file, opened and its header read,
+      //                 and its projection set.
+      //    numThreads - Parsing threads, or 0 for one per core.
+      //    rangeBytes - Largest (approximate) size of a range, or 0 for
+      //                 DEFAULTRANGEBYTES.  Ranges are made smaller where
+      //                 that keeps every thread busy.
+      //
+      // Returns:
+      //    True if the file could be mapped and is uncompressed RINEX 2;
+      //    otherwise the caller reads the file with headerFile.
+      bool open( NGSrinex::RinexObsFile &headerFile, unsigned numThreads,
+                 size_t rangeBytes = 0 );
+
+      //**
+      // Summary:
+      //    Estimate the memory of the epochs parsed ahead: SLOTSPERTHREAD
+      //    ranges per thread, each parsed into ObsBatch columns.
+      //
+      // Arguments:
+      //    numThreads - Parsing threads, or 0 for one per core.
+      //    rangeBytes - Size of a range.
+      //    numObsTypes - Observation types of the file.
+      static size_t estimateMemory( unsigned numThreads, size_t rangeBytes,
+                                    unsigned numObsTypes );
+
+      //**
+      // Summary:
+      //    Take the next epoch of the file.  The batch's columns are swapped
+      //    with the parsed ones, so no observations are copied.
+      //
+      // Returns:
+      //    1, or 0 at the end of the file.  A RinexReadingException of a
+      //    range is thrown after the epochs parsed before it.
+      unsigned short readEpoch( NGSrinex::ObsBatch &batch );
+
+      //**
+      // Summary:
+      //    The warnings of the ranges read so far.  Their line numbers count
+      //    from the start of their range.
+      unsigned long getNumberWarnings() const { return numberWarnings; }
+
+      size_t getNumRanges() const { return ranges.size(); }
+      unsigned getNumThreads() const { return static_cast<unsigned>(workers.size()); }
+
+   private:
+      enum SlotState { SLOT_EMPTY, SLOT_PARSING, SLOT_DONE };
+
+      struct Range
+      {
+         size_t begin;
+         size_t end;
+      };
+
+      // the epochs of one range; the batches are reused for later ranges
+      struct Slot
+      {
+         std::deque<NGSrinex::ObsBatch> epochs;
+         size_t numEpochs;
+         bool failed;
+         std::string error;
+         unsigned long numWarnings;
+         SlotState state;
+      };
+
+      NGSrinex::MappedLineSource                             mapping;
+      std::string                                            pathFilename;
+      std::vector<Range>                                     ranges;
+      std::vector< std::unique_ptr<NGSrinex::RinexObsFile> > readers;   // one per worker
+      std::vector<std::thread>                               workers;
+      std::vector<Slot>                                      slots;     // ring indexed by range % size
+      size_t                                                 nextTake;  // next range to parse
+      size_t                                                 nextRead;  // range being read
+      size_t                                                 readIndex; // next epoch of nextRead
+      bool                                                   reading;   // nextRead's slot is DONE and taken
+      bool                                                   stopping;
+      unsigned long                                          numberWarnings;
+      std::mutex                                             mutex;
+      std::condition_variable                                slotFree;
+      std::condition_variable                                rangeDone;
+
+      void workerLoop( NGSrinex::RinexObsFile *reader );
+      void parseRange( NGSrinex::RinexObsFile &reader, const Range &range, Slot &slot );
+      void releaseRange();
+      void stop();
+
+      ParallelObsReader( const ParallelObsReader & );            // not copyable
+      ParallelObsReader &operator=( const ParallelObsReader & );
+};
+
+#endif //ParallelObsReader_H
@@ -0,0 +1,311 @@
+// Summary:
+//    Contains the implementation of the SatPosStore class.
+
+#include "SatPosStore.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace
+{
+   const long long MSPERWEEK = 604800000LL;
+   const double SECSPERWEEK = 604800.0;
+   const double GM = 3.986005e14;              // m^3/s^2
+
+   // neighbouring epochs further apart than this give no velocity
+   const double MAXVELOCITYSTEP = 60.0;
+
+   const SatelliteData* findSatellite( const EpochData &epochData, int prn )
+   {
+      for (size_t i = 0; i < epochData.satellites.size(); ++i)
+         if (epochData.satellites[i].prn == prn)
+            return &epochData.satellites[i];
+      return nullptr;
+   }
+
+   // seconds from one epoch to another, across a week rollover
+   double epochStep( const EpochData &from, const EpochData &to )
+   {
+      double dt = to.epoch - from.epoch;
+      if (dt < -0.5 * SECSPERWEEK)
+         dt += SECSPERWEEK;
+      else if (dt > 0.5 * SECSPERWEEK)
+         dt -= SECSPERWEEK;
+      return dt;
+   }
+}
+
+//========================== SatPosSource Class ===============================
+
+SatPosSource::SatPosSource()
+{
+   toleranceMs = 1;
+   numLookups = 0;
+   numHits = 0;
+   lookupNanos = 0.0;
+   lineNumber = 0;
+}
+
+SatPosSource::~SatPosSource()
+{ }
+
+
+long long SatPosSource::makeKey( long gpsWeek, double secsOfWeek )
+{
+   // round to the nearest millisecond so that times such as 522000.9999999
+   // (from the YMDHMS -> GPS time conversion) land on the same key as 522001
+   return static_cast<long long>( gpsWeek ) * MSPERWEEK + llround( secsOfWeek * 1000.0 );
+}
+
+
+void SatPosSource::setTolerance( double toleranceSec )
+{
+   toleranceMs = llround( fabs(toleranceSec) * 1000.0 );
+}
+
+
+const EpochData* SatPosSource::find( long gpsWeek, double secsOfWeek )
+{
+   auto start = std::chrono::steady_clock::now();
+
+   const EpochData *result = lookup( makeKey( gpsWeek, secsOfWeek ) );
+
+   auto stop = std::chrono::steady_clock::now();
+   lookupNanos += std::chrono::duration<double, std::nano>(stop - start).count();
+   numLookups++;
+   if (result)
+      numHits++;
+
+   return result;
+}
+
+
+double SatPosSource::getMeanLookupNanos() const
+{
+   return numLookups > 0 ? lookupNanos / numLookups : 0.0;
+}
+
+
+void SatPosSource::resetLines()
+{
+   lineNumber = 0;
+   error.clear();
+}
+
+
+int SatPosSource::formatError( const char *what )
+{
+   std::ostringstream message;
+   message << "line " << lineNumber << ": " << what;
+   error = message.str();
+   std::cerr << "Error in satellite position file, " << error << ".\n";
+   return -1;
+}
+
+
+int SatPosSource::readEpochData( std::istream &file, EpochData &epochData )
+{
+   std::string line;
+
+   if (!std::getline(file, line))
+      return 0;
+   lineNumber++;
+
+   std::istringstream iss(line);
+
+   // Read the epoch and number of satellites
+   if (!(iss >> epochData.epoch >> epochData.numSatellites) || epochData.numSatellites < 0)
+      return formatError("bad epoch line");
+
+   // Read satellite data for this epoch
+   epochData.satellites.clear();
+   epochData.satellites.reserve(epochData.numSatellites);
+   for (int i = 0; i < epochData.numSatellites; ++i)
+   {
+      if (!std::getline(file, line))
+         return formatError("unexpected end of file in the satellite lines");
+      lineNumber++;
+
+      std::istringstream satStream(line);
+      SatelliteData sat;
+      sat.system = 'G';
+      sat.vx = sat.vy = sat.vz = std::numeric_limits<double>::quiet_NaN();
+      if (!(satStream >> sat.prn >> sat.x >> sat.y >> sat.z >> sat.correction))
+         return formatError("bad satellite line");
+
+      epochData.satellites.push_back(sat);
+   }
+
+   return 1;
+}
+
+
+void SatPosSource::setVelocities( EpochData &epochData, const EpochData *before,
+                                  const EpochData *after )
+{
+   double dtBefore = before ? epochStep(epochData, *before) : 0.0;
+   double dtAfter = after ? epochStep(epochData, *after) : 0.0;
+   if (dtBefore >= 0.0 || dtBefore < -MAXVELOCITYSTEP)
+      before = nullptr;
+   if (dtAfter <= 0.0 || dtAfter > MAXVELOCITYSTEP)
+      after = nullptr;
+
+   for (size_t i = 0; i < epochData.satellites.size(); ++i)
+   {
+      SatelliteData &sat = epochData.satellites[i];
+      const SatelliteData *prior = before ? findSatellite(*before, sat.prn) : nullptr;
+      const SatelliteData *next = after ? findSatellite(*after, sat.prn) : nullptr;
+      if (prior && next)
+      {
+         // central difference
+         double dt = dtAfter - dtBefore;
+         sat.vx = (next->x - prior->x) / dt;
+         sat.vy = (next->y - prior->y) / dt;
+         sat.vz = (next->z - prior->z) / dt;
+      }
+      else if (prior || next)
+      {
+         // a one-sided difference is the velocity half a step away; move it
+         // back to the epoch with the gravitational acceleration
+         const SatelliteData *other = next ? next : prior;
+         double dt = next ? dtAfter : dtBefore;
+         double r2 = sat.x * sat.x + sat.y * sat.y + sat.z * sat.z;
+         double gravity = GM / (r2 * sqrt(r2)) * 0.5 * dt;
+         sat.vx = (other->x - sat.x) / dt + gravity * sat.x;
+         sat.vy = (other->y - sat.y) / dt + gravity * sat.y;
+         sat.vz = (other->z - sat.z) / dt + gravity * sat.z;
+      }
+   }
+}
+
+
+//========================== SatPosStore Class ================================
+
+bool SatPosStore::load( const std::string& filename, long gpsWeek )
+{
+   std::ifstream file(filename);
+   if (!file.is_open())
+   {
+      std::cerr << "Error opening file: " << filename << "\n";
+      return false;
+   }
+
+   epochs.clear();
+   index.clear();
+   resetLines();
+
+   EpochData epochData;
+   double lastEpoch = -1.0;
+   int status;
+
+   while ((status = readEpochData(file, epochData)) > 0)
+   {
+      // seconds of week rolled back: the file crossed into the next week
+      if (lastEpoch >= 0.0 && epochData.epoch < lastEpoch - 302400.0)
+         gpsWeek++;
+      lastEpoch = epochData.epoch;
+
+      index[makeKey(gpsWeek, epochData.epoch)] = epochs.size();
+      epochs.push_back(epochData);
+   }
+
+   for (size_t i = 0; i < epochs.size(); ++i)
+      setVelocities(epochs[i], i > 0 ? &epochs[i - 1] : nullptr,
+                    i + 1 < epochs.size() ? &epochs[i + 1] : nullptr);
+
+   return status == 0;
+}
+
+
+const EpochData* SatPosStore::lookup( long long key )
+{
+   // probe the exact key first, then widen symmetrically up to the tolerance
+   for (long long delta = 0; delta <= toleranceMs; ++delta)
+   {
+      auto it = index.find(key - delta);
+      if (it == index.end() && delta != 0)
+         it = index.find(key + delta);
+      if (it != index.end())
+         return &epochs[it->second];
+   }
+   return nullptr;
+}
+
+
+//========================== SatPosStream Class ===============================
+
+SatPosStream::SatPosStream()
+{
+   currentKey = 0;
+   havePrevious = false;
+   haveCurrent = false;
+   haveFollowing = false;
+   gpsWeek = 0;
+   lastEpoch = -1.0;
+   numEpochsRead = 0;
+}
+
+
+bool SatPosStream::open( const std::string& filename, long week )
+{
+   file.open(filename);
+   if (!file.is_open())
+   {
+      std::cerr << "Error opening file: " << filename << "\n";
+      return false;
+   }
+
+   gpsWeek = week;
+   lastEpoch = -1.0;
+   numEpochsRead = 0;
+   resetLines();
+
+   // prime the cursor with the first epoch and the one after it; an empty
+   // file is not an error, and a format error further on is reported when
+   // the cursor reaches it
+   haveCurrent = false;
+   haveFollowing = readEpochData(file, following) > 0;
+   advance();
+   return !file.bad() && (haveCurrent || getError().empty());
+}
+
+
+bool SatPosStream::advance()
+{
+   // swap, so that the satellite vectors keep their capacity
+   std::swap(previous, current);
+   havePrevious = haveCurrent;
+   std::swap(current, following);
+   haveCurrent = haveFollowing;
+   haveFollowing = haveCurrent && readEpochData(file, following) > 0;
+   if (!haveCurrent)
+      return false;
+
+   if (lastEpoch >= 0.0 && current.epoch < lastEpoch - 302400.0)
+      gpsWeek++;
+   lastEpoch = current.epoch;
+
+   currentKey = makeKey(gpsWeek, current.epoch);
+   setVelocities(current, havePrevious ? &previous : nullptr,
+                 haveFollowing ? &following : nullptr);
+   numEpochsRead++;
+   return true;
+}
+
+
+const EpochData* SatPosStream::lookup( long long key )
+{
+   // skip satpos.txt epochs that no observation epoch will ask for
+   while (haveCurrent && currentKey < key - toleranceMs)
+      advance();
+
+   if (haveCurrent && currentKey <= key + toleranceMs)
+      return &current;
+
+   return nullptr;   // the next satpos.txt epoch is still ahead of this one
+}
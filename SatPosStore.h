@@ -0,0 +1,174 @@
+// Summary:
+//    Satellite position sources for the precomputed satpos.txt file.  Each
+//    epoch of satellite coordinates and pseudorange corrections is keyed by GPS
+//    week and integer milliseconds of week.  SatPosStore loads the whole file
+//    and finds any epoch in constant time; SatPosStream walks the file in step
+//    with the (time-ordered) RINEX epochs and keeps only the epochs around
+//    the current one in memory.  The file has no velocities: they are
+//    differenced from the positions of the same satellite at the neighbouring
+//    epochs of the file.
+
+#ifndef SatPosStore_H
+#define SatPosStore_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <unordered_map>
+
+struct SatelliteData
+{
+   int prn;
+   char system;                   // RINEX satellite system: 'G', 'R' or 'S'
+   double x, y, z, correction;
+   double vx, vy, vz;             // velocity (m/s); NaN if the source has none
+};
+
+struct EpochData
+{
+   double epoch;
+   int numSatellites;
+   std::vector<SatelliteData> satellites;
+};
+
+class SatPosSource   // this is a base class
+{
+   public:
+      SatPosSource();
+      virtual ~SatPosSource();
+
+      //**
+      // Summary:
+      //    Set the half-width of the time window used to match an observation
+      //    time to a satpos.txt epoch.
+      //
+      // Arguments:
+      //    toleranceSec - The tolerance in seconds (rounded to milliseconds).
+      void setTolerance( double toleranceSec );
+
+      //**
+      // Summary:
+      //    Find the satpos.txt epoch closest to the given GPS time, within the
+      //    tolerance window.
+      //
+      // Arguments:
+      //    gpsWeek - GPS week of the observation.
+      //    secsOfWeek - GPS seconds of week of the observation.
+      //
+      // Returns:
+      //    A pointer to the epoch, or nullptr if no epoch is within tolerance.
+      //    The pointer is valid until the next call.
+      const EpochData* find( long gpsWeek, double secsOfWeek );
+
+      //**
+      // Summary:
+      //    Why the file could not be read: the line number and what was wrong
+      //    with it, or empty.  A stream stops at the first format error, so
+      //    check this when find() returns nullptr.
+      const std::string& getError() const { return error; }
+
+      virtual size_t getNumEpochs() const = 0;
+      unsigned long  getNumLookups() const { return numLookups; }
+      unsigned long  getNumHits() const { return numHits; }
+      double         getMeanLookupNanos() const;
+
+      static long long makeKey( long gpsWeek, double secsOfWeek );
+
+   protected:
+      long long   toleranceMs;
+
+      virtual const EpochData* lookup( long long key ) = 0;
+
+      // Read one epoch line and its satellite lines.  Returns 1 on success,
+      // 0 at end of file and -1 on a format error, which is reported and
+      // kept for getError().
+      int readEpochData( std::istream &file, EpochData &epochData );
+
+      // start counting lines from the top of a new file
+      void resetLines();
+
+      // Difference the velocities of an epoch's satellites from their
+      // positions at the epochs before and after it (either may be nullptr)
+      static void setVelocities( EpochData &epochData, const EpochData *before,
+                                 const EpochData *after );
+
+   private:
+      unsigned long   lineNumber;    // lines read from the file
+      std::string     error;
+
+      int formatError( const char *what );
+
+      unsigned long   numLookups;
+      unsigned long   numHits;
+      double          lookupNanos;
+};
+
+
+class SatPosStore : public SatPosSource
+{
+   public:
+      //**
+      // Summary:
+      //    Read all epochs of a satpos.txt file into the store.
+      //
+      // Arguments:
+      //    filename - The name of the file.
+      //    gpsWeek - The GPS week of the first epoch in the file.  The file only
+      //              holds seconds of week, so the week is incremented whenever
+      //              the time rolls back over the end of a week.
+      //
+      // Returns:
+      //    True if successful and false otherwise.
+      bool load( const std::string& filename, long gpsWeek );
+
+      size_t getNumEpochs() const { return epochs.size(); }
+
+   protected:
+      const EpochData* lookup( long long key );
+
+   private:
+      std::vector<EpochData>                  epochs;
+      std::unordered_map<long long, size_t>   index;   // key -> epochs[]
+};
+
+
+class SatPosStream : public SatPosSource
+{
+   public:
+      SatPosStream();
+
+      //**
+      // Summary:
+      //    Open a satpos.txt file for a merge-join against the RINEX epochs.
+      //    Lookups must then be made in non-decreasing time order.
+      //
+      // Arguments:
+      //    filename - The name of the file.
+      //    gpsWeek - The GPS week of the first epoch in the file.
+      //
+      // Returns:
+      //    True if successful and false otherwise.
+      bool open( const std::string& filename, long gpsWeek );
+
+      size_t getNumEpochs() const { return numEpochsRead; }
+
+   protected:
+      const EpochData* lookup( long long key );
+
+   private:
+      std::ifstream   file;
+      EpochData       previous;      // the epoch before current, for its velocities
+      EpochData       current;
+      EpochData       following;     // read ahead, for the velocities of current
+      long long       currentKey;
+      bool            havePrevious;
+      bool            haveCurrent;
+      bool            haveFollowing;
+      long            gpsWeek;
+      double          lastEpoch;
+      size_t          numEpochsRead;
+
+      bool advance();
+};
+
+#endif //SatPosStore_H
@@ -0,0 +1,226 @@
+// Summary:
+//    Contains the implementation of the SbasStore class.
+
+#include "SbasStore.h"
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cmath>
+
+#include "rinex.h"
+#include "NRinexUtils.h"
+
+namespace
+{
+   const double C = 299792458.0;               // m/s
+   const double SECSPERWEEK = 604800.0;
+
+   double timeDiff( long week2, double sow2, long week1, double sow1 )
+   {
+      return static_cast<double>(week2 - week1) * SECSPERWEEK + (sow2 - sow1);
+   }
+
+   bool earlier( const SbasEphemeris &a, const SbasEphemeris &b )
+   {
+      if (a.week != b.week) return a.week < b.week;
+      if (a.t0 != b.t0) return a.t0 < b.t0;
+      return a.frameTime < b.frameTime;
+   }
+}
+
+//============================= SbasStore Class ===============================
+
+SbasStore::SbasStore()
+{
+   maxAge = 6.0 * 60.0;
+}
+
+
+bool SbasStore::load( const std::string& filename )
+{
+   NGSrinex::GeostationaryNavFile navFile;
+   if (!NRinexUtils::OpenRinexGeostationaryNavigationFileForInput(navFile, filename))
+   {
+      std::cerr << "Error opening SBAS navigation file: " << filename << "\n";
+      return false;
+   }
+
+   NGSrinex::GeostationaryEphemEpoch epoch;
+   SbasEphemeris ephemeris;
+   try
+   {
+      while (navFile.readEphemEpoch(epoch) != 0)
+      {
+         fromEphemEpoch(epoch, ephemeris);
+         add(ephemeris);
+      }
+   }
+   catch (NGSrinex::RinexReadingException &readingExcep)
+   {
+      std::cerr << "Error reading SBAS navigation file: " << filename << "\n"
+                << readingExcep.getMessage() << "\n";
+      return false;
+   }
+
+   return true;
+}
+
+
+void SbasStore::fromEphemEpoch( NGSrinex::GeostationaryEphemEpoch &epoch,
+                                SbasEphemeris &ephemeris )
+{
+   NGSdatetime::DateTime t0;
+   t0.SetYMDHMS(epoch.getEpochYear(), epoch.getEpochMonth(), epoch.getEpochDay(),
+                epoch.getEpochHour(), epoch.getEpochMin(), epoch.getEpochSec());
+   NGSdatetime::GPSTime t0GPS = t0.GetGPSTime();
+
+   ephemeris.satNum = epoch.getSatelliteNumber();
+   ephemeris.week = t0GPS.GPSWeek;
+   ephemeris.t0 = t0GPS.secsOfWeek;
+   ephemeris.clockBias = epoch.getSvClockBias();
+   ephemeris.relFreqBias = epoch.getSvRelFreqBias();
+   ephemeris.frameTime = epoch.getMessageFrameTime();
+   ephemeris.health = epoch.getSvHealth();
+
+   // the file is in km, km/s and km/s^2
+   ephemeris.pos[0] = epoch.getPosX() * 1000.0;
+   ephemeris.pos[1] = epoch.getPosY() * 1000.0;
+   ephemeris.pos[2] = epoch.getPosZ() * 1000.0;
+   ephemeris.vel[0] = epoch.getVelX() * 1000.0;
+   ephemeris.vel[1] = epoch.getVelY() * 1000.0;
+   ephemeris.vel[2] = epoch.getVelZ() * 1000.0;
+   ephemeris.acc[0] = epoch.getAccX() * 1000.0;
+   ephemeris.acc[1] = epoch.getAccY() * 1000.0;
+   ephemeris.acc[2] = epoch.getAccZ() * 1000.0;
+}
+
+
+void SbasStore::add( const SbasEphemeris &ephemeris )
+{
+   if (ephemeris.satNum <= 0)
+      return;
+   if (tables.size() <= static_cast<size_t>(ephemeris.satNum))
+      tables.resize(ephemeris.satNum + 1);
+
+   std::vector<SbasEphemeris> &table = tables[ephemeris.satNum];
+   auto it = std::upper_bound(table.begin(), table.end(), ephemeris, earlier);
+
+   // merged navigation files repeat the same ephemeris many times
+   if (it != table.begin())
+   {
+      const SbasEphemeris &previous = *(it - 1);
+      if (previous.week == ephemeris.week && previous.t0 == ephemeris.t0 &&
+          previous.pos[0] == ephemeris.pos[0] && previous.clockBias == ephemeris.clockBias)
+         return;
+   }
+   table.insert(it, ephemeris);
+}
+
+
+const SbasEphemeris* SbasStore::select( int satNum, long gpsWeek, double secsOfWeek ) const
+{
+   if (satNum <= 0 || static_cast<size_t>(satNum) >= tables.size())
+      return nullptr;
+
+   const std::vector<SbasEphemeris> &table = tables[satNum];
+   const SbasEphemeris *best = nullptr;
+   double bestAge = 0.0;
+
+   // the table is sorted by t0: start at the first one within maxAge
+   SbasEphemeris key;
+   key.week = gpsWeek;
+   key.t0 = secsOfWeek - maxAge;
+   while (key.t0 < 0.0)
+   {
+      key.week--;
+      key.t0 += SECSPERWEEK;
+   }
+   key.frameTime = -SECSPERWEEK;
+   auto it = std::lower_bound(table.begin(), table.end(), key, earlier);
+
+   for (; it != table.end(); ++it)
+   {
+      double age = timeDiff(gpsWeek, secsOfWeek, it->week, it->t0);
+      if (age < -maxAge)
+         break;
+      if (it->health != 0.0 || fabs(age) > maxAge)
+         continue;
+
+      // later entries with the same t0 were sent later, so '<=' keeps them
+      if (best == nullptr || fabs(age) <= bestAge)
+      {
+         best = &*it;
+         bestAge = fabs(age);
+      }
+   }
+
+   return best;
+}
+
+
+void SbasStore::evaluate( const SbasEphemeris &eph, long gpsWeek,
+                          double secsOfWeek, SatelliteState &state )
+{
+   double dt = timeDiff(gpsWeek, secsOfWeek, eph.week, eph.t0);
+
+   state.x = eph.pos[0] + (eph.vel[0] + 0.5 * eph.acc[0] * dt) * dt;
+   state.y = eph.pos[1] + (eph.vel[1] + 0.5 * eph.acc[1] * dt) * dt;
+   state.z = eph.pos[2] + (eph.vel[2] + 0.5 * eph.acc[2] * dt) * dt;
+   state.vx = eph.vel[0] + eph.acc[0] * dt;
+   state.vy = eph.vel[1] + eph.acc[1] * dt;
+   state.vz = eph.vel[2] + eph.acc[2] * dt;
+   state.relativistic = 0.0;
+   state.clockBias = eph.clockBias + eph.relFreqBias * dt;
+}
+
+
+bool SbasStore::computeSatellite( int satNum, long gpsWeek, double secsOfWeek,
+                                  double pseudorange, SatelliteData &satellite ) const
+{
+   const SbasEphemeris *eph = select(satNum, gpsWeek, secsOfWeek);
+   if (!eph)
+      return false;
+
+   // transmit time by SV time, then corrected to system time
+   SatelliteState state;
+   double travel = pseudorange / C;
+   evaluate(*eph, gpsWeek, secsOfWeek - travel, state);
+   travel += state.clockBias;
+   evaluate(*eph, gpsWeek, secsOfWeek - travel, state);
+
+   EphemerisStore::toSatelliteData(satNum, 'S', state, travel, satellite);
+   return true;
+}
+
+
+bool SbasStore::isNavigationFile( const std::string& filename )
+{
+   std::ifstream file(filename);
+   std::string line;
+   if (!std::getline(file, line))
+      return false;
+
+   // RINEX 2: "H" in column 21 of RINEX VERSION / TYPE
+   return line.length() > 20 && line[20] == 'H' &&
+          line.find("RINEX VERSION / TYPE") != std::string::npos;
+}
+
+
+size_t SbasStore::getNumEphemerides() const
+{
+   size_t count = 0;
+   for (size_t i = 0; i < tables.size(); ++i)
+      count += tables[i].size();
+   return count;
+}
+
+
+size_t SbasStore::getNumSatellites() const
+{
+   size_t count = 0;
+   for (size_t i = 0; i < tables.size(); ++i)
+      if (!tables[i].empty())
+         count++;
+   return count;
+}
@@ -0,0 +1,102 @@
+// Summary:
+//    SBAS (geostationary) broadcast ephemerides read from RINEX navigation
+//    files of type H.  An SBAS ephemeris is an Earth-fixed state vector
+//    (position, velocity, acceleration) at its reference time t0, so the
+//    satellite position at t is the second-order expansion around t0 and the
+//    clock is aGf0 + aGf1 (t - t0), as in RTCA DO-229 message type 9.  The
+//    file's epochs are in GPS time.
+
+#ifndef SbasStore_H
+#define SbasStore_H
+
+#include <string>
+#include <vector>
+
+#include "EphemerisStore.h"
+
+namespace NGSrinex { class GeostationaryEphemEpoch; }
+
+// One SBAS broadcast ephemeris in SI units
+struct SbasEphemeris
+{
+   int satNum;                    // RINEX satellite number (PRN - 100)
+   long week;                     // GPS week and seconds of week of t0
+   double t0;
+   double clockBias;              // aGf0 (s)
+   double relFreqBias;            // aGf1 (s/s)
+   double frameTime;              // transmission time of message (s of week)
+   double health;
+   double pos[3];                 // position (m)
+   double vel[3];                 // velocity (m/s)
+   double acc[3];                 // acceleration (m/s^2)
+};
+
+class SbasStore
+{
+   public:
+      SbasStore();
+
+      //**
+      // Summary:
+      //    Add the ephemerides of a RINEX SBAS navigation file to the store.
+      //    May be called for several files; duplicates are dropped.
+      //
+      // Arguments:
+      //    filename - The name of the file.
+      //
+      // Returns:
+      //    True if successful and false otherwise.
+      bool load( const std::string& filename );
+
+      //**
+      // Summary:
+      //    Add one ephemeris, keeping its satellite's table sorted by t0.
+      void add( const SbasEphemeris &ephemeris );
+
+      //**
+      // Summary:
+      //    Set the largest |t - t0| for which an ephemeris is used.  The
+      //    default of 6 minutes allows for a missed message-type-9 update.
+      void setMaxAge( double seconds ) { maxAge = seconds; }
+
+      //**
+      // Summary:
+      //    Find the healthy ephemeris with t0 closest to the given time.
+      //
+      // Returns:
+      //    A pointer into the store, or nullptr if no ephemeris is in range.
+      const SbasEphemeris* select( int satNum, long gpsWeek, double secsOfWeek ) const;
+
+      //**
+      // Summary:
+      //    Evaluate the position and clock of an ephemeris.
+      static void evaluate( const SbasEphemeris &ephemeris, long gpsWeek,
+                            double secsOfWeek, SatelliteState &state );
+
+      //**
+      // Summary:
+      //    The SBAS counterpart of EphemerisStore::computeSatellite().
+      //
+      // Returns:
+      //    True if an ephemeris was available.
+      bool computeSatellite( int satNum, long gpsWeek, double secsOfWeek,
+                             double pseudorange, SatelliteData &satellite ) const;
+
+      //**
+      // Summary:
+      //    Check the RINEX VERSION / TYPE record of a file for an SBAS
+      //    navigation file.
+      static bool isNavigationFile( const std::string& filename );
+
+      size_t getNumEphemerides() const;
+      size_t getNumSatellites() const;
+
+      static void fromEphemEpoch( NGSrinex::GeostationaryEphemEpoch &epoch,
+                                  SbasEphemeris &ephemeris );
+
+   private:
+      std::vector< std::vector<SbasEphemeris> >   tables;   // indexed by satNum
+      double                                      maxAge;
+};
+
+#endif //SbasStore_H
@@ -0,0 +1,303 @@
+// Summary:
+//    Contains the implementation of the SolutionWriter and SolutionReader
+//    classes.
+
+#include "SolutionFile.h"
+
+#include <cstring>
+#include <algorithm>
+
+using namespace SolutionFile;
+
+namespace
+{
+   const char MAGIC[8] = { 'S', 'P', 'P', 'S', 'O', 'L', 'C', '\n' };
+   const uint32_t BYTEORDER = 0x01020304;
+
+   // The columns of a solution, in the order of the CSV file; all but the
+   // last are FLOAT64
+   const int NUMFIELDS = NUMFLOATCOLUMNS + 1;
+   const char *const FIELDNAMES[NUMFIELDS] =
+      { "EpochTime", "X", "Y", "Z", "ClockBias", "HDOP", "VDOP", "PDOP", "GDOP",
+        "EastError", "NorthError", "UpError", "NumSats" };
+   const int NUMSATSFIELD = NUMFLOATCOLUMNS;
+
+   size_t padded( size_t bytes )
+   {
+      return (bytes + 7) & ~static_cast<size_t>(7);
+   }
+
+   void fieldValues( const SolutionRow &row, double values[NUMSATSFIELD] )
+   {
+      values[0] = row.epochTime;
+      values[1] = row.x;
+      values[2] = row.y;
+      values[3] = row.z;
+      values[4] = row.cdt;
+      values[5] = row.HDOP;
+      values[6] = row.VDOP;
+      values[7] = row.PDOP;
+      values[8] = row.GDOP;
+      values[9] = row.east;
+      values[10] = row.north;
+      values[11] = row.up;
+   }
+}
+
+
+bool SolutionFile::isSolutionFile( const std::string& filename )
+{
+   std::ifstream file(filename, std::ios::binary);
+   char magic[sizeof(MAGIC)];
+   return file.read(magic, sizeof(magic)) && memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+//=========================== SolutionWriter Class ============================
+
+SolutionWriter::SolutionWriter()
+{
+   chunkRows = DEFAULTCHUNKROWS;
+   numRows = 0;
+}
+
+
+SolutionWriter::~SolutionWriter()
+{
+   if (file.is_open())
+      close();
+}
+
+
+bool SolutionWriter::open( const std::string& filename, unsigned rowsPerChunk )
+{
+   file.open(filename, std::ios::binary | std::ios::trunc);
+   if (!file)
+      return false;
+
+   chunkRows = rowsPerChunk > 0 ? rowsPerChunk : 1;
+   numRows = 0;
+   for (int i = 0; i < NUMSATSFIELD; ++i)
+   {
+      columns[i].clear();
+      columns[i].reserve(chunkRows);
+   }
+   numSats.clear();
+   numSats.reserve(chunkRows);
+
+   FileHeader header;
+   memcpy(header.magic, MAGIC, sizeof(MAGIC));
+   header.byteOrder = BYTEORDER;
+   header.version = VERSION;
+   header.numColumns = NUMFIELDS;
+   header.chunkRows = chunkRows;
+   file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+   for (int i = 0; i < NUMFIELDS; ++i)
+   {
+      ColumnInfo column;
+      memset(column.name, 0, sizeof(column.name));
+      strncpy(column.name, FIELDNAMES[i], sizeof(column.name) - 1);
+      column.type = i == NUMSATSFIELD ? INT32 : FLOAT64;
+      column.width = i == NUMSATSFIELD ? sizeof(int32_t) : sizeof(double);
+      file.write(reinterpret_cast<const char*>(&column), sizeof(column));
+   }
+
+   return file.good();
+}
+
+
+void SolutionWriter::write( const SolutionRow &row )
+{
+   double values[NUMSATSFIELD];
+   fieldValues(row, values);
+   for (int i = 0; i < NUMSATSFIELD; ++i)
+      columns[i].push_back(values[i]);
+   numSats.push_back(row.numSats);
+   numRows++;
+
+   if (numSats.size() >= chunkRows)
+      flush();
+}
+
+
+bool SolutionWriter::close()
+{
+   flush();
+   file.close();
+   return !file.fail();
+}
+
+
+// Write the buffered rows as one chunk: the header, then each column padded
+// to 8 bytes
+void SolutionWriter::flush()
+{
+   if (numSats.empty())
+      return;
+
+   static const char zeros[8] = { 0 };
+   ChunkHeader header;
+   header.numRows = static_cast<uint32_t>(numSats.size());
+   header.reserved = 0;
+   file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+   for (int i = 0; i < NUMSATSFIELD; ++i)
+   {
+      file.write(reinterpret_cast<const char*>(columns[i].data()), columns[i].size() * sizeof(double));
+      columns[i].clear();
+   }
+   size_t bytes = numSats.size() * sizeof(int32_t);
+   file.write(reinterpret_cast<const char*>(numSats.data()), bytes);
+   file.write(zeros, padded(bytes) - bytes);
+   numSats.clear();
+}
+
+//=========================== SolutionReader Class ============================
+
+SolutionReader::SolutionReader()
+{
+   data = nullptr;
+   size = 0;
+   numRows = 0;
+}
+
+
+bool SolutionReader::open( const std::string& filename )
+{
+   if (mapping.open(filename))
+   {
+      data = mapping.getData();
+      size = mapping.getSize();
+   }
+   else
+   {
+      std::ifstream file(filename, std::ios::binary | std::ios::ate);
+      if (!file)
+         return false;
+      buffer.resize(static_cast<size_t>(file.tellg()));
+      file.seekg(0);
+      if (!file.read(buffer.data(), buffer.size()))
+         return false;
+      data = buffer.data();
+      size = buffer.size();
+   }
+
+   FileHeader header;
+   if (size < sizeof(header))
+      return false;
+   memcpy(&header, data, sizeof(header));
+   if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.byteOrder != BYTEORDER ||
+       header.version != VERSION || header.numColumns == 0)
+      return false;
+
+   size_t offset = sizeof(header);
+   if (size - offset < header.numColumns * sizeof(ColumnInfo))
+      return false;
+   schema.resize(header.numColumns);
+   memcpy(schema.data(), data + offset, header.numColumns * sizeof(ColumnInfo));
+   offset += header.numColumns * sizeof(ColumnInfo);
+   for (size_t c = 0; c < schema.size(); ++c)
+      schema[c].name[NAMELENGTH - 1] = '\0';
+
+   // the SolutionRow fields, which must have the types they were written with
+   rowColumns.assign(NUMFIELDS, -1);
+   for (int i = 0; i < NUMFIELDS; ++i)
+   {
+      int column = findColumn(FIELDNAMES[i]);
+      uint32_t type = i == NUMSATSFIELD ? INT32 : FLOAT64;
+      if (column >= 0 && schema[column].type == type)
+         rowColumns[i] = column;
+   }
+
+   // walk the chunks
+   chunks.clear();
+   columnStarts.clear();
+   numRows = 0;
+   while (offset < size)
+   {
+      ChunkHeader chunkHeader;
+      if (size - offset < sizeof(chunkHeader))
+         return false;
+      memcpy(&chunkHeader, data + offset, sizeof(chunkHeader));
+      offset += sizeof(chunkHeader);
+
+      Chunk chunk;
+      chunk.firstRow = numRows;
+      chunk.numRows = chunkHeader.numRows;
+      for (size_t c = 0; c < schema.size(); ++c)
+      {
+         size_t bytes = padded(chunk.numRows * schema[c].width);
+         if (size - offset < bytes)
+            return false;   // truncated
+         columnStarts.push_back(offset);
+         offset += bytes;
+      }
+      chunks.push_back(chunk);
+      numRows += chunk.numRows;
+   }
+
+   return true;
+}
+
+
+int SolutionReader::findColumn( const std::string& name ) const
+{
+   for (size_t c = 0; c < schema.size(); ++c)
+      if (name == schema[c].name)
+         return static_cast<int>(c);
+   return -1;
+}
+
+
+const void* SolutionReader::getColumnChunk( size_t chunk, size_t column, size_t &numChunkRows ) const
+{
+   numChunkRows = chunks[chunk].numRows;
+   return data + columnStarts[chunk * schema.size() + column];
+}
+
+
+bool SolutionReader::readRow( size_t row, SolutionRow &solution ) const
+{
+   if (row >= numRows)
+      return false;
+
+   // chunks are full except the last, so the chunk follows from the row
+   size_t chunk = std::min(row / chunks[0].numRows, chunks.size() - 1);
+   while (row < chunks[chunk].firstRow)
+      chunk--;
+   while (row >= chunks[chunk].firstRow + chunks[chunk].numRows)
+      chunk++;
+   size_t index = row - chunks[chunk].firstRow;
+
+   double values[NUMSATSFIELD];
+   for (int i = 0; i < NUMSATSFIELD; ++i)
+   {
+      if (rowColumns[i] < 0)
+         return false;
+      memcpy(&values[i], data + columnStarts[chunk * schema.size() + rowColumns[i]]
+                                + index * sizeof(double), sizeof(double));
+   }
+   if (rowColumns[NUMSATSFIELD] < 0)
+      return false;
+   int32_t count;
+   memcpy(&count, data + columnStarts[chunk * schema.size() + rowColumns[NUMSATSFIELD]]
+                       + index * sizeof(int32_t), sizeof(int32_t));
+
+   solution.epochTime = values[0];
+   solution.x = values[1];
+   solution.y = values[2];
+   solution.z = values[3];
+   solution.cdt = values[4];
+   solution.HDOP = values[5];
+   solution.VDOP = values[6];
+   solution.PDOP = values[7];
+   solution.GDOP = values[8];
+   solution.east = values[9];
+   solution.north = values[10];
+   solution.up = values[11];
+   solution.numSats = count;
+   solution.iterations = 0;
+   solution.correctionNorm = 0.0;
+   solution.solveSecs = 0.0;
+   return true;
+}
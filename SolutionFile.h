@@ -0,0 +1,182 @@
+// Summary:
+//    Binary columnar solution files.  The file starts with a header and the
+//    schema (name, type and width of every column, in the order of the CSV
+//    solution file), followed by chunks of up to chunkRows epochs.  Within a
+//    chunk each column is stored contiguously, padded to 8 bytes, so a
+//    reader that wants one column of weeks of solutions touches only that
+//    column's bytes.  All values are little-endian and written at full
+//    precision, so a solution read back is identical to the one written.
+//
+//    SolutionWriter buffers a chunk and writes it with one call per column;
+//    SolutionReader maps the file and serves rows or whole column chunks
+//    straight out of the mapping.
+
+#ifndef SolutionFile_H
+#define SolutionFile_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+
+#include "SolutionPool.h"
+#include "rinexio.h"
+
+namespace SolutionFile
+{
+   enum ColumnType { FLOAT64 = 1, INT32 = 2 };
+
+   enum
+   {
+      VERSION = 1,
+      NAMELENGTH = 24,
+      NUMFLOATCOLUMNS = 12,        // the FLOAT64 columns of a solution, before NumSats
+      DEFAULTCHUNKROWS = 4096
+   };
+
+   // "SPPSOLC\n" followed by the fields below
+   struct FileHeader
+   {
+      char magic[8];
+      uint32_t byteOrder;          // 0x01020304 as written
+      uint32_t version;
+      uint32_t numColumns;
+      uint32_t chunkRows;          // rows per chunk; the last may be shorter
+   };
+
+   struct ColumnInfo
+   {
+      char name[NAMELENGTH];       // NUL-padded
+      uint32_t type;               // ColumnType
+      uint32_t width;              // bytes per value
+   };
+
+   struct ChunkHeader
+   {
+      uint32_t numRows;
+      uint32_t reserved;
+   };
+
+   //**
+   // Summary:
+   //    Check the first bytes of a file for a binary solution file.
+   bool isSolutionFile( const std::string& filename );
+}
+
+class SolutionWriter
+{
+   public:
+      SolutionWriter();
+      ~SolutionWriter();
+
+      //**
+      // Summary:
+      //    Create the file and write its header and schema.
+      //
+      // Arguments:
+      //    filename - The name of the file.
+      //    chunkRows - Rows per chunk.
+      //
+      // Returns:
+      //    True if successful and false otherwise.
+      bool open( const std::string& filename,
+                 unsigned chunkRows = SolutionFile::DEFAULTCHUNKROWS );
+
+      //**
+      // Summary:
+      //    Append one epoch, writing the chunk when it is full.
+      void write( const SolutionRow &row );
+
+      //**
+      // Summary:
+      //    Write the last (partial) chunk and close the file.
+      //
+      // Returns:
+      //    True if every write succeeded.
+      bool close();
+
+      unsigned long getNumRows() const { return numRows; }
+
+   private:
+      std::ofstream          file;
+      unsigned               chunkRows;
+      unsigned long          numRows;
+      std::vector<double>    columns[SolutionFile::NUMFLOATCOLUMNS];   // of the chunk, in CSV order
+      std::vector<int32_t>   numSats;
+
+      void flush();
+
+      SolutionWriter( const SolutionWriter & );            // not copyable
+      SolutionWriter &operator=( const SolutionWriter & );
+};
+
+class SolutionReader
+{
+   public:
+      SolutionReader();
+
+      //**
+      // Summary:
+      //    Map (or, where that is not possible, read) a binary solution file
+      //    and index its chunks.
+      //
+      // Returns:
+      //    True if the file is a complete solution file of a known version.
+      bool open( const std::string& filename );
+
+      size_t getNumRows() const { return numRows; }
+      size_t getNumChunks() const { return chunks.size(); }
+      size_t getNumColumns() const { return schema.size(); }
+      const SolutionFile::ColumnInfo& getColumn( size_t column ) const { return schema[column]; }
+
+      //**
+      // Summary:
+      //    Find a column by its CSV name (e.g. "X").
+      //
+      // Returns:
+      //    The column index, or -1 if there is no such column.
+      int findColumn( const std::string& name ) const;
+
+      //**
+      // Summary:
+      //    The values of one column within one chunk, in the mapping.
+      //
+      // Arguments:
+      //    chunk - The chunk.
+      //    column - The column.
+      //    numChunkRows - Receives the number of values.
+      //
+      // Returns:
+      //    A pointer to numChunkRows values of the column's type.
+      const void* getColumnChunk( size_t chunk, size_t column, size_t &numChunkRows ) const;
+
+      //**
+      // Summary:
+      //    Assemble one epoch from the columns.
+      //
+      // Returns:
+      //    False if the row does not exist or the schema lacks a column.
+      bool readRow( size_t row, SolutionRow &solution ) const;
+
+   private:
+      struct Chunk
+      {
+         size_t firstRow;
+         size_t numRows;
+      };
+
+      NGSrinex::MappedLineSource                 mapping;
+      std::vector<char>                          buffer;     // when the file is not mapped
+      const char                                *data;
+      size_t                                     size;
+      std::vector<SolutionFile::ColumnInfo>      schema;
+      std::vector<int>                           rowColumns;      // SolutionRow field order -> column
+      std::vector<Chunk>                         chunks;
+      std::vector<size_t>                        columnStarts;    // [chunk * numColumns + column]
+      size_t                                     numRows;
+
+      SolutionReader( const SolutionReader & );            // not copyable
+      SolutionReader &operator=( const SolutionReader & );
+};
+
+#endif //SolutionFile_H
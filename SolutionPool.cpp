@@ -0,0 +1,125 @@
+// Summary:
+//    Contains the implementation of the SolutionPool class.
+
+#include "SolutionPool.h"
+
+#include <utility>
+
+//========================== SolutionPool Class ===============================
+
+SolutionPool::SolutionPool( unsigned numThreads, SolveFunction solveFunction,
+                            WriteFunction writeFunction, size_t maxPending )
+   : solve(solveFunction), write(writeFunction)
+{
+   if (numThreads == 0)
+      numThreads = std::thread::hardware_concurrency();
+   if (numThreads == 0)
+      numThreads = 1;   // the core count is not known
+   if (maxPending == 0)
+      maxPending = 4 * static_cast<size_t>(numThreads);
+
+   slots.resize(maxPending);
+   for (size_t i = 0; i < slots.size(); ++i)
+      slots[i].state = SLOT_EMPTY;
+
+   nextSubmit = 0;
+   nextTake = 0;
+   nextWrite = 0;
+   stopping = false;
+
+   workers.reserve(numThreads);
+   for (unsigned i = 0; i < numThreads; ++i)
+      workers.push_back(std::thread(&SolutionPool::workerLoop, this));
+}
+
+
+SolutionPool::~SolutionPool()
+{
+   finish();
+
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+   }
+   jobReady.notify_all();
+   for (size_t i = 0; i < workers.size(); ++i)
+      workers[i].join();
+}
+
+
+void SolutionPool::submit( EpochJob &job )
+{
+   std::unique_lock<std::mutex> lock(mutex);
+
+   // write whatever is already finished, then make room for this epoch
+   writeReady(lock, nextSubmit);
+   while (nextSubmit - nextWrite >= slots.size())
+   {
+      rowReady.wait(lock, [this] { return slots[nextWrite % slots.size()].state == SLOT_DONE; });
+      writeReady(lock, nextSubmit);
+   }
+
+   Slot &slot = slots[nextSubmit % slots.size()];
+   std::swap(slot.job, job);
+   slot.state = SLOT_QUEUED;
+   nextSubmit++;
+
+   lock.unlock();
+   jobReady.notify_one();
+}
+
+
+void SolutionPool::finish()
+{
+   std::unique_lock<std::mutex> lock(mutex);
+
+   while (nextWrite < nextSubmit)
+   {
+      rowReady.wait(lock, [this] { return slots[nextWrite % slots.size()].state == SLOT_DONE; });
+      writeReady(lock, nextSubmit);
+   }
+}
+
+
+// Write the finished rows from nextWrite on, stopping at the first one that
+// is still being solved.  The lock is released while writing: a DONE slot is
+// not touched again by the workers until submit() reuses it.
+void SolutionPool::writeReady( std::unique_lock<std::mutex> &lock, unsigned long upTo )
+{
+   while (nextWrite < upTo)
+   {
+      Slot &slot = slots[nextWrite % slots.size()];
+      if (slot.state != SLOT_DONE)
+         break;
+
+      lock.unlock();
+      write(slot.row);
+      lock.lock();
+
+      slot.state = SLOT_EMPTY;
+      nextWrite++;
+   }
+}
+
+
+void SolutionPool::workerLoop()
+{
+   std::unique_lock<std::mutex> lock(mutex);
+
+   for (;;)
+   {
+      jobReady.wait(lock, [this] { return stopping || nextTake < nextSubmit; });
+      if (nextTake >= nextSubmit)
+         return;   // stopping, and nothing is left to solve
+
+      Slot &slot = slots[nextTake % slots.size()];
+      nextTake++;
+
+      lock.unlock();
+      solve(slot.job, slot.row);
+      lock.lock();
+
+      slot.state = SLOT_DONE;
+      rowReady.notify_one();
+   }
+}
@@ -0,0 +1,108 @@
+// Summary:
+//    Epoch-parallel positioning.  The epochs of a session are independent, so
+//    the thread that reads the RINEX file hands each epoch's matched satellites
+//    to a pool of worker threads and gets the solutions back in epoch order,
+//    ready to be written to the solution file as if they were computed inline.
+
+#ifndef SolutionPool_H
+#define SolutionPool_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include "SatPosStore.h"
+
+struct EpochJob
+{
+   double epochTime;
+   std::vector<SatelliteData> satellites;
+   std::vector<double> pseudoranges;   // one per satellite, same order
+   bool warmStart;                     // iterate from start instead of the centre of the Earth
+   double start[4];                    // x, y, z, cdt (m)
+};
+
+struct SolutionRow
+{
+   double epochTime;
+   double x, y, z, cdt;
+   double HDOP, VDOP, PDOP, GDOP;
+   double east, north, up;            // error w.r.t. the reference position
+   int numSats;
+   int iterations;                    // solver statistics
+   double correctionNorm;             // norm of the last state correction (m)
+   double solveSecs;
+};
+
+class SolutionPool
+{
+   public:
+      typedef std::function<void (const EpochJob&, SolutionRow&)> SolveFunction;
+      typedef std::function<void (const SolutionRow&)> WriteFunction;
+
+      //**
+      // Summary:
+      //    Start the worker threads.
+      //
+      // Arguments:
+      //    numThreads - Number of worker threads, or 0 for one per core.
+      //    solve - Computes the solution of one epoch.  Called concurrently
+      //            from the worker threads.
+      //    write - Receives the solutions in submission order.  Always called
+      //            from the thread that calls submit() and finish().
+      //    maxPending - Epochs that may be queued or solved but not yet
+      //                 written, or 0 for four per thread.  This bounds memory.
+      SolutionPool( unsigned numThreads, SolveFunction solve, WriteFunction write,
+                    size_t maxPending = 0 );
+      ~SolutionPool();
+
+      //**
+      // Summary:
+      //    Queue one epoch, writing any solutions that are ready first.  Blocks
+      //    while maxPending epochs are outstanding.
+      //
+      // Arguments:
+      //    job - The epoch.  Its contents are swapped into the pool, and the
+      //          buffers of an earlier job come back so they can be reused.
+      void submit( EpochJob &job );
+
+      //**
+      // Summary:
+      //    Wait for every submitted epoch and write the remaining solutions.
+      void finish();
+
+      unsigned getNumThreads() const { return static_cast<unsigned>(workers.size()); }
+      size_t getMaxPending() const { return slots.size(); }
+
+   private:
+      enum SlotState { SLOT_EMPTY, SLOT_QUEUED, SLOT_DONE };
+
+      struct Slot
+      {
+         EpochJob job;
+         SolutionRow row;
+         SlotState state;
+      };
+
+      SolveFunction              solve;
+      WriteFunction              write;
+      std::vector<std::thread>   workers;
+      std::vector<Slot>          slots;      // ring buffer indexed by seq % size
+      unsigned long              nextSubmit; // sequence numbers of epochs
+      unsigned long              nextTake;
+      unsigned long              nextWrite;
+      bool                       stopping;
+      std::mutex                 mutex;
+      std::condition_variable    jobReady;
+      std::condition_variable    rowReady;
+
+      void workerLoop();
+      void writeReady( std::unique_lock<std::mutex> &lock, unsigned long upTo );
+
+      SolutionPool( const SolutionPool & );            // not copyable
+      SolutionPool &operator=( const SolutionPool & );
+};
+
+#endif //SolutionPool_H
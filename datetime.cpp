@@ -45,6 +45,12 @@ namespace NGSdatetime {
 
 DateTime::DateTime() { mjd = 0; fractionOfDay = 0.0; }
 
+DateTime::DateTime( const DateTime &DT2 )
+{
+   mjd = DT2.mjd;
+   fractionOfDay = DT2.fractionOfDay;
+}
+
 DateTime::DateTime( GPSTime gpstime )
 {
    mjd = gpstime.GPSWeek*7 + gpstime.secsOfWeek/SECPERDAY + JAN61980;
@@ -69,6 +69,7 @@ namespace NGSdatetime {
          DateTime( YMDHMS yearMonthDayHMS );
          DateTime( long year, long month, long day,
 	           long hour, long min, double sec );
+         DateTime( const DateTime &DT2 );
 
          // destructor
          ~DateTime();
@@ -1,351 +1,1639 @@
-// Summary:
-//    Skeleton program to open a RINEX observation file and scroll through all
-//    of the epochs.  Students in ENGO 465 will use this to develop code to compute
-//    a least-squares solution using data from a standalone GPS receiver.
-//
-// History:
-//    Jan 16/13 - Created by Mark Petovello
-//
-// Copyright:
-//    Position, Location And Navigation (PLAN) Group
-//    Department of Geomatics Engineering
-//    Schulich School of Engineering
-//    University of Calgary
-//
-// Disclaimer:
-//    This source code is not freeware nor shareware and is only provided under
-//    an agreement between authorized users/licensees and the University of
-//    Calgary (Position, Location And Navigation (PLAN) Group, Geomatics
-//    Engineering, Schulich School of Engineering) and may only be used under
-//    the terms and conditions set forth therein.
-
-#include <iostream>
-#include <fstream>
-#include <iomanip>
-#include <cmath>
-#include "rinex.h"
-#include "NRinexUtils.h"
-
-#include <Eigen/Dense> //added by @Talha
-
-using namespace std;
-using namespace NGSrinex;
-
-struct SatelliteData
-{
-   int prn;
-   double x, y, z, correction;
-};
-
-struct EpochData
-{
-   double epoch;
-   int numSatellites;
-   std::vector<SatelliteData> satellites;
-};
-
-struct ReceiverState
-{
-   double x, y, z, cdt; // Initial receiver guess (position + clock bias)
-};
-
-std::vector<EpochData> readSatelliteDataAtEachEpoch(const std::string &filename)
-{
-   std::ifstream file(filename);
-   if (!file.is_open())
-   {
-      std::cerr << "Error opening file: " << filename << "\n";
-      return {};
-   }
-
-   std::vector<EpochData> allEpochs;
-   std::string line;
-
-   while (std::getline(file, line))
-   {
-      std::istringstream iss(line);
-      EpochData epochData;
-
-      // Read the epoch and number of satellites
-      if (!(iss >> epochData.epoch >> epochData.numSatellites))
-      {
-         std::cerr << "Error reading epoch line.\n";
-         return {};
-      }
-
-      // Read satellite data for this epoch
-      for (int i = 0; i < epochData.numSatellites; ++i)
-      {
-         if (!std::getline(file, line))
-         {
-            std::cerr << "Unexpected end of file while reading satellite data.\n";
-            return {};
-         }
-
-         std::istringstream satStream(line);
-         SatelliteData sat;
-         if (!(satStream >> sat.prn >> sat.x >> sat.y >> sat.z >> sat.correction))
-         {
-            std::cerr << "Error reading satellite data.\n";
-            return {};
-         }
-
-         epochData.satellites.push_back(sat);
-      }
-
-      allEpochs.push_back(epochData);
-   }
-
-   file.close();
-   return allEpochs;
-}
-
-const EpochData *findEpoch(const std::vector<EpochData> &epochs, double epoch)
-{
-   for (const auto &e : epochs)
-   {
-      if (e.epoch == epoch)
-         return &e; // Return pointer to found epoch
-   }
-   return nullptr; // Return nullptr if not found
-}
-
-// Compute Design Matrix and Misclosure Vector
-void computeDesignMatrixAndMisclosure(
-    const std::vector<SatelliteData> &satellites,
-    const std::vector<double> &pseudoranges,
-    const ReceiverState &receiver,
-    Eigen::MatrixXd &A,
-    Eigen::VectorXd &w)
-{
-   int numSat = satellites.size();
-   A = Eigen::MatrixXd(numSat, 4);
-   w = Eigen::VectorXd(numSat);
-
-   for (int i = 0; i < numSat; ++i)
-   {
-      const SatelliteData &sat = satellites[i];
-
-      // Compute geometric range (ρ_0)
-      double rho_0 = sqrt(pow(receiver.x - sat.x, 2) +
-                          pow(receiver.y - sat.y, 2) +
-                          pow(receiver.z - sat.z, 2));
-
-      // Compute design matrix row
-      A(i, 0) = (receiver.x - sat.x) / rho_0;
-      A(i, 1) = (receiver.y - sat.y) / rho_0;
-      A(i, 2) = (receiver.z - sat.z) / rho_0;
-      A(i, 3) = -1;
-
-      // Compute misclosure vector (w)
-      double correctedPseudorange = pseudoranges[i] - sat.correction;
-      w(i) = (rho_0 - receiver.cdt) - correctedPseudorange;
-   }
-}
-Eigen::Vector3d computeENUError(
-    double x_est, double y_est, double z_est,
-    double x_ref, double y_ref, double z_ref,
-    double lat_deg, double lon_deg)
-{
-    // Convert lat/lon to radians
-    double lat = lat_deg * M_PI / 180.0;
-    double lon = lon_deg * M_PI / 180.0;
-
-    // Position difference in ECEF
-    Eigen::Vector3d d_xyz;
-    d_xyz << x_est - x_ref,
-             y_est - y_ref,
-             z_est - z_ref;
-
-    // Rotation matrix from ECEF to ENU
-    double sinLat = sin(lat);
-    double cosLat = cos(lat);
-    double sinLon = sin(lon);
-    double cosLon = cos(lon);
-
-    Eigen::Matrix3d R_enu;
-    R_enu << -sinLon,             cosLon,              0,
-            -sinLat * cosLon, -sinLat * sinLon,  cosLat,
-             cosLat * cosLon,  cosLat * sinLon,  sinLat;
-
-    return R_enu * d_xyz;
-}
-
-
-void leastSquaresSolution(
-   std::vector<SatelliteData> &satellites,
-   std::vector<double> &pseudoranges,
-   std::ofstream &outputFile,
-   double epochTime
-)
-{
-   ReceiverState receiver = {0.0, 0.0, 0.0, 0.0};
-   int maxIterations = 100;
-   double threshold = 1e-5;
-   Eigen::VectorXd dR(4);
-   Eigen::MatrixXd N;
-   int numSats = satellites.size();
-
-
-   for (int iter = 0; iter < maxIterations; ++iter)
-   {
-       Eigen::MatrixXd A;
-       Eigen::VectorXd w;
-
-       computeDesignMatrixAndMisclosure(satellites, pseudoranges, receiver, A, w);
-
-       Eigen::MatrixXd P = Eigen::MatrixXd::Identity(A.rows(), A.rows());
-       N = A.transpose() * P * A;
-       Eigen::VectorXd U = A.transpose() * P * w;
-       dR = -N.inverse() * U;
-
-       receiver.x += dR(0);
-       receiver.y += dR(1);
-       receiver.z += dR(2);
-       receiver.cdt += dR(3);
-
-       if (dR.norm() < threshold)
-           break;
-   }
-
-   // Compute DOPs after convergence
-   Eigen::MatrixXd Qx = N.inverse();
-
-   // Convert to radians
-   double latitude = 51.0785;
-   double longitude = -114.1368;
-   double latRad = latitude * M_PI / 180.0;
-   double lonRad = longitude * M_PI / 180.0;
-
-   double sinLat = sin(latRad);
-   double cosLat = cos(latRad);
-   double sinLon = sin(lonRad);
-   double cosLon = cos(lonRad);
-
-   Eigen::Matrix4d R;
-   R << -sinLat * cosLon, -sinLat * sinLon, cosLat, 0,
-         sinLon,           cosLon,          0,      0,
-         cosLat * cosLon,  cosLat * sinLon, sinLat, 0,
-         0,                0,               0,      1;
-
-   Eigen::MatrixXd QL = R * Qx * R.transpose();
-
-   double NDOP = sqrt(QL(0, 0));
-   double EDOP = sqrt(QL(1, 1));
-   double VDOP = sqrt(QL(2, 2));
-   double TDOP = sqrt(QL(3, 3));
-   double HDOP = sqrt(NDOP * NDOP + EDOP * EDOP);
-   double PDOP = sqrt(HDOP * HDOP + VDOP * VDOP);
-   double GDOP = sqrt(HDOP * HDOP + VDOP * VDOP + TDOP * TDOP);
-
-   // Reference ECEF coordinates (true position)
-   const double X_ref = -1641890.118;
-   const double Y_ref = -3664879.354;
-   const double Z_ref =  4939969.421;
-
-   // Reference lat/lon (needed for ENU)
-   double lat_ref = 51.0785;
-   double lon_ref = -114.1368;
-
-   // Compute ENU error vector
-   Eigen::Vector3d enu_error = computeENUError(
-       receiver.x, receiver.y, receiver.z,
-       X_ref, Y_ref, Z_ref,
-       lat_ref, lon_ref);
-
-       outputFile << std::fixed << std::setprecision(6)
-           << epochTime << ","
-           << receiver.x << "," << receiver.y << "," << receiver.z << "," << receiver.cdt << ","
-           << HDOP << "," << VDOP << "," << PDOP << "," << GDOP << ","
-           << enu_error(0) << "," << enu_error(1) << "," << enu_error(2) << "," << numSats << "\n";
-}
-
-// Main processing loop
-int main(int argc, char *argv[])
-{
-   string obsFilename = "../data/obsdata.22o";
-   string satFilename = "../data/satpos.txt";
-   string outputFilename = "../result/solution.txt";
-
-   std::vector<EpochData> epochs = readSatelliteDataAtEachEpoch(satFilename);
-
-   ofstream outputFile(outputFilename);
-   if (!outputFile)
-   {
-      cout << "Could not open output file... quitting." << endl;
-      return 0;
-   }
-   outputFile << "EpochTime,X,Y,Z,ClockBias,HDOP,VDOP,PDOP,GDOP,EastError,NorthError,UpError,NumSats\n";
-
-   RinexObsFile inObsFile;
-   if (!NRinexUtils::OpenRinexObservationFileForInput(inObsFile, obsFilename))
-   {
-      cout << "Could not open input observation file \"" << obsFilename << "\"...quitting." << endl;
-      return 0;
-   }
-
-   NGSrinex::ObsEpoch currentRinexObs;
-
-   try
-   {
-      while (inObsFile.readEpoch(currentRinexObs) != 0)
-      {
-         double obsTime = currentRinexObs.getEpochTime().GetGPSTime().secsOfWeek;
-
-         std::vector<double> pseudoranges;
-         std::vector<int> prns;
-
-         for (unsigned short i = 0; i < currentRinexObs.getNumSat(); ++i)
-         {
-            NGSrinex::SatObsAtEpoch satObs = currentRinexObs.getSatListElement(i);
-
-            if (satObs.satCode != 'G')
-               continue;
-
-            for (unsigned short j = 0; j < MAXOBSTYPES; ++j)
-            {
-               if (satObs.obsList[j].obsType != C1)
-                  continue;
-               if (!satObs.obsList[j].obsPresent)
-                  continue;
-
-               prns.push_back(satObs.satNum);
-               pseudoranges.push_back(satObs.obsList[j].observation);
-            }
-         }
-
-         if (pseudoranges.empty())
-            continue;
-
-         const EpochData *result = findEpoch(epochs, obsTime);
-         if (!result)
-         {
-            continue;
-         }
-
-         std::vector<SatelliteData> matchedSatellites;
-         for (const auto &sat : result->satellites)
-         {
-            if (std::find(prns.begin(), prns.end(), sat.prn) != prns.end())
-            {
-               matchedSatellites.push_back(sat);
-            }
-         }
-
-         if (matchedSatellites.size() < 4)
-         {
-            std::cout << "Not enough satellites for epoch " << obsTime << "\n";
-            continue;
-         }
-
-         // Call Least Squares solution
-         leastSquaresSolution(matchedSatellites, pseudoranges, outputFile, obsTime);
-      }
-   }
-   catch (RinexReadingException &readingExcep)
-   {
-      cout << "RinexReadingException: " << readingExcep.getMessage() << endl;
-   }
-
-   return 0;
-}
\ No newline at end of file
+// Summary:
+//    Skeleton program to open a RINEX observation file and scroll through all
+//    of the epochs.  Students in ENGO 465 will use this to develop code to compute
+//    a least-squares solution using data from a standalone GPS receiver.
+//
+// History:
+//    Jan 16/13 - Created by Mark Petovello
+//
+// Copyright:
+//    Position, Location And Navigation (PLAN) Group
+//    Department of Geomatics Engineering
+//    Schulich School of Engineering
+//    University of Calgary
+//
+// Disclaimer:
+//    This source code is not freeware nor shareware and is only provided under
+//    an agreement between authorized users/licensees and the University of
+//    Calgary (Position, Location And Navigation (PLAN) Group, Geomatics
+//    Engineering, Schulich School of Engineering) and may only be used under
+//    the terms and conditions set forth therein.
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <cmath>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <filesystem>
+#include <cstdio>
+#include "rinex.h"
+#include "NRinexUtils.h"
+#include "SatPosStore.h"
+#include "SolutionPool.h"
+#include "EphemerisStore.h"
+#include "EphemerisBatch.h"
+#include "OrbitCache.h"
+#include "GlonassStore.h"
+#include "SbasStore.h"
+#include "ClockStore.h"
+#include "SolutionFile.h"
+#include "ParallelObsReader.h"
+#include "ObsCache.h"
+#include "LeastSquares.h"
+
+#include <Eigen/Dense> //added by @Talha
+
+using namespace std;
+using namespace NGSrinex;
+
+// Where each epoch's iteration starts
+enum WarmStart
+{
+   WARMSTART_NONE,       // the centre of the Earth
+   WARMSTART_PREVIOUS,   // the previous epoch's solution
+   WARMSTART_APPROX      // the APPROX POSITION XYZ of the observation file
+};
+
+// Which solution files a job writes
+enum OutputFormat
+{
+   OUTPUT_CSV,           // the CSV solution file
+   OUTPUT_BINARY,        // a binary columnar file (SolutionFile.h) next to it instead
+   OUTPUT_BOTH
+};
+
+// The pillar that obsdata.22o was collected on
+const ReferencePosition DEFAULT_REFERENCE =
+   { -1641890.118, -3664879.354, 4939969.421, 51.0785, -114.1368 };
+
+// One positioning run: an observation file, its satellite positions and the
+// solution file to write
+struct JobConfig
+{
+   string obsFilename;
+   string satFilename;       // satpos.txt or a RINEX navigation file
+   string outputFilename;
+   ReferencePosition reference;
+   bool streamSatPos;        // merge-join satpos.txt instead of loading it
+   int numThreads;           // -1 = solve inline, 0 = one thread per core
+   int parseThreads;         // -1 = parse on the main thread, 0 = one thread per core
+   bool obsCache;            // read the epochs from, or write them to, obsFilename.obscache
+   double memoryBudgetMB;    // 0 = no limit
+   bool interpolateOrbits;   // navigation files: use an OrbitCache
+   string glonassFilename;   // GLONASS navigation file, or empty for GPS only
+   string sbasFilename;      // SBAS navigation file, or empty
+   bool staticFilter;        // recursive static solution instead of epoch by epoch
+   WarmStart warmStart;      // where the epoch-by-epoch iteration starts
+   bool writeSolverStats;    // per-epoch solver statistics next to the solution file
+   OutputFormat outputFormat;
+   string clockFilename;     // RINEX clock file replacing the satellite clocks, or empty
+   int clockPoints;          // records per clock interpolation, 2 = linear
+   bool timeWindow;          // solve only the epochs from windowStart to windowEnd,
+   double windowStart;       //   in seconds of the first epoch's GPS week
+   double windowEnd;
+   bool quiet;               // no per-epoch console messages
+};
+
+struct JobReport
+{
+   bool ok;
+   string message;           // why the job failed
+   unsigned long numEpochs;  // epochs read from the observation file
+   unsigned long numSolved;
+   unsigned long numWarnings;
+   bool streamedSatPos;
+   bool usedEphemeris;       // satellites computed from a navigation file
+   unsigned long numIterations;   // summed over the solved epochs
+   double solveSecs;
+   double secs;
+};
+
+// Noise model of the static filter
+const double FILTER_RANGESIGMA = 3.0;       // pseudorange (m)
+const double FILTER_CLOCKNOISE = 100.0;     // receiver clock random walk (m^2/s)
+const double FILTER_BIASNOISE = 1e-4;       // inter-system bias random walk (m^2/s)
+const double FILTER_INITVARIANCE = 1e12;    // of every state before the first epoch (m^2)
+const double FILTER_MAXONESTEP = 1e6;       // position variance up to which one linearisation is enough (m^2)
+
+// State of the recursive static solution: a fixed position, a random-walk
+// receiver clock and random-walk inter-system biases, with their covariance
+// carried from epoch to epoch.  The clock states always cover every system
+// of SYSTEMCODES, so a system leaving view and coming back keeps its bias.
+struct StaticFilter
+{
+   bool initialised;
+   double lastEpochTime;
+   ReceiverState state;
+   StateMatrix P;               // MAXSTATES x MAXSTATES covariance (m^2)
+};
+
+// One epoch of the static filter.  The covariance is propagated to the
+// epoch, then the state is updated in information form,
+//    (s^2 P^-1 + A^T A) dx = -(A^T w + s^2 P^-1 (x - x_predicted)),
+// with s the pseudorange sigma, linearised once at the predicted state.
+// Only while the position is still unknown (the first epoch starts from the
+// centre of the Earth) is the update iterated to convergence.  Epochs must
+// be given in time order.
+void staticFilterSolution(
+   StaticFilter &filter,
+   const std::vector<SatelliteData> &satellites,
+   const std::vector<double> &pseudoranges,
+   double epochTime,
+   const ReferencePosition &reference,
+   SolutionRow &row
+)
+{
+   auto solveStart = std::chrono::steady_clock::now();
+   const double threshold = 1e-5;
+   const double sigma2 = FILTER_RANGESIGMA * FILTER_RANGESIGMA;
+   const std::vector<double> unitWeights;   // P = I, the prior is scaled instead
+   const StateMatrix I = StateMatrix::Identity(MAXSTATES, MAXSTATES);
+   SystemStates allSystems;
+   allSystems.numSystems = MAXSYSTEMS;
+   for (int k = 0; k < MAXSYSTEMS; ++k)
+      allSystems.clockIndex[k] = k;
+
+   if (!filter.initialised)
+   {
+      filter.state = {0.0, 0.0, 0.0, 0.0, {0.0, 0.0, 0.0}};
+      filter.P = FILTER_INITVARIANCE * I;
+      filter.lastEpochTime = epochTime;
+      filter.initialised = true;
+   }
+
+   // predict: the position is static, the clocks random walk
+   double dt = epochTime - filter.lastEpochTime;
+   if (dt < 0.0)
+      dt += 604800.0;   // week rollover
+   filter.P(3, 3) += FILTER_CLOCKNOISE * dt;
+   for (int k = 4; k < MAXSTATES; ++k)
+      filter.P(k, k) += FILTER_BIASNOISE * dt;
+   filter.lastEpochTime = epochTime;
+
+   Eigen::LDLT<StateMatrix> ldlt(MAXSTATES);
+   ldlt.compute(filter.P);
+   StateMatrix prior = sigma2 * ldlt.solve(I);
+   const ReceiverState predicted = filter.state;
+   ReceiverState &x = filter.state;
+   StateVector offset(MAXSTATES);
+   StateVector dR;
+   StateVector U;
+   StateMatrix N;
+
+   int maxIterations = filter.P(0, 0) + filter.P(1, 1) + filter.P(2, 2) > FILTER_MAXONESTEP ? 100 : 1;
+   int iterations = 0;
+   for (int iter = 0; iter < maxIterations; ++iter)
+   {
+      iterations++;
+      accumulateNormalEquations(satellites, pseudoranges, unitWeights, x, allSystems, N, U);
+
+      offset(0) = x.x - predicted.x;
+      offset(1) = x.y - predicted.y;
+      offset(2) = x.z - predicted.z;
+      offset(3) = x.cdt - predicted.cdt;
+      for (int k = 1; k < MAXSYSTEMS; ++k)
+         offset(3 + k) = x.systemCdt[k - 1] - predicted.systemCdt[k - 1];
+      N += prior;
+      U.noalias() += prior * offset;
+
+      ldlt.compute(N);
+      dR = -ldlt.solve(U);
+
+      x.x += dR(0);
+      x.y += dR(1);
+      x.z += dR(2);
+      x.cdt += dR(3);
+      for (int k = 1; k < MAXSYSTEMS; ++k)
+         x.systemCdt[k - 1] += dR(3 + k);
+
+      if (dR.norm() < threshold)
+         break;
+   }
+   filter.P = sigma2 * ldlt.solve(I);
+
+   // DOPs of the epoch's own geometry, as for the single-epoch solution
+   SystemStates systems;
+   findSystemStates(satellites, systems);
+   int numStates = 3 + systems.numSystems;
+   accumulateNormalEquations(satellites, pseudoranges, unitWeights, x, systems, N, U);
+   ldlt.compute(N);
+   StateMatrix Qfull = ldlt.solve(StateMatrix::Identity(numStates, numStates));
+   Eigen::Matrix4d Qx = Qfull.topLeftCorner<4, 4>();
+   completeSolutionRow(x, Qx, epochTime, satellites.size(), reference, row);
+
+   row.iterations = iterations;
+   row.correctionNorm = dR.norm();
+   row.solveSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - solveStart).count();
+}
+
+// One CSV solution line, formatted in place and written with one call
+void writeSolutionRow(std::ostream &outputFile, RecordFormatter &record, const SolutionRow &row)
+{
+       const double values[] = { row.epochTime, row.x, row.y, row.z, row.cdt,
+                                 row.HDOP, row.VDOP, row.PDOP, row.GDOP,
+                                 row.east, row.north, row.up };
+       record.clear();
+       for (double value : values)
+       {
+           record.appendFixed(value, 0, 6);
+           record.append(',');
+       }
+       record.appendInt(row.numSats);
+       record.append('\n');
+       record.flush(outputFile);
+}
+
+// The same line through ostream insertions, as written before
+// RecordFormatter; kept as the reference for --bench-format
+void writeSolutionRowStream(std::ostream &outputFile, const SolutionRow &row)
+{
+       outputFile << std::fixed << std::setprecision(6)
+           << row.epochTime << ","
+           << row.x << "," << row.y << "," << row.z << "," << row.cdt << ","
+           << row.HDOP << "," << row.VDOP << "," << row.PDOP << "," << row.GDOP << ","
+           << row.east << "," << row.north << "," << row.up << "," << row.numSats << "\n";
+}
+
+void writeSolverStatsRow(std::ofstream &statsFile, const SolutionRow &row)
+{
+       statsFile << std::fixed << std::setprecision(6)
+           << row.epochTime << "," << row.iterations << ","
+           << std::scientific << std::setprecision(3) << row.correctionNorm << ","
+           << std::fixed << std::setprecision(1) << row.solveSecs * 1e6 << "\n";
+}
+
+// A file next to the solution file: solution.txt -> solution<suffix><extension>,
+// where an empty extension keeps the solution file's
+string siblingFilename(const string &outputFilename, const string &suffix, const string &extension)
+{
+   size_t slash = outputFilename.find_last_of("/\\");
+   size_t dot = outputFilename.find_last_of('.');
+   if (dot == string::npos || (slash != string::npos && dot < slash))
+      dot = outputFilename.length();
+   return outputFilename.substr(0, dot) + suffix
+        + (extension.empty() ? outputFilename.substr(dot) : extension);
+}
+
+// Print a binary solution file as the CSV solution file it replaces
+bool dumpBinarySolution(const string &filename)
+{
+   SolutionReader reader;
+   if (!reader.open(filename))
+   {
+      cout << "Could not read binary solution file \"" << filename << "\"...quitting." << endl;
+      return false;
+   }
+
+   cout << "EpochTime,X,Y,Z,ClockBias,HDOP,VDOP,PDOP,GDOP,EastError,NorthError,UpError,NumSats\n";
+   SolutionRow row;
+   RecordFormatter record;
+   for (size_t i = 0; i < reader.getNumRows(); ++i)
+   {
+      if (!reader.readRow(i, row))
+         return false;
+      writeSolutionRow(cout, record, row);
+   }
+   return true;
+}
+
+// Fold one decoded observation into an FNV-1a checksum.
+static void hashObservation(unsigned long long &hash, double value,
+                            unsigned short lli, unsigned short sigStrength)
+{
+   unsigned long long bits;
+   memcpy(&bits, &value, sizeof(bits));
+   hash = (hash ^ bits) * 1099511628211ULL;
+   hash = (hash ^ lli) * 1099511628211ULL;
+   hash = (hash ^ sigStrength) * 1099511628211ULL;
+}
+
+// Fold the observations of a batch into the checksum, satellite by satellite
+// as for an ObsEpoch.
+static void hashBatch(unsigned long long &hash, NGSrinex::ObsBatch &batch,
+                      unsigned short numTypes)
+{
+   for (unsigned short i = 0; i < batch.getNumSat(); ++i)
+   {
+      for (unsigned short j = 0; j < numTypes; ++j)
+      {
+         if (batch.getPresent(j)[i])
+            hashObservation(hash, batch.getValues(j)[i],
+                            batch.getLLI(j)[i], batch.getSigStrength(j)[i]);
+      }
+      hash = (hash ^ batch.getSatNums()[i]) * 1099511628211ULL;
+   }
+}
+
+// Fold the GPS C1 observations of a batch into the checksum
+static void hashGpsC1(unsigned long long &hash, NGSrinex::ObsBatch &batch)
+{
+   int c1 = batch.findObsType(C1);
+   if (c1 < 0)
+      return;
+   for (unsigned short i = 0; i < batch.getNumSat(); ++i)
+   {
+      char code = batch.getSatCodes()[i];
+      if ((code == 'G' || code == ' ') && batch.getPresent(c1)[i])
+         hashObservation(hash, batch.getValues(c1)[i],
+                         batch.getLLI(c1)[i], batch.getSigStrength(c1)[i]);
+   }
+}
+
+// Parse the observation file with the legacy (substr + strtod) and the fast
+// (in-place fixed-point) field decoders, reading through ifstream and through
+// a memory mapping, into ObsEpoch records and into ObsBatch columns, and in
+// byte ranges on 1, 2, 4... threads up to the core count, and from an
+// observation cache, and report epochs/sec for each.  A checksum over every
+// decoded observation confirms that all of them produce the same bits.  A
+// projection to GPS C1, as decoded for positioning, is checked against the
+// C1 values of a full decode.
+void benchmarkRinexParsing(const string &obsFilename)
+{
+   const int numRuns = 5;
+   const struct { bool fastParse; bool memoryMap; bool batch; const char *name; } configs[] =
+   {
+      { false, false, false, "legacy decoder, ifstream, ObsEpoch" },
+      { true,  false, false, "fast decoder,   ifstream, ObsEpoch" },
+      { true,  true,  false, "fast decoder,   mmap,     ObsEpoch" },
+      { true,  true,  true,  "fast decoder,   mmap,     ObsBatch" },
+   };
+   const int numConfigs = sizeof(configs) / sizeof(configs[0]);
+   unsigned long long checksum[numConfigs];
+   bool identical = true;
+
+   for (int c = 0; c < numConfigs; ++c)
+   {
+      double bestSecs = 0.0;
+      unsigned long numEpochs = 0;
+
+      for (int run = 0; run < numRuns; ++run)
+      {
+         RinexObsFile inObsFile;
+         inObsFile.setUseMemoryMap(configs[c].memoryMap);
+         if (!NRinexUtils::OpenRinexObservationFileForInput(inObsFile, obsFilename))
+         {
+            cout << "Could not open input observation file \"" << obsFilename << "\"...quitting." << endl;
+            return;
+         }
+         inObsFile.setFastParse(configs[c].fastParse);
+
+         NGSrinex::ObsEpoch epoch;
+         NGSrinex::ObsBatch batch;
+         unsigned short numTypes = inObsFile.getNumObsTypes();
+         unsigned long long hash = 1469598103934665603ULL;   // FNV-1a
+         numEpochs = 0;
+
+         auto start = std::chrono::steady_clock::now();
+         if (configs[c].batch)
+         {
+            while (inObsFile.readEpoch(batch) != 0)
+            {
+               hashBatch(hash, batch, numTypes);
+               numEpochs++;
+            }
+         }
+         else
+         {
+            while (inObsFile.readEpoch(epoch) != 0)
+            {
+               for (unsigned short i = 0; i < epoch.getNumSat(); ++i)
+               {
+                  const NGSrinex::SatObsAtEpoch &satObs = epoch.getSatListElementRef(i);
+                  for (unsigned short j = 0; j < numTypes; ++j)
+                  {
+                     if (satObs.obsList[j].obsPresent)
+                        hashObservation(hash, satObs.obsList[j].observation,
+                                        satObs.obsList[j].LLI, satObs.obsList[j].sigStrength);
+                  }
+                  hash = (hash ^ satObs.satNum) * 1099511628211ULL;
+               }
+               numEpochs++;
+            }
+         }
+         double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+         if (run == 0 || secs < bestSecs)
+            bestSecs = secs;
+         checksum[c] = hash;
+      }
+
+      identical = identical && checksum[c] == checksum[0];
+      cout << configs[c].name << ": " << numEpochs << " epochs, "
+           << std::fixed << std::setprecision(0) << numEpochs / bestSecs << " epochs/sec"
+           << " (best of " << numRuns << ")" << endl;
+   }
+
+   // only GPS C1 decoded
+   {
+      unsigned long long fullHash = 1469598103934665603ULL;
+      unsigned long long hash = 0;
+      double bestSecs = 0.0;
+      unsigned long numEpochs = 0;
+
+      for (int run = 0; run <= numRuns; ++run)
+      {
+         RinexObsFile inObsFile;
+         if (!NRinexUtils::OpenRinexObservationFileForInput(inObsFile, obsFilename))
+         {
+            cout << "Could not open input observation file \"" << obsFilename << "\"...quitting." << endl;
+            return;
+         }
+         NGSrinex::ObsBatch batch;
+         if (run == 0)
+         {
+            while (inObsFile.readEpoch(batch) != 0)
+               hashGpsC1(fullHash, batch);
+            continue;
+         }
+
+         inObsFile.setProjection("G", std::vector<OBSTYPE>(1, C1));
+         hash = 1469598103934665603ULL;
+         numEpochs = 0;
+         auto start = std::chrono::steady_clock::now();
+         while (inObsFile.readEpoch(batch) != 0)
+         {
+            hashGpsC1(hash, batch);
+            numEpochs++;
+         }
+         double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+         if (run == 1 || secs < bestSecs)
+            bestSecs = secs;
+      }
+
+      identical = identical && hash == fullHash;
+      cout << "fast decoder,   mmap,     ObsBatch, GPS C1 only: " << numEpochs << " epochs, "
+           << std::fixed << std::setprecision(0) << numEpochs / bestSecs << " epochs/sec"
+           << " (best of " << numRuns << ")" << endl;
+   }
+
+   // ranges of a quarter of the file per thread, as for --parse-threads
+   unsigned maxThreads = std::max(2u, std::thread::hardware_concurrency());
+   for (unsigned numThreads = 1; numThreads <= maxThreads; numThreads *= 2)
+   {
+      double bestSecs = 0.0;
+      unsigned long numEpochs = 0;
+      unsigned long long hash = 0;
+      size_t numRanges = 0;
+
+      for (int run = 0; run < numRuns; ++run)
+      {
+         RinexObsFile inObsFile;
+         ParallelObsReader reader;
+         if (!NRinexUtils::OpenRinexObservationFileForInput(inObsFile, obsFilename) ||
+             !reader.open(inObsFile, numThreads))
+         {
+            cout << "Could not map input observation file \"" << obsFilename << "\"...quitting." << endl;
+            return;
+         }
+
+         NGSrinex::ObsBatch batch;
+         unsigned short numTypes = inObsFile.getNumObsTypes();
+         hash = 1469598103934665603ULL;
+         numEpochs = 0;
+         numRanges = reader.getNumRanges();
+
+         auto start = std::chrono::steady_clock::now();
+         while (reader.readEpoch(batch) != 0)
+         {
+            hashBatch(hash, batch, numTypes);
+            numEpochs++;
+         }
+         double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+         if (run == 0 || secs < bestSecs)
+            bestSecs = secs;
+      }
+
+      identical = identical && hash == checksum[0];
+      cout << "fast decoder,   mmap,     " << numThreads << (numThreads == 1 ? " thread " : " threads")
+           << ": " << numEpochs << " epochs, " << std::fixed << std::setprecision(0)
+           << numEpochs / bestSecs << " epochs/sec (" << numRanges << " ranges, best of "
+           << numRuns << ")" << endl;
+   }
+
+   // the epochs written to an observation cache and read back from it
+   {
+      string cacheFilename = obsFilename + ".bench.obscache";
+      RinexObsFile inObsFile;
+      ObsCache::SourceStamp stamp;
+      ObsCacheWriter writer;
+      if (!NRinexUtils::OpenRinexObservationFileForInput(inObsFile, obsFilename) ||
+          !ObsCache::stampSource(obsFilename, stamp) ||
+          !writer.open(cacheFilename, stamp, inObsFile))
+      {
+         cout << "Could not write observation cache \"" << cacheFilename << "\"...quitting." << endl;
+         return;
+      }
+      NGSrinex::ObsBatch batch;
+      unsigned short numTypes = inObsFile.getNumObsTypes();
+      while (inObsFile.readEpoch(batch) != 0)
+         writer.write(batch);
+      bool written = writer.close(inObsFile.getNumberWarnings());
+
+      double bestSecs = 0.0;
+      unsigned long numEpochs = 0;
+      unsigned long long hash = 0;
+      size_t cacheSize = 0;
+      for (int run = 0; written && run < numRuns; ++run)
+      {
+         ObsCacheReader reader;
+         if (!reader.open(cacheFilename, stamp))
+         {
+            written = false;
+            break;
+         }
+         hash = 1469598103934665603ULL;
+         numEpochs = 0;
+         cacheSize = reader.getSize();
+
+         auto start = std::chrono::steady_clock::now();
+         while (reader.readEpoch(batch) != 0)
+         {
+            hashBatch(hash, batch, numTypes);
+            numEpochs++;
+         }
+         double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+         if (run == 0 || secs < bestSecs)
+            bestSecs = secs;
+      }
+      std::remove(cacheFilename.c_str());
+      if (!written)
+      {
+         cout << "Could not write observation cache \"" << cacheFilename << "\"...quitting." << endl;
+         return;
+      }
+
+      std::error_code error;
+      double textSize = static_cast<double>(std::filesystem::file_size(obsFilename, error));
+      identical = identical && hash == checksum[0];
+      cout << "observation cache, mmap:  " << numEpochs << " epochs, " << std::fixed
+           << std::setprecision(0) << numEpochs / bestSecs << " epochs/sec ("
+           << std::setprecision(1) << 100.0 * cacheSize / textSize << "% of the text, best of "
+           << numRuns << ")" << endl;
+   }
+
+   cout << "Decoded values " << (identical ? "identical" : "DIFFER")
+        << " (checksum " << std::hex << checksum[0] << std::dec << ")" << endl;
+}
+
+// Read a whole file into a string, for comparing output files
+static string readWholeFile(const string &filename)
+{
+   std::ifstream file(filename, std::ios::binary);
+   std::ostringstream contents;
+   contents << file.rdbuf();
+   return contents.str();
+}
+
+// Write the epochs of the observation file with RinexObsFile::writeEpoch and
+// a run of solution rows with writeSolutionRow, each through ostream
+// insertions and through RecordFormatter, and report records/sec for each.
+// The two formatters must produce the same bytes.
+void benchmarkFormatting(const string &obsFilename)
+{
+   const int numRuns = 5;
+   RinexObsFile obsFile;
+   if (!NRinexUtils::OpenRinexObservationFileForInput(obsFile, obsFilename))
+   {
+      cout << "Could not open input observation file \"" << obsFilename << "\"...quitting." << endl;
+      return;
+   }
+   std::vector<NGSrinex::ObsEpoch> epochs;
+   NGSrinex::ObsEpoch epoch;
+   while (obsFile.readEpoch(epoch) != 0)
+      epochs.push_back(epoch);
+
+   // observation records, through a file as writeEpoch requires
+   const char *names[2] = { "ostream insertions", "RecordFormatter   " };
+   string tempDir = std::filesystem::temp_directory_path().string();
+   string written[2];
+   for (int fast = 0; fast < 2; ++fast)
+   {
+      string filename = tempDir + "/spp_bench_format_" + std::to_string(fast) + ".obs";
+      obsFile.setFastFormat(fast != 0);
+      double bestSecs = 0.0;
+      for (int run = 0; run < numRuns; ++run)
+      {
+         std::ofstream output(filename, std::ios::binary | std::ios::trunc);
+         auto start = std::chrono::steady_clock::now();
+         for (size_t i = 0; i < epochs.size(); ++i)
+            obsFile.writeEpoch(output, epochs[i]);
+         output.flush();
+         double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+         if (run == 0 || secs < bestSecs)
+            bestSecs = secs;
+      }
+      written[fast] = readWholeFile(filename);
+      std::remove(filename.c_str());
+      cout << "writeEpoch, " << names[fast] << ": " << epochs.size() << " epochs, "
+           << std::fixed << std::setprecision(0) << epochs.size() / bestSecs << " epochs/sec"
+           << " (best of " << numRuns << ")" << endl;
+   }
+   bool identical = written[0] == written[1];
+
+   // solution rows around a receiver on the Earth's surface
+   const int numRows = 200000;
+   std::vector<SolutionRow> rows(numRows);
+   unsigned long long seed = 1;
+   auto noise = [&seed]()
+   {
+      seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+      return static_cast<double>(seed >> 11) / 9007199254740992.0 - 0.5;
+   };
+   for (int i = 0; i < numRows; ++i)
+   {
+      SolutionRow &row = rows[i];
+      row.epochTime = 345600.0 + i;
+      row.x = 4027893.6 + noise();
+      row.y = 307045.9 + noise();
+      row.z = 4919474.9 + noise();
+      row.cdt = 1.0e5 * noise();
+      row.HDOP = 1.0 + noise();
+      row.VDOP = 1.5 + noise();
+      row.PDOP = 2.0 + noise();
+      row.GDOP = 2.5 + noise();
+      row.east = noise();
+      row.north = noise();
+      row.up = 2.0 * noise();
+      row.numSats = 4 + i % 9;
+   }
+   RecordFormatter record;
+   for (int fast = 0; fast < 2; ++fast)
+   {
+      double bestSecs = 0.0;
+      for (int run = 0; run < numRuns; ++run)
+      {
+         std::ostringstream output;
+         auto start = std::chrono::steady_clock::now();
+         for (int i = 0; i < numRows; ++i)
+         {
+            if (fast)
+               writeSolutionRow(output, record, rows[i]);
+            else
+               writeSolutionRowStream(output, rows[i]);
+         }
+         double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+         if (run == 0 || secs < bestSecs)
+            bestSecs = secs;
+         written[fast] = output.str();
+      }
+      cout << "solution CSV, " << names[fast] << ": " << numRows << " rows, "
+           << std::fixed << std::setprecision(0) << numRows / bestSecs << " rows/sec"
+           << " (best of " << numRuns << ")" << endl;
+   }
+   identical = identical && written[0] == written[1];
+
+   cout << "Formatted output " << (identical ? "identical" : "DIFFERS") << endl;
+}
+
+// Time the scalar, the batched and the interpolated broadcast orbit
+// evaluation over four hours of 1 s epochs around the first toe of the file,
+// with every satellite of the navigation file in view
+void benchmarkEphemerisEvaluation(const string &navFilename)
+{
+   EphemerisStore store;
+   if (!store.load(navFilename) || store.getNumEphemerides() == 0)
+   {
+      cout << "Could not read navigation file \"" << navFilename << "\"...quitting." << endl;
+      return;
+   }
+
+   // one ephemeris per satellite, all at the first toe of the file
+   std::vector<GpsEphemeris> ephemerides;
+   long week = 0;
+   double toe = 0.0;
+   for (int prn = 1; prn <= EphemerisStore::MAXPRN; ++prn)
+   {
+      const std::vector<GpsEphemeris> &table = store.getEphemerides(prn);
+      if (!table.empty() && (week == 0 || (table[0].week - week) * 604800.0 + (table[0].toe - toe) < 0.0))
+      {
+         week = table[0].week;
+         toe = table[0].toe;
+      }
+   }
+   for (int prn = 1; prn <= EphemerisStore::MAXPRN; ++prn)
+   {
+      const GpsEphemeris *eph = store.select(prn, week, toe);
+      if (eph)
+         ephemerides.push_back(*eph);
+   }
+
+   const int numEpochs = 14400;
+   const int numRuns = 5;
+   const size_t numSats = ephemerides.size();
+   double start = toe - 7200.0;
+
+   // the batch and the cache both use exactly these ephemerides
+   EphemerisBatch batch;
+   EphemerisStore selected;
+   selected.setMaxAge(7200.0);
+   for (size_t i = 0; i < numSats; ++i)
+   {
+      batch.add(ephemerides[i]);
+      selected.add(ephemerides[i]);
+   }
+   OrbitCache cache(selected);
+
+   double scalarSecs = 0.0, batchSecs = 0.0, cacheSecs = 0.0;
+   double maxDiff = 0.0, maxCacheDiff = 0.0;
+   SatelliteState state;
+   for (int run = 0; run < numRuns; ++run)
+   {
+      auto t0 = std::chrono::steady_clock::now();
+      for (int k = 0; k < numEpochs; ++k)
+      {
+         for (size_t i = 0; i < numSats; ++i)
+         {
+            EphemerisStore::evaluate(ephemerides[i], week, start + k, state);
+         }
+      }
+      auto t1 = std::chrono::steady_clock::now();
+      for (int k = 0; k < numEpochs; ++k)
+      {
+         for (size_t i = 0; i < numSats; ++i)
+            batch.setTime(i, week, start + k);
+         batch.evaluate();
+      }
+      auto t2 = std::chrono::steady_clock::now();
+      cache.clear();
+      for (int k = 0; k < numEpochs; ++k)
+      {
+         for (size_t i = 0; i < numSats; ++i)
+            cache.evaluate(ephemerides[i].prn, week, start + k, state);
+      }
+      auto t3 = std::chrono::steady_clock::now();
+
+      double secs = std::chrono::duration<double>(t1 - t0).count();
+      if (run == 0 || secs < scalarSecs)
+         scalarSecs = secs;
+      secs = std::chrono::duration<double>(t2 - t1).count();
+      if (run == 0 || secs < batchSecs)
+         batchSecs = secs;
+      secs = std::chrono::duration<double>(t3 - t2).count();
+      if (run == 0 || secs < cacheSecs)
+         cacheSecs = secs;
+   }
+
+   // agreement of the batch at the last epoch, and of the cache at every epoch
+   unsigned long numFits = cache.getNumFits() / numRuns;
+   SatelliteState cached;
+   for (int k = 0; k < numEpochs; ++k)
+   {
+      for (size_t i = 0; i < numSats; ++i)
+      {
+         EphemerisStore::evaluate(ephemerides[i], week, start + k, state);
+         cache.evaluate(ephemerides[i].prn, week, start + k, cached);
+         maxCacheDiff = std::max(maxCacheDiff, fabs(state.x - cached.x));
+         maxCacheDiff = std::max(maxCacheDiff, fabs(state.y - cached.y));
+         maxCacheDiff = std::max(maxCacheDiff, fabs(state.z - cached.z));
+         maxCacheDiff = std::max(maxCacheDiff, 299792458.0 * fabs(state.clockBias - cached.clockBias));
+      }
+   }
+   for (size_t i = 0; i < numSats; ++i)
+   {
+      EphemerisStore::evaluate(ephemerides[i], week, start + (numEpochs - 1), state);
+      maxDiff = std::max(maxDiff, fabs(state.x - batch.getX()[i]));
+      maxDiff = std::max(maxDiff, fabs(state.y - batch.getY()[i]));
+      maxDiff = std::max(maxDiff, fabs(state.z - batch.getZ()[i]));
+      maxDiff = std::max(maxDiff, 299792458.0 * fabs(state.clockBias - batch.getClockBias()[i]));
+   }
+
+   double evaluations = static_cast<double>(numEpochs) * numSats;
+   cout << numSats << " satellites, " << numEpochs << " epochs (best of " << numRuns << ")" << endl;
+   cout << std::fixed << std::setprecision(0)
+        << "scalar evaluate:  " << evaluations / scalarSecs << " satellites/sec" << endl
+        << "batched evaluate: " << evaluations / batchSecs << " satellites/sec" << endl
+        << "interpolated:     " << evaluations / cacheSecs << " satellites/sec ("
+        << numFits << " window fits)" << endl;
+   cout << std::scientific << std::setprecision(1)
+        << "Largest position/clock difference: batched " << maxDiff
+        << " m, interpolated " << maxCacheDiff << " m" << endl;
+}
+
+// Geodetic latitude and longitude (deg) of an ECEF position on WGS84
+void ecefToLatLon(double x, double y, double z, double &latDeg, double &lonDeg)
+{
+   const double a = 6378137.0;
+   const double e2 = 6.69437999014e-3;
+   double p = sqrt(x * x + y * y);
+   double lat = atan2(z, p * (1.0 - e2));
+
+   for (int i = 0; i < 5; ++i)
+   {
+      double sinLat = sin(lat);
+      double N = a / sqrt(1.0 - e2 * sinLat * sinLat);
+      double h = p / cos(lat) - N;
+      lat = atan2(z, p * (1.0 - e2 * N / (N + h)));
+   }
+
+   latDeg = lat * 180.0 / M_PI;
+   lonDeg = atan2(y, x) * 180.0 / M_PI;
+}
+
+// How a job's memory budget (--job-memory) is spent.  The buffers that grow
+// with the threads and the output are capped to a share of the budget each;
+// satpos.txt is loaded only if it fits in what is left.
+const double BUDGET_PARSESHARE = 0.25;      // epochs parsed ahead by ParallelObsReader
+const double BUDGET_POOLSHARE = 0.0625;     // epochs queued in or solved by the SolutionPool
+const double BUDGET_OUTPUTSHARE = 0.0625;   // the chunk of the binary solution file
+const size_t EPOCHSATS = 48;                // satellites an epoch's buffers are sized for
+
+struct MemoryPlan
+{
+   size_t parseRangeBytes;   // largest ParallelObsReader range, 0 = its default
+   size_t poolPending;       // SolutionPool epochs in flight, 0 = its default
+   unsigned chunkRows;       // rows per chunk of the binary solution file
+   bool streamSatPos;        // satpos.txt does not fit beside the buffers
+   double bufferBytes;       // estimate of the capped buffers
+};
+
+static unsigned resolveThreads(int numThreads)
+{
+   unsigned threads = numThreads > 0 ? static_cast<unsigned>(numThreads) : std::thread::hardware_concurrency();
+   return std::max(1u, threads);
+}
+
+// Cap the buffers of a job to its memory budget.  Without a budget every
+// buffer keeps its default size and satpos.txt is streamed only on request.
+void planJobMemory(const JobConfig &config, unsigned numObsTypes, double satPosBytes, MemoryPlan &plan)
+{
+   plan.parseRangeBytes = 0;
+   plan.poolPending = 0;
+   plan.chunkRows = SolutionFile::DEFAULTCHUNKROWS;
+   plan.streamSatPos = false;
+   plan.bufferBytes = 0.0;
+   double budget = config.memoryBudgetMB * 1048576.0;
+   if (budget <= 0.0)
+      return;
+
+   if (config.parseThreads >= 0 && !config.timeWindow)
+   {
+      double ringBytes = ParallelObsReader::estimateMemory(config.parseThreads,
+                                                           ParallelObsReader::DEFAULTRANGEBYTES, numObsTypes);
+      double scale = std::min(1.0, budget * BUDGET_PARSESHARE / ringBytes);
+      plan.parseRangeBytes = std::max<size_t>(1, static_cast<size_t>(scale * ParallelObsReader::DEFAULTRANGEBYTES));
+      plan.bufferBytes += ParallelObsReader::estimateMemory(config.parseThreads, plan.parseRangeBytes, numObsTypes);
+   }
+
+   if (config.numThreads >= 0 && !config.staticFilter)
+   {
+      double epochBytes = sizeof(EpochJob) + sizeof(SolutionRow) +
+                          EPOCHSATS * (sizeof(SatelliteData) + sizeof(double));
+      size_t pending = 4 * static_cast<size_t>(resolveThreads(config.numThreads));
+      plan.poolPending = std::max<size_t>(1, std::min(pending, static_cast<size_t>(budget * BUDGET_POOLSHARE / epochBytes)));
+      plan.bufferBytes += plan.poolPending * epochBytes;
+   }
+
+   if (config.outputFormat != OUTPUT_CSV)
+   {
+      double rowBytes = SolutionFile::NUMFLOATCOLUMNS * sizeof(double) + sizeof(int32_t);
+      plan.chunkRows = std::max(1u, std::min(static_cast<unsigned>(SolutionFile::DEFAULTCHUNKROWS),
+                                             static_cast<unsigned>(budget * BUDGET_OUTPUTSHARE / rowBytes)));
+      plan.bufferBytes += plan.chunkRows * rowBytes;
+   }
+
+   // loading satpos.txt takes about as much memory as the file itself
+   plan.streamSatPos = satPosBytes > budget - plan.bufferBytes;
+}
+
+// Read the epochs of one observation file, solve each of them and write the
+// solution file.  Returns false (with report.message set) if the job could
+// not be run.  Jobs share no state, so several can run at once.
+bool runJob(const JobConfig &config, JobReport &report)
+{
+   report.ok = false;
+   report.numEpochs = 0;
+   report.numSolved = 0;
+   report.numWarnings = 0;
+   report.streamedSatPos = config.streamSatPos;
+   report.usedEphemeris = EphemerisStore::isNavigationFile(config.satFilename);
+   report.numIterations = 0;
+   report.solveSecs = 0.0;
+   report.secs = 0.0;
+   auto start = std::chrono::steady_clock::now();
+
+   bool writeCsv = config.outputFormat != OUTPUT_BINARY;
+   ofstream outputFile;
+   if (writeCsv)
+   {
+      outputFile.open(config.outputFilename);
+      if (!outputFile)
+      {
+         report.message = "could not open output file \"" + config.outputFilename + "\"";
+         return false;
+      }
+      outputFile << "EpochTime,X,Y,Z,ClockBias,HDOP,VDOP,PDOP,GDOP,EastError,NorthError,UpError,NumSats\n";
+   }
+
+   ofstream statsFile;
+   if (config.writeSolverStats)
+   {
+      string statsFilename = siblingFilename(config.outputFilename, "_stats", "");
+      statsFile.open(statsFilename);
+      if (!statsFile)
+      {
+         report.message = "could not open solver statistics file \"" + statsFilename + "\"";
+         return false;
+      }
+      statsFile << "EpochTime,Iterations,CorrectionNorm,SolveMicroseconds\n";
+   }
+
+   RinexObsFile inObsFile;
+   if (!NRinexUtils::OpenRinexObservationFileForInput(inObsFile, config.obsFilename))
+   {
+      report.message = "could not open input observation file \"" + config.obsFilename + "\"";
+      return false;
+   }
+
+   // where the epochs' iterations start; without a position in the header,
+   // approx follows the solutions like previous
+   ReceiverState startState = {0.0, 0.0, 0.0, 0.0, {0.0, 0.0, 0.0}};
+   bool haveStart = false;
+   if (config.warmStart == WARMSTART_APPROX)
+   {
+      startState.x = inObsFile.getApproxX();
+      startState.y = inObsFile.getApproxY();
+      startState.z = inObsFile.getApproxZ();
+      haveStart = startState.x != 0.0 || startState.y != 0.0 || startState.z != 0.0;
+   }
+   bool followSolutions = config.warmStart == WARMSTART_PREVIOUS ||
+                          (config.warmStart == WARMSTART_APPROX && !haveStart);
+
+   // fit the buffers and satpos.txt into the job's memory budget
+   MemoryPlan memoryPlan;
+   double satPosBytes = 0.0;
+   if (!report.usedEphemeris && config.memoryBudgetMB > 0.0)
+   {
+      ifstream satFile(config.satFilename, ios::binary | ios::ate);
+      if (satFile)
+         satPosBytes = static_cast<double>(satFile.tellg());
+   }
+   planJobMemory(config, inObsFile.getNumObsTypes(), satPosBytes, memoryPlan);
+   if (!report.usedEphemeris && memoryPlan.streamSatPos)
+      report.streamedSatPos = true;
+
+   // solution.txt -> solution.bin
+   SolutionWriter binaryWriter;
+   bool writeBinary = config.outputFormat != OUTPUT_CSV;
+   string binaryFilename = siblingFilename(config.outputFilename, "", ".bin");
+   if (writeBinary && !binaryWriter.open(binaryFilename, memoryPlan.chunkRows))
+   {
+      report.message = "could not open binary output file \"" + binaryFilename + "\"";
+      return false;
+   }
+
+   // satpos.txt only holds seconds of week, so take the week from the header
+   DateTime firstObs( inObsFile.getFirstObs() );
+   long firstWeek = firstObs.GetGPSTime().GPSWeek;
+
+   // a time window starts with a seek through the epoch index
+   if (config.timeWindow)
+   {
+      GPSTime windowStart = { firstWeek, config.windowStart };
+      GPSTime windowEnd = { firstWeek, config.windowEnd };
+      if (!inObsFile.readRange(DateTime(windowStart), DateTime(windowEnd)))
+      {
+         report.message = "could not index observation file \"" + config.obsFilename + "\"";
+         return false;
+      }
+   }
+   SatPosStore satStore;
+   SatPosStream satStream;
+   EphemerisStore ephemerides;
+   EphemerisBatch ephemerisBatch;
+   std::unique_ptr<OrbitCache> orbitCache;
+   if (config.interpolateOrbits)
+      orbitCache.reset(new OrbitCache(ephemerides));
+   SatPosSource &satSource = report.streamedSatPos ? static_cast<SatPosSource&>(satStream) : satStore;
+   bool satSourceOK;
+   if (report.usedEphemeris)
+   {
+      report.streamedSatPos = false;
+      satSourceOK = ephemerides.load(config.satFilename);
+   }
+   else
+      satSourceOK = report.streamedSatPos ? satStream.open(config.satFilename, firstWeek)
+                                          : satStore.load(config.satFilename, firstWeek);
+   if (!satSourceOK)
+   {
+      report.message = "could not read satellite position file \"" + config.satFilename + "\"";
+      if (!report.usedEphemeris && !satSource.getError().empty())
+         report.message += ", " + satSource.getError();
+      return false;
+   }
+   GlonassStore glonass;
+   bool useGlonass = !config.glonassFilename.empty();
+   if (useGlonass && !glonass.load(config.glonassFilename))
+   {
+      report.message = "could not read GLONASS navigation file \"" + config.glonassFilename + "\"";
+      return false;
+   }
+   SbasStore sbas;
+   bool useSbas = !config.sbasFilename.empty();
+   if (useSbas && !sbas.load(config.sbasFilename))
+   {
+      report.message = "could not read SBAS navigation file \"" + config.sbasFilename + "\"";
+      return false;
+   }
+   ClockStore clocks;
+   bool useClocks = !config.clockFilename.empty();
+   clocks.setNumPoints(config.clockPoints);
+   if (useClocks && !clocks.load(config.clockFilename))
+   {
+      report.message = "could not read clock file \"" + config.clockFilename + "\"";
+      return false;
+   }
+
+   NGSrinex::ObsBatch currentRinexObs;
+   std::vector<double> pseudoranges;
+   std::vector<int> prns;
+   std::vector<double> otherRanges;   // GLONASS and SBAS
+   std::vector<int> otherNums;
+   std::vector<char> otherCodes;
+   EpochJob job;
+   SolutionRow row;
+   const ReferencePosition &reference = config.reference;
+
+   // the static filter solves the epochs in order, on this thread
+   StaticFilter filter;
+   filter.initialised = false;
+
+   // every solved row, in epoch order and on this thread
+   RecordFormatter csvRecord;
+   std::vector<ReceiverState> seeds;     // pool warm starts, by write order
+   unsigned long numWritten = 0;
+   unsigned long numSubmitted = 0;
+   auto recordRow = [&](const SolutionRow &solution)
+   {
+      if (writeCsv)
+         writeSolutionRow(outputFile, csvRecord, solution);
+      if (writeBinary)
+         binaryWriter.write(solution);
+      if (statsFile.is_open())
+         writeSolverStatsRow(statsFile, solution);
+      report.numIterations += solution.iterations;
+      report.solveSecs += solution.solveSecs;
+      if (followSolutions)
+      {
+         ReceiverState solved = { solution.x, solution.y, solution.z, solution.cdt, {0.0, 0.0, 0.0} };
+         if (seeds.empty())
+         {
+            startState = solved;
+            haveStart = true;
+         }
+         else
+            seeds[numWritten % seeds.size()] = solved;
+         numWritten++;
+      }
+   };
+
+   // in batch mode the epochs are solved by a worker pool and written back
+   // in epoch order by this thread.  How far the solutions written back lag
+   // the submissions depends on thread timing, so a warm start follows the
+   // solution a fixed number of epochs back in submission order instead: one
+   // more than the pool holds, which submit() has always written back.
+   std::unique_ptr<SolutionPool> pool;
+   if (config.numThreads >= 0 && !config.staticFilter)
+      pool.reset(new SolutionPool(config.numThreads,
+                    [&reference](const EpochJob &epoch, SolutionRow &solution)
+                    {
+                       ReceiverState epochStart = { epoch.start[0], epoch.start[1], epoch.start[2],
+                                                    epoch.start[3], {0.0, 0.0, 0.0} };
+                       leastSquaresSolution(epoch.satellites, epoch.pseudoranges, epoch.epochTime,
+                                            reference, epoch.warmStart ? &epochStart : nullptr, solution);
+                    },
+                    recordRow, memoryPlan.poolPending));
+   if (pool && followSolutions)
+      seeds.resize(pool->getMaxPending() + 1);
+
+   // a cache made from the file as it is now replaces the parsing; without
+   // one, the parsed epochs are written to a new cache.  A time window reads
+   // only part of the file, so it neither uses nor writes one.
+   string cacheFilename = config.obsFilename + ".obscache";
+   ObsCache::SourceStamp obsStamp;
+   ObsCacheReader cacheReader;
+   ObsCacheWriter cacheWriter;
+   unsigned long headerWarnings = inObsFile.getNumberWarnings();
+   bool useCache = false;
+   if (config.obsCache && !config.timeWindow && ObsCache::stampSource(config.obsFilename, obsStamp))
+   {
+      useCache = cacheReader.open(cacheFilename, obsStamp);
+      if (!useCache)
+         cacheWriter.open(cacheFilename, obsStamp, inObsFile);
+   }
+
+   // only the C1 pseudoranges of the systems being solved are decoded,
+   // unless the epochs go to a cache, which keeps all of them
+   if (!cacheWriter.isOpen())
+   {
+      string systems = "G";
+      if (useGlonass)
+         systems += 'R';
+      if (useSbas)
+         systems += 'S';
+      inObsFile.setProjection(systems, std::vector<OBSTYPE>(1, C1));
+   }
+
+   // the epochs of a large file can be parsed ahead on several threads; a
+   // time window is read on this thread
+   std::unique_ptr<ParallelObsReader> parallelObs;
+   if (config.parseThreads >= 0 && !config.timeWindow && !useCache)
+   {
+      parallelObs.reset(new ParallelObsReader());
+      if (!parallelObs->open(inObsFile, config.parseThreads, memoryPlan.parseRangeBytes))
+         parallelObs.reset();   // not mappable: parse on this thread
+   }
+
+   auto readObsEpoch = [&]()
+   {
+      if (useCache)
+         return cacheReader.readEpoch(currentRinexObs);
+      unsigned short more = parallelObs ? parallelObs->readEpoch(currentRinexObs)
+                                        : inObsFile.readEpoch(currentRinexObs);
+      if (more != 0 && cacheWriter.isOpen())
+         cacheWriter.write(currentRinexObs);
+      return more;
+   };
+
+   try
+   {
+      while (readObsEpoch() != 0)
+      {
+         GPSTime gpsTime = currentRinexObs.getEpochTime().GetGPSTime();
+         double obsTime = gpsTime.secsOfWeek;
+         report.numEpochs++;
+
+         pseudoranges.clear();
+         prns.clear();
+         otherRanges.clear();
+         otherNums.clear();
+         otherCodes.clear();
+
+         // take the C1 column for all GPS (and GLONASS and SBAS) satellites
+         // straight from the batch
+         int c1 = currentRinexObs.findObsType(C1);
+         if (c1 >= 0)
+         {
+            const char *satCodes = currentRinexObs.getSatCodes();
+            const unsigned short *satNums = currentRinexObs.getSatNums();
+            const double *c1Values = currentRinexObs.getValues(c1);
+            const unsigned char *c1Present = currentRinexObs.getPresent(c1);
+
+            for (unsigned short i = 0; i < currentRinexObs.getNumSat(); ++i)
+            {
+               if (!c1Present[i])
+                  continue;
+
+               if (satCodes[i] == 'G')
+               {
+                  prns.push_back(satNums[i]);
+                  pseudoranges.push_back(c1Values[i]);
+               }
+               else if ((satCodes[i] == 'R' && useGlonass) || (satCodes[i] == 'S' && useSbas))
+               {
+                  otherCodes.push_back(satCodes[i]);
+                  otherNums.push_back(satNums[i]);
+                  otherRanges.push_back(c1Values[i]);
+               }
+            }
+         }
+
+         if (pseudoranges.empty() && otherRanges.empty())
+            continue;
+
+         job.epochTime = obsTime;
+         job.satellites.clear();
+         job.pseudoranges.clear();
+         if (report.usedEphemeris)
+         {
+            // compute each satellite at the transmit time of its pseudorange
+            if (orbitCache)
+            {
+               SatelliteData sat;
+               for (size_t i = 0; i < prns.size(); ++i)
+               {
+                  if (orbitCache->computeSatellite(prns[i], gpsTime.GPSWeek, obsTime, pseudoranges[i], sat))
+                  {
+                     job.satellites.push_back(sat);
+                     job.pseudoranges.push_back(pseudoranges[i]);
+                  }
+               }
+            }
+            else
+               ephemerides.computeSatellites(prns.data(), pseudoranges.data(), prns.size(),
+                                             gpsTime.GPSWeek, obsTime, ephemerisBatch,
+                                             job.satellites, job.pseudoranges);
+         }
+         else
+         {
+            const EpochData *result = satSource.find(gpsTime.GPSWeek, obsTime);
+            if (!result && !satSource.getError().empty())
+               break;   // a streamed satpos.txt stopped at a format error
+            if (!result && otherRanges.empty())
+            {
+               continue;
+            }
+
+            // pair each satellite position with the pseudorange of the same PRN
+            for (size_t j = 0; result && j < result->satellites.size(); ++j)
+            {
+               const SatelliteData &sat = result->satellites[j];
+               auto it = std::find(prns.begin(), prns.end(), sat.prn);
+               if (it != prns.end())
+               {
+                  job.satellites.push_back(sat);
+                  job.pseudoranges.push_back(pseudoranges[it - prns.begin()]);
+               }
+            }
+         }
+
+         // GLONASS satellites, propagated from the cached integrator states,
+         // and SBAS satellites
+         SatelliteData otherSat;
+         for (size_t i = 0; i < otherRanges.size(); ++i)
+         {
+            bool found = otherCodes[i] == 'R'
+               ? glonass.computeSatellite(otherNums[i], gpsTime.GPSWeek, obsTime, otherRanges[i], otherSat)
+               : sbas.computeSatellite(otherNums[i], gpsTime.GPSWeek, obsTime, otherRanges[i], otherSat);
+            if (found)
+            {
+               job.satellites.push_back(otherSat);
+               job.pseudoranges.push_back(otherRanges[i]);
+            }
+         }
+
+         // precise clocks replace the correction of every satellite; one
+         // without a precise clock is not used
+         if (useClocks)
+         {
+            size_t kept = 0;
+            for (size_t i = 0; i < job.satellites.size(); ++i)
+            {
+               if (clocks.correctSatellite(job.satellites[i], gpsTime.GPSWeek, obsTime, job.pseudoranges[i]))
+               {
+                  job.satellites[kept] = job.satellites[i];
+                  job.pseudoranges[kept] = job.pseudoranges[i];
+                  kept++;
+               }
+            }
+            job.satellites.resize(kept);
+            job.pseudoranges.resize(kept);
+         }
+
+         // every system in view costs one clock unknown
+         SystemStates systems;
+         findSystemStates(job.satellites, systems);
+         if (job.satellites.size() < static_cast<size_t>(3 + systems.numSystems))
+         {
+            if (!config.quiet)
+               std::cout << "Not enough satellites for epoch " << obsTime << "\n";
+            continue;
+         }
+
+         // Call Least Squares solution
+         if (config.staticFilter)
+         {
+            staticFilterSolution(filter, job.satellites, job.pseudoranges, obsTime, reference, row);
+            recordRow(row);
+         }
+         else if (pool)
+         {
+            if (followSolutions && numSubmitted >= seeds.size())
+            {
+               startState = seeds[(numSubmitted - seeds.size()) % seeds.size()];
+               haveStart = true;
+            }
+            numSubmitted++;
+            job.warmStart = haveStart;
+            job.start[0] = startState.x;
+            job.start[1] = startState.y;
+            job.start[2] = startState.z;
+            job.start[3] = startState.cdt;
+            pool->submit(job);
+         }
+         else
+         {
+            leastSquaresSolution(job.satellites, job.pseudoranges, obsTime, reference,
+                                 haveStart ? &startState : nullptr, row);
+            recordRow(row);
+         }
+         report.numSolved++;
+      }
+   }
+   catch (RinexReadingException &readingExcep)
+   {
+      report.message = "RinexReadingException: " + readingExcep.getMessage();
+   }
+
+   if (!report.usedEphemeris && !satSource.getError().empty() && report.message.empty())
+      report.message = "could not read satellite position file \"" + config.satFilename +
+                       "\", " + satSource.getError();
+   if (pool)
+      pool->finish();
+   if (writeBinary && !binaryWriter.close() && report.message.empty())
+      report.message = "could not write binary output file \"" + binaryFilename + "\"";
+   report.numWarnings = inObsFile.getNumberWarnings();
+   if (parallelObs)
+      report.numWarnings += parallelObs->getNumberWarnings();
+   if (useCache)
+      report.numWarnings += cacheReader.getNumberWarnings();
+   if (cacheWriter.isOpen())
+   {
+      if (report.message.empty())
+         cacheWriter.close(report.numWarnings - headerWarnings);
+      else
+         cacheWriter.abandon();
+   }
+   report.secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+   if (!config.quiet)
+   {
+      if (report.usedEphemeris)
+         cout << "Broadcast ephemerides: " << ephemerides.getNumEphemerides()
+              << " for " << ephemerides.getNumSatellites() << " satellites" << endl;
+      else
+         cout << "Satellite position lookups: " << satSource.getNumLookups()
+              << " (" << satSource.getNumHits() << " matched, "
+              << satSource.getNumEpochs() << " epochs read), mean cost "
+              << satSource.getMeanLookupNanos() << " ns per epoch" << endl;
+      if (useGlonass)
+         cout << "GLONASS ephemerides: " << glonass.getNumEphemerides()
+              << " for " << glonass.getNumSatellites() << " satellites, "
+              << glonass.getNumSteps() << " integration steps" << endl;
+      if (useSbas)
+         cout << "SBAS ephemerides: " << sbas.getNumEphemerides()
+              << " for " << sbas.getNumSatellites() << " satellites" << endl;
+      if (useClocks)
+         cout << "Precise clocks: " << clocks.getNumRecords()
+              << " records for " << clocks.getNumSatellites() << " satellites" << endl;
+      if (report.numSolved > 0)
+         cout << "Solver: " << static_cast<double>(report.numIterations) / report.numSolved
+              << " iterations and " << report.solveSecs / report.numSolved * 1e6
+              << " us per epoch" << endl;
+      cout << "Solved " << report.numSolved << " epochs in " << report.secs << " s ("
+           << (pool ? pool->getNumThreads() : 0) << " worker threads)" << endl;
+   }
+
+   report.ok = report.message.empty();
+   return report.ok;
+}
+
+// Read a manifest of jobs, one per line:
+//    obsFile satPosFile outputFile X Y Z
+// where X Y Z is the ECEF reference position (m).  Blank lines and lines
+// starting with '#' are skipped.
+bool readManifest(const string &filename, const JobConfig &defaults, std::vector<JobConfig> &jobs)
+{
+   ifstream manifest(filename);
+   if (!manifest)
+   {
+      cout << "Could not open manifest \"" << filename << "\"...quitting." << endl;
+      return false;
+   }
+
+   string line;
+   int lineNumber = 0;
+   while (getline(manifest, line))
+   {
+      lineNumber++;
+      std::istringstream iss(line);
+      string first;
+      if (!(iss >> first) || first[0] == '#')
+         continue;
+
+      JobConfig job = defaults;
+      job.obsFilename = first;
+      if (!(iss >> job.satFilename >> job.outputFilename
+                >> job.reference.x >> job.reference.y >> job.reference.z))
+      {
+         cout << "Manifest line " << lineNumber << " should be \"obsFile satPosFile outputFile X Y Z\"...quitting." << endl;
+         return false;
+      }
+      ecefToLatLon(job.reference.x, job.reference.y, job.reference.z,
+                   job.reference.lat, job.reference.lon);
+      jobs.push_back(job);
+   }
+   return true;
+}
+
+// Run the manifest's jobs on up to numJobs threads at a time and print a
+// throughput summary.  Returns the number of jobs that failed.
+int runManifest(const std::vector<JobConfig> &jobs, int numJobs)
+{
+   std::vector<JobReport> reports(jobs.size());
+   std::atomic<size_t> nextJob(0);
+   std::mutex consoleMutex;
+
+   if (numJobs <= 0)
+      numJobs = std::max(1u, std::thread::hardware_concurrency());
+   numJobs = static_cast<int>(std::min<size_t>(numJobs, jobs.size()));
+
+   auto start = std::chrono::steady_clock::now();
+   std::vector<std::thread> runners;
+   for (int t = 0; t < numJobs; ++t)
+   {
+      runners.push_back(std::thread([&]()
+      {
+         for (size_t i = nextJob++; i < jobs.size(); i = nextJob++)
+         {
+            runJob(jobs[i], reports[i]);
+            std::lock_guard<std::mutex> lock(consoleMutex);
+            cout << "[" << i + 1 << "/" << jobs.size() << "] " << jobs[i].obsFilename
+                 << (reports[i].ok ? " done" : " FAILED: " + reports[i].message) << endl;
+         }
+      }));
+   }
+   for (auto &runner : runners)
+      runner.join();
+   double wallSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+   unsigned long totalEpochs = 0;
+   int numFailed = 0;
+   cout << endl << std::left << std::setw(40) << "Observation file" << std::right
+        << std::setw(9) << "Epochs" << std::setw(9) << "Solved" << std::setw(10) << "Seconds"
+        << std::setw(12) << "Epochs/s" << std::setw(10) << "Warnings" << "  SatPos  Status" << endl;
+   for (size_t i = 0; i < jobs.size(); ++i)
+   {
+      const JobReport &report = reports[i];
+      cout << std::left << std::setw(40) << jobs[i].obsFilename << std::right
+           << std::setw(9) << report.numEpochs << std::setw(9) << report.numSolved
+           << std::fixed << std::setprecision(3) << std::setw(10) << report.secs
+           << std::setprecision(0) << std::setw(12) << (report.secs > 0.0 ? report.numEpochs / report.secs : 0.0)
+           << std::setw(10) << report.numWarnings
+           << (report.usedEphemeris ? "  nav   " : report.streamedSatPos ? "  stream" : "  load  ")
+           << (report.ok ? "  ok" : "  FAILED") << endl;
+      totalEpochs += report.numEpochs;
+      if (!report.ok)
+         numFailed++;
+   }
+   cout << jobs.size() << " jobs (" << numFailed << " failed), " << totalEpochs << " epochs in "
+        << std::setprecision(3) << wallSecs << " s using " << numJobs << " concurrent jobs, "
+        << std::setprecision(0) << (wallSecs > 0.0 ? totalEpochs / wallSecs : 0.0) << " epochs/s" << endl;
+
+   return numFailed;
+}
+
+// Main processing loop
+int main(int argc, char *argv[])
+{
+   JobConfig config;
+   config.obsFilename = "../data/obsdata.22o";
+   config.satFilename = "../data/satpos.txt";
+   config.outputFilename = "../result/solution.txt";
+   config.reference = DEFAULT_REFERENCE;
+   config.streamSatPos = false;
+   config.numThreads = -1;
+   config.parseThreads = -1;
+   config.memoryBudgetMB = 0.0;
+   config.interpolateOrbits = false;
+   config.staticFilter = false;
+   config.warmStart = WARMSTART_NONE;
+   config.writeSolverStats = false;
+   config.outputFormat = OUTPUT_CSV;
+   config.clockPoints = 2;
+   config.timeWindow = false;
+   config.obsCache = false;
+   config.quiet = false;
+   string manifestFilename;
+   int numJobs = 0;             // concurrent manifest jobs, 0 = one per core
+
+   for (int i = 1; i < argc; ++i)
+   {
+      string arg = argv[i];
+      bool hasValue = i + 1 < argc;
+      if (arg == "--stream")
+         config.streamSatPos = true;
+      else if ((arg == "--threads" || arg == "--jobs" || arg == "--parse-threads" ||
+                arg == "--clock-points") && hasValue)
+      {
+         char *end;
+         long value = strtol(argv[++i], &end, 10);
+         if (*end != '\0' || value < 0 || (arg == "--clock-points" && value < 2))
+         {
+            cout << "Bad count \"" << argv[i] << "\" for " << arg << "...quitting." << endl;
+            return 0;
+         }
+         int &count = arg == "--threads" ? config.numThreads : arg == "--jobs" ? numJobs
+                    : arg == "--parse-threads" ? config.parseThreads : config.clockPoints;
+         count = static_cast<int>(value);
+      }
+      else if (arg == "--job-memory" && hasValue)
+      {
+         char *end;
+         config.memoryBudgetMB = strtod(argv[++i], &end);
+         if (*end != '\0' || config.memoryBudgetMB < 0.0)
+         {
+            cout << "Bad memory budget \"" << argv[i] << "\"...quitting." << endl;
+            return 0;
+         }
+      }
+      else if (arg == "--orbit-cache")
+         config.interpolateOrbits = true;
+      else if (arg == "--obs-cache")
+         config.obsCache = true;
+      else if (arg == "--static-filter")
+         config.staticFilter = true;
+      else if (arg == "--warm-start" && hasValue)
+      {
+         string policy = argv[++i];
+         if (policy == "none")
+            config.warmStart = WARMSTART_NONE;
+         else if (policy == "previous")
+            config.warmStart = WARMSTART_PREVIOUS;
+         else if (policy == "approx")
+            config.warmStart = WARMSTART_APPROX;
+         else
+         {
+            cout << "Bad warm start \"" << policy << "\" (none, previous or approx)...quitting." << endl;
+            return 0;
+         }
+      }
+      else if (arg == "--solver-stats")
+         config.writeSolverStats = true;
+      else if (arg == "--output-format" && hasValue)
+      {
+         string format = argv[++i];
+         if (format == "csv")
+            config.outputFormat = OUTPUT_CSV;
+         else if (format == "binary")
+            config.outputFormat = OUTPUT_BINARY;
+         else if (format == "both")
+            config.outputFormat = OUTPUT_BOTH;
+         else
+         {
+            cout << "Bad output format \"" << format << "\" (csv, binary or both)...quitting." << endl;
+            return 0;
+         }
+      }
+      else if (arg == "--dump-binary" && hasValue)
+         return dumpBinarySolution(argv[++i]) ? 0 : 1;
+      else if (arg == "--glonass-nav" && hasValue)
+         config.glonassFilename = argv[++i];
+      else if (arg == "--sbas-nav" && hasValue)
+         config.sbasFilename = argv[++i];
+      else if (arg == "--window" && i + 2 < argc)
+      {
+         char *end1, *end2;
+         config.windowStart = strtod(argv[i + 1], &end1);
+         config.windowEnd = strtod(argv[i + 2], &end2);
+         if (*end1 != '\0' || *end2 != '\0' || config.windowEnd < config.windowStart)
+         {
+            cout << "Bad time window \"" << argv[i + 1] << " " << argv[i + 2] << "\"...quitting." << endl;
+            return 0;
+         }
+         config.timeWindow = true;
+         i += 2;
+      }
+      else if (arg == "--clock" && hasValue)
+         config.clockFilename = argv[++i];
+      else if (arg == "--nav" && hasValue)
+         config.satFilename = argv[++i];   // broadcast ephemerides instead of satpos.txt
+      else if (arg == "--manifest" && hasValue)
+         manifestFilename = argv[++i];
+      else if (arg == "--bench-ephemeris")
+      {
+         benchmarkEphemerisEvaluation(config.satFilename);
+         return 0;
+      }
+      else if (arg == "--bench-parse")
+      {
+         benchmarkRinexParsing(config.obsFilename);
+         return 0;
+      }
+      else if (arg == "--bench-format")
+      {
+         benchmarkFormatting(config.obsFilename);
+         return 0;
+      }
+      else
+      {
+         cout << "Unknown option \"" << arg << "\"...quitting." << endl;
+         return 0;
+      }
+   }
+
+   if (!manifestFilename.empty())
+   {
+      std::vector<JobConfig> jobs;
+      config.quiet = true;
+      if (!readManifest(manifestFilename, config, jobs))
+         return 1;
+      return runManifest(jobs, numJobs) == 0 ? 0 : 1;
+   }
+
+   JobReport report;
+   if (!runJob(config, report))
+      cout << report.message << "...quitting." << endl;
+
+   return 0;
+}
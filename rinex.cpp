@@ -68,6 +68,16 @@
 #define CCTYPE_
 #endif
 
+#if !defined(CSTDINT_)
+#include <cstdint>
+#define CSTDINT_
+#endif
+
+#if !defined(FILESYSTEM_)
+#include <filesystem>
+#define FILESYSTEM_
+#endif
+
 #if !defined(DATETIME_H_)
 #include "datetime.h"
 #define DATETIME_H_
@@ -131,9 +141,12 @@ bool ObsEpoch::setEpochFlag(unsigned short input)
 
 bool ObsEpoch::setNumSat(unsigned short input)
 {
-   if( input <= 999 )
+   if( input <= MAXSATPEREPOCH )
    {
      numSat = input;
+     if( numSat > SATLISTBUFSIZE &&
+         satListOverflow.size() < (size_t)( numSat - SATLISTBUFSIZE ) )
+       satListOverflow.resize( numSat - SATLISTBUFSIZE );
      return true;
    }
    else
@@ -148,26 +161,34 @@ bool ObsEpoch::setSatListElement(SatObsAtEpoch input,
 {
    bool problemsFound = false;
 
+   if( i < 0 || i >= MAXSATPEREPOCH )
+     return false;
+   if( i >= SATLISTBUFSIZE && satListOverflow.size() <= (size_t)( i - SATLISTBUFSIZE ) )
+     satListOverflow.resize( i - SATLISTBUFSIZE + 1 );
+   SatObsAtEpoch &sat = satListElement(i);
+
    // Set the satCode member
    if( input.satCode == 'G' || input.satCode == ' ' ||
-       input.satCode == 'R' )
+       input.satCode == 'R' || input.satCode == 'S' )
    {
-     satList[ i ].satCode = input.satCode;
+     sat.satCode = input.satCode;
    }
    else
    {
-     satList[ i ].satCode = ' ';
+     sat.satCode = ' ';
      problemsFound = true;
    }
 
    // Set the satNum member
-   if( input.satNum < MAXPRNID )
+   if( input.satCode == 'S' ? ( input.satNum >= MINSBASPRNID &&
+                                input.satNum <= MAXSBASPRNID )
+                            : input.satNum < MAXPRNID )
    {
-     satList[ i ].satNum = input.satNum;
+     sat.satNum = input.satNum;
    }
    else
    {
-     satList[ i ].satNum = 9999;
+     sat.satNum = 9999;
      problemsFound = true;
    }
 
@@ -182,19 +203,19 @@ bool ObsEpoch::setSatListElement(SatObsAtEpoch input,
         && (input.obsList[j].LLI <= 7)  &&
         (input.obsList[j].sigStrength <= 9) )
      {
-      satList[ i ].obsList[ j ].obsPresent  = input.obsList[j].obsPresent;
-      satList[ i ].obsList[ j ].observation = input.obsList[j].observation;
-      satList[ i ].obsList[ j ].obsType     = input.obsList[j].obsType;
-      satList[ i ].obsList[ j ].LLI         = input.obsList[j].LLI;
-      satList[ i ].obsList[ j ].sigStrength = input.obsList[j].sigStrength;
+      sat.obsList[ j ].obsPresent  = input.obsList[j].obsPresent;
+      sat.obsList[ j ].observation = input.obsList[j].observation;
+      sat.obsList[ j ].obsType     = input.obsList[j].obsType;
+      sat.obsList[ j ].LLI         = input.obsList[j].LLI;
+      sat.obsList[ j ].sigStrength = input.obsList[j].sigStrength;
      }
      else
      {
-      satList[ i ].obsList[ j ].obsPresent  = false;
-      satList[ i ].obsList[ j ].observation = 0.0;    // blank = 0.0
-      satList[ i ].obsList[ j ].obsType     = NOOBS;
-      satList[ i ].obsList[ j ].LLI         = 9999;
-      satList[ i ].obsList[ j ].sigStrength = 9999;
+      sat.obsList[ j ].obsPresent  = false;
+      sat.obsList[ j ].observation = 0.0;    // blank = 0.0
+      sat.obsList[ j ].obsType     = NOOBS;
+      sat.obsList[ j ].LLI         = 9999;
+      sat.obsList[ j ].sigStrength = 9999;
       problemsFound = true;
      }
    } // j-loop over MAXOBSTYPES
@@ -238,18 +259,20 @@ bool ObsEpoch::initializeData()
    epochFlag = 9999;
    numSat    = 9999;
 
-   for (int i = 0; i < MAXSATPEREPOCH; i++ )
+   // overflow entries are reset but kept, so their storage is reused
+   for (int i = 0; i < (int)( SATLISTBUFSIZE + satListOverflow.size() ); i++ )
    {
-      satList[ i ].satCode = ' ';
-      satList[ i ].satNum  = 9999;
+      SatObsAtEpoch &sat = satListElement(i);
+      sat.satCode = ' ';
+      sat.satNum  = 9999;
 
       for(int j = 0; j < MAXOBSTYPES; j++ )
       {
-         satList[ i ].obsList[ j ].obsPresent  = false;
-         satList[ i ].obsList[ j ].observation = 0.0;    // blank = 0.0
-         satList[ i ].obsList[ j ].obsType     = NOOBS;
-         satList[ i ].obsList[ j ].LLI         = 9999;
-         satList[ i ].obsList[ j ].sigStrength = 9999;
+         sat.obsList[ j ].obsPresent  = false;
+         sat.obsList[ j ].observation = 0.0;    // blank = 0.0
+         sat.obsList[ j ].obsType     = NOOBS;
+         sat.obsList[ j ].LLI         = 9999;
+         sat.obsList[ j ].sigStrength = 9999;
       }
    }
 
@@ -276,7 +299,21 @@ unsigned short ObsEpoch::getNumSat()
 
 SatObsAtEpoch ObsEpoch::getSatListElement(int i)
 {
-   return satList[i];
+   // entries past the stored list are blank (satNum = 9999)
+   if( i < 0 || i >= (int)( SATLISTBUFSIZE + satListOverflow.size() ) )
+     return SatObsAtEpoch();
+   return satListElement(i);
+}
+
+// Same as above without copying the record; the reference stays valid
+// until the epoch is changed.
+const SatObsAtEpoch &ObsEpoch::getSatListElementRef(int i) const
+{
+   static const SatObsAtEpoch  blankSat;
+
+   if( i < 0 || i >= (int)( SATLISTBUFSIZE + satListOverflow.size() ) )
+     return blankSat;
+   return satListElement(i);
 }
 
 double ObsEpoch::getRecClockOffset()
@@ -289,6 +326,201 @@ string ObsEpoch::getEpochHeaderRecords()
    return epochHeaderRecords;
 }
 
+SatObsAtEpoch& ObsEpoch::satListElement(int i)
+{
+   if( i < SATLISTBUFSIZE )
+     return satList[i];
+   return satListOverflow[ i - SATLISTBUFSIZE ];
+}
+
+const SatObsAtEpoch& ObsEpoch::satListElement(int i) const
+{
+   if( i < SATLISTBUFSIZE )
+     return satList[i];
+   return satListOverflow[ i - SATLISTBUFSIZE ];
+}
+
+//===================== ObsBatch Class ========================================
+
+ObsBatch::ObsBatch()  // default Constructor
+{
+   capacity = 0;
+   setNumSat( SATLISTBUFSIZE );   // allocate the columns up front
+   reset( 0, 0 );
+}
+
+ObsBatch::~ObsBatch()  // Destructor
+{ }
+
+// Initializers
+
+// Empty the batch and set up one column per observation type.  Types that
+// ObsEpoch::setSatListElement() would reject are kept but never present.
+void ObsBatch::reset(unsigned short numTypes, const enum OBSTYPE types[])
+{
+   epochTime.SetYMDHMS( 9999, 1, 1, 0, 0, 0.0 );
+   epochFlag = 9999;
+   numSat = 0;
+   recClockOffset = 9999.0;
+
+   if( numTypes > MAXOBSTYPES ) numTypes = MAXOBSTYPES;
+   numObsTypes = numTypes;
+   for( int j = 0; j < MAXOBSTYPES; j++ )
+   {
+     obsTypes[j] = ( j < numTypes && types != 0 ) ? types[j] : NOOBS;
+     typeValid[j] = obsTypes[j] == C1 || obsTypes[j] == L1 ||
+                    obsTypes[j] == L2 || obsTypes[j] == P1 ||
+                    obsTypes[j] == P2 || obsTypes[j] == D1 ||
+                    obsTypes[j] == D2 || obsTypes[j] == S1 ||
+                    obsTypes[j] == S2;
+   }
+}
+
+void ObsBatch::setEpochHeader(ObsEpoch &input)
+{
+   epochTime = input.getEpochTime();
+   epochFlag = input.getEpochFlag();
+   recClockOffset = input.getRecClockOffset();
+}
+
+void ObsBatch::setEpochHeader(DateTime time, unsigned short flag,
+                              double clockOffset)
+{
+   epochTime = time;
+   epochFlag = flag;
+   recClockOffset = clockOffset;
+}
+
+// Growing the columns re-lays them out, so any values already set are lost.
+void ObsBatch::setNumSat(unsigned short input)
+{
+   numSat = ( input <= MAXSATPEREPOCH ) ? input : MAXSATPEREPOCH;
+   if( numSat > capacity )
+   {
+     capacity = max( numSat, (unsigned short)min( 2*capacity, (int)MAXSATPEREPOCH ) );
+     satCodes.resize( capacity );
+     satNums.resize( capacity );
+     values.resize( MAXOBSTYPES * capacity );
+     present.resize( MAXOBSTYPES * capacity );
+     LLIs.resize( MAXOBSTYPES * capacity );
+     sigStrengths.resize( MAXOBSTYPES * capacity );
+   }
+}
+
+// Same acceptance rules as ObsEpoch::setSatListElement().
+bool ObsBatch::setSatellite(int i, char satCode, unsigned short satNum)
+{
+   bool problemsFound = false;
+
+   if( satCode == 'G' || satCode == ' ' || satCode == 'R' || satCode == 'S' )
+     satCodes[i] = satCode;
+   else
+   {
+     satCodes[i] = ' ';
+     problemsFound = true;
+   }
+
+   if( satCode == 'S' ? ( satNum >= MINSBASPRNID && satNum <= MAXSBASPRNID )
+                      : satNum < MAXPRNID )
+     satNums[i] = satNum;
+   else
+   {
+     satNums[i] = 9999;
+     problemsFound = true;
+   }
+
+   return !problemsFound;
+}
+
+bool ObsBatch::setObservation(int j, int i, double value,
+                              unsigned short LLI, unsigned short sigStrength)
+{
+   size_t k = (size_t)j * capacity + i;
+
+   if( typeValid[j] && LLI <= 7 && sigStrength <= 9 )
+   {
+     present[k] = fabs(value) > 0.0001;   // as in RinexObsFile::readEpoch
+     if( present[k] )
+     {
+       values[k]       = value;
+       LLIs[k]         = LLI;
+       sigStrengths[k] = sigStrength;
+     }
+     else
+     {
+       values[k]       = 0.0;
+       LLIs[k]         = 0;
+       sigStrengths[k] = 0;
+     }
+     return true;
+   }
+   else
+   {
+     present[k]      = false;
+     values[k]       = 0.0;    // blank = 0.0
+     LLIs[k]         = 9999;
+     sigStrengths[k] = 9999;
+     return false;
+   }
+}
+
+// A field that was not decoded: not present, and not a warning even for a
+// type that setObservation() would reject.
+void ObsBatch::clearObservation(int j, int i)
+{
+   size_t k = (size_t)j * capacity + i;
+
+   present[k]      = false;
+   values[k]       = 0.0;
+   LLIs[k]         = 0;
+   sigStrengths[k] = 0;
+}
+
+// Lets a batch be handed from one owner to another, e.g. from a parsing
+// thread to the reader of the epochs, while both keep their allocations.
+void ObsBatch::swap(ObsBatch &other)
+{
+   std::swap( epochTime, other.epochTime );
+   std::swap( epochFlag, other.epochFlag );
+   std::swap( numSat, other.numSat );
+   std::swap( recClockOffset, other.recClockOffset );
+   std::swap( numObsTypes, other.numObsTypes );
+   std::swap( obsTypes, other.obsTypes );
+   std::swap( typeValid, other.typeValid );
+   std::swap( capacity, other.capacity );
+   satCodes.swap( other.satCodes );
+   satNums.swap( other.satNums );
+   values.swap( other.values );
+   present.swap( other.present );
+   LLIs.swap( other.LLIs );
+   sigStrengths.swap( other.sigStrengths );
+}
+
+// Selectors
+DateTime       ObsBatch::getEpochTime() { return epochTime; }
+unsigned short ObsBatch::getEpochFlag() { return epochFlag; }
+unsigned short ObsBatch::getNumSat() { return numSat; }
+double         ObsBatch::getRecClockOffset() { return recClockOffset; }
+unsigned short ObsBatch::getNumObsTypes() { return numObsTypes; }
+enum OBSTYPE   ObsBatch::getObsType(int j) { return obsTypes[j]; }
+
+int ObsBatch::findObsType(enum OBSTYPE type)
+{
+   for( int j = 0; j < numObsTypes; j++ )
+   {
+     if( obsTypes[j] == type )
+       return j;
+   }
+   return -1;
+}
+
+const char*           ObsBatch::getSatCodes() { return &satCodes[0]; }
+const unsigned short* ObsBatch::getSatNums() { return &satNums[0]; }
+const double*         ObsBatch::getValues(int j) { return &values[ j*capacity ]; }
+const unsigned char*  ObsBatch::getPresent(int j) { return &present[ j*capacity ]; }
+const unsigned short* ObsBatch::getLLI(int j) { return &LLIs[ j*capacity ]; }
+const unsigned short* ObsBatch::getSigStrength(int j) { return &sigStrengths[ j*capacity ]; }
+
 //===================== MetEpoch Class ====================================
 
 MetEpoch::MetEpoch()    // Default Constructor
@@ -1000,7 +1232,7 @@ GeostationaryEphemEpoch::~GeostationaryEphemEpoch()  // Destructor
 //Initializers
 bool GeostationaryEphemEpoch::setSatelliteNumber(unsigned short input)
 {
-  if( input <= MAXPRNID)
+  if( input <= MAXGEOSTATIONARYID )
   {
     satelliteNumber = input;
     return true;
@@ -1383,12 +1615,137 @@ void RinexHeader::writeHeaderImage( ofstream &outputStream )
 
 } 
 
+//========================== RinexDiagnostics Class ===========================
+
+RinexDiagnostics::RinexDiagnostics()
+{
+   maxEntries = DEFMAXDIAGENTRIES;
+   maxBytes   = DEFMAXDIAGBYTES;
+   clear();
+}
+
+RinexDiagnostics::~RinexDiagnostics()
+{ }
+
+// Initializers
+void RinexDiagnostics::setMaxEntries(unsigned long input)
+{
+   maxEntries = input;
+}
+
+void RinexDiagnostics::setMaxBytes(unsigned long input)
+{
+   maxBytes = input;
+}
+
+void RinexDiagnostics::setCallback(DiagnosticCallback input)
+{
+   callback = input;
+}
+
+void RinexDiagnostics::report(bool isError, DIAGCODE code,
+                              unsigned long lineNumber, const string &message)
+{
+  DiagnosticEntry  entry;
+
+   if( code < DIAG_OTHER || code >= NUMDIAGCODES ) code = DIAG_OTHER;
+
+   entry.lineNumber = lineNumber;
+   entry.code       = code;
+   entry.isError    = isError;
+   entry.message    = message.substr( 0, MAXDIAGMSGLENGTH );
+
+   counts[code]++;
+   numberReported++;
+
+   if( callback )
+     callback( entry );
+
+   // keep the first reports only: later ones are usually repeats of the
+   // same problem, and dropping them bounds the memory used per file.
+   if( entries.size() < maxEntries &&
+       retainedBytes + entry.message.length() <= maxBytes )
+   {
+     retainedBytes += entry.message.length();
+     entries.push_back( entry );
+   }
+   else
+   {
+     numberDropped[ isError ? 1 : 0 ]++;
+   }
+}
+
+void RinexDiagnostics::clear()
+{
+   entries.clear();
+   retainedBytes = 0;
+   numberReported = 0;
+   numberDropped[0] = 0;
+   numberDropped[1] = 0;
+   for( int i = 0; i < NUMDIAGCODES; i++ )
+     counts[i] = 0;
+}
+
+// Selectors
+unsigned long RinexDiagnostics::getMaxEntries() { return maxEntries; }
+unsigned long RinexDiagnostics::getMaxBytes() { return maxBytes; }
+unsigned long RinexDiagnostics::getNumberReported() { return numberReported; }
+
+unsigned long RinexDiagnostics::getCount(DIAGCODE code)
+{
+   if( code < DIAG_OTHER || code >= NUMDIAGCODES )
+     return 0;
+   return counts[code];
+}
+
+unsigned long RinexDiagnostics::getNumberDropped()
+{
+   return numberDropped[0] + numberDropped[1];
+}
+
+const vector<DiagnosticEntry> &RinexDiagnostics::getEntries()
+{
+   return entries;
+}
+
+// Format the retained warnings (or errors) as one string, each message
+// preceded by a line of dashes.
+string RinexDiagnostics::getMessages(bool errors)
+{
+  ostringstream  messages;
+  string temp = "---------------------------------------"; // 39 chars
+
+   for( size_t i = 0; i < entries.size(); i++ )
+   {
+     if( entries[i].isError == errors )
+       messages << temp << temp << endl << entries[i].message << endl;
+   }
+
+   if( numberDropped[ errors ? 1 : 0 ] > 0 )
+   {
+     messages << temp << temp << endl
+     << numberDropped[ errors ? 1 : 0 ]
+     << ( errors ? " more errors" : " more warnings" )
+     << " were not kept (limit " << maxEntries << " messages, "
+     << maxBytes << " bytes)." << endl;
+   }
+
+   return messages.str();
+}
+
+
 //========================== RinexFile Class ==================================
 
 RinexFile::RinexFile()   // this is a base class
 {
     pathFilename = "nofilename.out";
     fileMode = ios::out;
+    fastParse = true;
+    fastFormat = true;
+    useMemoryMap = true;
+    lineSource = 0;
+    memoryMapped = false;
+    decodedInput = false;
 }
 
 RinexFile::RinexFile(string inputFilePath, ios::openmode mode)
@@ -1396,24 +1753,19 @@ RinexFile::RinexFile(string inputFilePath, ios::openmode mode)
     string record;
     pathFilename = inputFilePath;
     fileMode = mode;
+    fastParse = true;
+    fastFormat = true;
+    useMemoryMap = true;
+    lineSource = 0;
+    memoryMapped = false;
+    decodedInput = false;
 
     if( fileMode == ios::in )
     {
-      inputStream.open( pathFilename.c_str(), fileMode );
-      if( !inputStream )
-      {
-	tempStream << "Error: In RinexFile constructor, unable to open file:"
-        << endl << pathFilename << " using mode: " << fileMode << endl;
-	appendToErrorMessages( tempStream.str() );
-
-        RinexFileException  excep( tempStream.str() );
-	throw excep;
-      }
+      openInputSource();
       readFileTypeAndProgramName();   // read the RINEX VERSION/TYPE and
                                             // PGM/RUN BY/DATE header records
-      inputStream.close();
-      inputStream.open( pathFilename.c_str(), fileMode );  // reset the file at
-                                                           // its beginning.
+      lineSource->seek( 0 );          // reset the file at its beginning.
       numberLinesRead = 0;
       numberWarnings = 0;
       numberErrors = 0;
@@ -1438,7 +1790,7 @@ RinexFile::~RinexFile()
 {
     if( fileMode == ios::in )
     {
-      inputStream.close();
+      closeInputSource();
     }
     else
     {
@@ -1458,22 +1810,10 @@ void RinexFile::setPathFilenameMode(string inputFilePath,
 
     if( fileMode == ios::in )  // input file
     {
-      inputStream.open( pathFilename.c_str(), fileMode );
-      if( !inputStream )
-      {
-	tempStream <<
-	"Error: In setPathFilenameMode, unable to open file:"
-        << endl << pathFilename << " using mode: " << fileMode << endl;
-	appendToErrorMessages( tempStream.str() );
-
-        RinexFileException  excep( tempStream.str() );
-	throw excep;
-      }
+      openInputSource();
       readFileTypeAndProgramName();   // read the RINEX VERSION/TYPE and
                                             // PGM/RUN BY/DATE header records
-      inputStream.close();
-      inputStream.open( pathFilename.c_str(), fileMode );  // reset the file at
-                                                           // its beginning.
+      lineSource->seek( 0 );          // reset the file at its beginning.
       numberLinesRead = 0;
       numberWarnings = 0;
       numberErrors = 0;
@@ -1495,6 +1835,38 @@ void RinexFile::setPathFilenameMode(string inputFilePath,
 
 }
 
+void RinexFile::setFastParse(bool input)
+{
+    fastParse = input;
+}
+
+void RinexFile::setFastFormat(bool input)
+{
+    fastFormat = input;
+}
+
+void RinexFile::setUseMemoryMap(bool input)
+{
+    useMemoryMap = input;
+}
+
+//---------------------------------------------------------------------------
+// setInputSpan()
+//    Reads the records of a buffer that the caller keeps valid, e.g. a range
+//    of data records of a mapped file, in place.  No header is read: the
+//    caller sets up whatever header state the records need.  The line count
+//    restarts at the first record of the span; the warning and error counts
+//    carry on.
+
+void RinexFile::setInputSpan(string name, const char *data, size_t size)
+{
+    closeInputSource();
+    pathFilename = name;
+    fileMode = ios::in;
+    lineSource = new SpanLineSource( data, size );
+    numberLinesRead = 0;
+}
+
 bool RinexFile::setRinexHeaderImage(list<HeaderRecord> input)
 {
     rinexHeaderImage.setHeaderImage(input);
@@ -1583,12 +1955,11 @@ bool RinexFile::setCurrentEpoch(DateTime input)
     }
 }
 
-void RinexFile::appendToErrorMessages(string errMessage)
+void RinexFile::appendToErrorMessages(string errMessage, DIAGCODE code)
 {
-  string temp = "---------------------------------------"; // 39 chars
-
-  errorMessages << temp << temp << endl << errMessage << endl;
+  diagnostics.report( true, code, getNumberLinesRead(), errMessage );
   numberErrors++;
+  // tempStream is left intact: the caller throws its contents next
 
   // Since an error has occured, output all warnings and
   // errors that have been logged up to this point.
@@ -1600,14 +1971,11 @@ void RinexFile::appendToErrorMessages(string errMessage)
 }
 
 
-void RinexFile::appendToWarningMessages(string warnMessage)
+void RinexFile::appendToWarningMessages(string warnMessage, DIAGCODE code)
 {
-  string tempd = "---------------------------------------"; // 39 chars
-  const string resetStr = " \0";
-
-  warningMessages << tempd << tempd << endl << warnMessage << endl;
+  diagnostics.report( false, code, getNumberLinesRead(), warnMessage );
   numberWarnings++;
-  tempStream.str(resetStr);  // clear tempStream for use by the next warning
+  tempStream.str("");  // clear tempStream for use by the next warning
 }
 
 
@@ -1642,78 +2010,233 @@ DateTime       RinexFile::getCurrentEpoch() { return currentEpoch; }
 
 string RinexFile::getErrorMessages()
 {
-    return (errorMessages.str());
+    return (diagnostics.getMessages(true));
 }
 
 string RinexFile::getWarningMessages()
 {
-    return (warningMessages.str());
+    return (diagnostics.getMessages(false));
 }
 
+RinexDiagnostics& RinexFile::getDiagnostics()
+{
+    return (diagnostics);
+}
 
-void RinexFile::readFileTypeAndProgramName()
+bool RinexFile::getFastParse()
 {
-   string         inputRec;
-   string         recordReadIn;
-   bool  endOfHeaderFound = false;
+    return (fastParse);
+}
 
-   if( !validFirstLine(recordReadIn) )
-   {
-     tempStream << "Error: First Line is incorrect in File: "
-     << getPathFilename() << endl << recordReadIn << endl;
-     appendToErrorMessages( tempStream.str() );
-     RequiredRecordMissingException excep( tempStream.str() );
-     throw excep;
-   }
+bool RinexFile::getFastFormat()
+{
+    return (fastFormat);
+}
 
-   // read all Header lines from line 2 to END OF HEADER
-   // until the PGM / RUN BY / DATE record is found
-   while( !endOfHeaderFound )
-   {
-     if( !getline( inputStream, inputRec, '\n') )
-     {
-       // Error reading a header line of the RINEX File
-       tempStream << "Error reading a header line of file:" << endl
-       << getPathFilename() << endl;
-       appendToErrorMessages( tempStream.str() );
-       RinexReadingException  excep( tempStream.str() );
-       throw excep;
-     }
+bool RinexFile::isMemoryMapped()
+{
+    return (memoryMapped);
+}
 
-     if( blankString(inputRec) )
-     {
-         if( formatVersion < 2.0 )
-         {
-           endOfHeaderFound = true;
-           break;   // end the while loop
-         }
-         else
-         {
-           continue;   // go to read the next record
-         }
-     }
+bool RinexFile::isDecodedInput()
+{
+    return (decodedInput);
+}
 
-     if( inputRec.find( "END OF HEADER" ) == 60 )
-     {
-       endOfHeaderFound = true;
-       break;
-     }
-     else if( inputRec.find( "PGM / RUN BY / DATE" ) == 60 )
-     {
-       rinexProgram    = inputRec.substr(  0, 20 );
-       createdByAgency = inputRec.substr( 20, 20 );
-       dateFileCreated = inputRec.substr( 40, 20 );
-       endOfHeaderFound = true;
-       break;
-     }
-     else
-     {
-       continue;  // go to read the next record
-     }
 
-   } // end of while loop over all header records
+//---------------------------------------------------------------------------
+// openInputSource()
+//    Open pathFilename for reading.  The file is memory mapped when possible
+//    so that records are parsed straight from the mapped pages; otherwise
+//    (mmap unavailable, disabled, or an empty/special file) the records are
+//    read from inputStream.  A gzip file is inflated as it is read, and a
+//    Compact RINEX file (of either kind) is restored to RINEX records.
 
-}
+void RinexFile::openInputSource()
+{
+    const char  *line;
+    size_t       length;
+
+    closeInputSource();
+
+    if( GzipLineSource::isGzipFile( pathFilename ) )
+    {
+      GzipLineSource  *inflated = new GzipLineSource();
+      if( !inflated->open( pathFilename ) )
+      {
+        delete inflated;
+        tempStream <<
+        "Error: In openInputSource, unable to inflate gzip file (zlib needed):"
+        << endl << pathFilename << endl;
+        appendToErrorMessages( tempStream.str() );
+
+        RinexFileException  excep( tempStream.str() );
+        throw excep;
+      }
+      lineSource = inflated;
+      decodedInput = true;
+    }
+
+    if( lineSource == 0 && useMemoryMap )
+    {
+      MappedLineSource  *mapped = new MappedLineSource();
+      if( mapped->open( pathFilename ) )
+      {
+        lineSource = mapped;
+        memoryMapped = true;
+      }
+      else
+        delete mapped;
+    }
+
+    if( lineSource == 0 )
+    {
+      inputStream.open( pathFilename.c_str(), fileMode );
+      if( !inputStream )
+      {
+        tempStream <<
+        "Error: In openInputSource, unable to open file:"
+        << endl << pathFilename << " using mode: " << fileMode << endl;
+        appendToErrorMessages( tempStream.str() );
+
+        RinexFileException  excep( tempStream.str() );
+        throw excep;
+      }
+      lineSource = new StreamLineSource( inputStream );
+    }
+
+    if( lineSource->nextLine( line, length ) &&
+        HatanakaLineSource::isCompactRinex( line, length ) )
+    {
+      lineSource->seek( 0 );
+      lineSource = new HatanakaLineSource( lineSource );
+      decodedInput = true;
+    }
+    else
+      lineSource->seek( 0 );
+}
+
+void RinexFile::closeInputSource()
+{
+    delete lineSource;
+    lineSource = 0;
+    memoryMapped = false;
+    decodedInput = false;
+    if( inputStream.is_open() )
+      inputStream.close();
+    inputStream.clear();
+}
+
+bool RinexFile::readLine(string &record)
+{
+  const char *line;
+  size_t      length;
+
+    if( lineSource == 0 )
+      return false;
+    if( !lineSource->nextLine( line, length ) )
+    {
+      checkInputSource();
+      return false;
+    }
+
+    record.assign( line, length );
+    return true;
+}
+
+bool RinexFile::readLineSpan(const char *&line, size_t &length)
+{
+    if( lineSource == 0 )
+      return false;
+    if( !lineSource->nextLine( line, length ) )
+    {
+      checkInputSource();
+      return false;
+    }
+    return true;
+}
+
+// A decoding source stops early on corrupt input; report that rather than
+// an early end of file.
+void RinexFile::checkInputSource()
+{
+    string  error = lineSource->getError();
+
+    if( !error.empty() )
+    {
+      tempStream << "Error decoding file: " << pathFilename << endl
+      << error << endl;
+      appendToErrorMessages( tempStream.str() );
+
+      RinexReadingException  excep( tempStream.str() );
+      throw excep;
+    }
+}
+
+
+void RinexFile::readFileTypeAndProgramName()
+{
+   string         inputRec;
+   string         recordReadIn;
+   bool  endOfHeaderFound = false;
+
+   if( !validFirstLine(recordReadIn) )
+   {
+     tempStream << "Error: First Line is incorrect in File: "
+     << getPathFilename() << endl << recordReadIn << endl;
+     appendToErrorMessages( tempStream.str() );
+     RequiredRecordMissingException excep( tempStream.str() );
+     throw excep;
+   }
+
+   // read all Header lines from line 2 to END OF HEADER
+   // until the PGM / RUN BY / DATE record is found
+   while( !endOfHeaderFound )
+   {
+     if( !readLine( inputRec ) )
+     {
+       // Error reading a header line of the RINEX File
+       tempStream << "Error reading a header line of file:" << endl
+       << getPathFilename() << endl;
+       appendToErrorMessages( tempStream.str() );
+       RinexReadingException  excep( tempStream.str() );
+       throw excep;
+     }
+
+     if( blankString(inputRec) )
+     {
+         if( formatVersion < 2.0 )
+         {
+           endOfHeaderFound = true;
+           break;   // end the while loop
+         }
+         else
+         {
+           continue;   // go to read the next record
+         }
+     }
+
+     if( inputRec.find( "END OF HEADER" ) == 60 )
+     {
+       endOfHeaderFound = true;
+       break;
+     }
+     else if( inputRec.find( "PGM / RUN BY / DATE" ) == 60 )
+     {
+       rinexProgram    = inputRec.substr(  0, 20 );
+       createdByAgency = inputRec.substr( 20, 20 );
+       dateFileCreated = inputRec.substr( 40, 20 );
+       endOfHeaderFound = true;
+       break;
+     }
+     else
+     {
+       continue;  // go to read the next record
+     }
+
+   } // end of while loop over all header records
+
+}
 
 
 
@@ -1733,49 +2256,40 @@ bool RinexFile::blankString(string inputStr)
 
 void RinexFile::makeRecordLength80(string &inputRec)
 {
-  string BlankString("                                        ");
-  size_t slen;
-
-   BlankString.append("                                        ");
    if( inputRec.length() > RINEXRECSIZE )
    {
       tempStream << "Warning! On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << " the Rinex record has " << inputRec.length()
       << " characters. This record will be truncated to 80 characters." << endl;
-      appendToWarningMessages( tempStream.str() );
-      inputRec = inputRec.substr(0,80);
+      appendToWarningMessages( tempStream.str(), DIAG_RECORDLENGTH );
+      inputRec.resize(80);
    }
    else if( inputRec.length() > 80  &&  inputRec.length() <= RINEXRECSIZE )
    {
-      inputRec = inputRec.substr(0,80);
+      inputRec.resize(80);
    }   
    else if( inputRec.length() < 80 )
    {
-     slen = 80 - inputRec.length();
-     inputRec.append(BlankString,0,slen);
+     inputRec.append( 80 - inputRec.length(), ' ' );  // pad in place
    }
 }
 
 
 void RinexFile::truncateHeaderRec(string &inputRec)
 {
-  string BlankString("                                        ");
-  size_t slen;
-
-   BlankString.append("                                        ");
    if( inputRec.length() > RINEXRECSIZE )
    {
       tempStream << "Warning! On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << " the Rinex record has " << inputRec.length()
       << " characters. This record will be truncated to 80 characters." << endl;
-      appendToWarningMessages( tempStream.str() );
-      inputRec = inputRec.substr(0,80);
+      appendToWarningMessages( tempStream.str(), DIAG_RECORDLENGTH );
+      inputRec.resize(80);
    }
    else if( inputRec.length() > 80  &&  inputRec.length() <= RINEXRECSIZE )
    {
-      inputRec = inputRec.substr(0,80);
+      inputRec.resize(80);
    }
 }
 
@@ -1800,7 +2314,7 @@ bool RinexFile::validFirstLine(string &recordReadIn)
   string temp;
 
 
-   if( getline( inputStream, inputRec, '\n') )
+   if( readLine( inputRec ) )
    {
       incrementNumberLinesRead(1);
       recordReadIn = inputRec;
@@ -1817,7 +2331,7 @@ bool RinexFile::validFirstLine(string &recordReadIn)
 	   tempStream << "On line #" << getNumberLinesRead() << ":"
            << endl << inputRec << endl
            << "Format version is  incorrect:" << temp << "." << endl;
-           appendToWarningMessages( tempStream.str() );
+           appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
            problemsFound = true;
          }
          rinexFileType = inputRec.substr( 20, 1 )[0];
@@ -1829,7 +2343,7 @@ bool RinexFile::validFirstLine(string &recordReadIn)
            << endl << inputRec << endl
            << "RINEX File Type is unacceptable:" << temp << "." << endl
 	   << "File Type must be O, N, M, G, H, or C !" << endl;
-           appendToWarningMessages( tempStream.str() );
+           appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
            problemsFound = true;
          }
 	 if( rinexFileType == 'O' )
@@ -1844,7 +2358,7 @@ bool RinexFile::validFirstLine(string &recordReadIn)
              << "Satellite System is unacceptable:" << temp << "." << endl
 	     << "Satellite System must be G, R, M, or blank !"  << endl
              << "Sat System = >" << satSystem << "<  " << endl;
-             appendToWarningMessages( tempStream.str() );
+             appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
              problemsFound = true;
            }
          } // satSystem is only used for OBS files
@@ -1854,7 +2368,7 @@ bool RinexFile::validFirstLine(string &recordReadIn)
 	 tempStream << "On line #" << getNumberLinesRead() << ":"
          << endl << inputRec << endl
          << "First line is not RINEX VERSION / TYPE ." << endl;
-         appendToWarningMessages( tempStream.str() );
+         appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
          problemsFound = true;
       }
 
@@ -1891,7 +2405,7 @@ bool RinexFile::getDouble(string input, double &output)
   {
     tempStream << "On line #" << getNumberLinesRead() << ","  << endl <<
     "overflow error in getDouble() reading string: >" << input << "<" << endl;
-    appendToWarningMessages( tempStream.str() );
+    appendToWarningMessages( tempStream.str(), DIAG_NUMBERFORMAT );
     return false;
   }
   else if ( l > 0 )
@@ -1908,7 +2422,7 @@ bool RinexFile::getDouble(string input, double &output)
         << "Illegal characters found while reading string: >"
         << input << "< " << endl
         << "The illegal characters are >" << p << "< " << endl;
-        appendToWarningMessages( tempStream.str() );
+        appendToWarningMessages( tempStream.str(), DIAG_NUMBERFORMAT );
         return false;
      }
   }
@@ -1930,7 +2444,7 @@ bool RinexFile::getLong(string input, long &output)
   {
     tempStream << "On line # " << getNumberLinesRead() << ","  << endl
     << "overflow error in getLong() reading string: " << input << endl;
-    appendToWarningMessages( tempStream.str() );
+    appendToWarningMessages( tempStream.str(), DIAG_NUMBERFORMAT );
     return false;
   }
   // LONG_MIN should be defined in _lim.h, if not, define it in rinex.h
@@ -1938,7 +2452,7 @@ bool RinexFile::getLong(string input, long &output)
   {
     tempStream << "On line # " << getNumberLinesRead() << "," << endl
     << "underflow error in getLong() reading string: " << input << endl;
-    appendToWarningMessages( tempStream.str() );
+    appendToWarningMessages( tempStream.str(), DIAG_NUMBERFORMAT );
     return false;
   }
   else if ( l > 0 )
@@ -1955,7 +2469,7 @@ bool RinexFile::getLong(string input, long &output)
         << "Illegal characters found while reading string: >"
         << input << "< " << endl
         << "The illegal characters are >" << p << "< " << endl;
-        appendToWarningMessages( tempStream.str() );
+        appendToWarningMessages( tempStream.str(), DIAG_NUMBERFORMAT );
         return false;
      }
   }
@@ -1964,6 +2478,156 @@ bool RinexFile::getLong(string input, long &output)
 }
 
 
+//---------------------------------------------------------------------------
+// getDoubleField(), getLongField()
+//    Decode the fixed-width field record[pos, pos+len) in place, without
+//    building a substring.  Only plain "[blanks][sign]digits[.digits][blanks]"
+//    fields are decoded here; anything else (exponents, tabs, illegal
+//    characters, ...) goes through getDouble()/getLong() so that the value
+//    and the warnings are exactly those of the strtod()/strtol() path.
+//
+//    The F14.3 decoder is exact: the digits are accumulated as an integer
+//    below 2^53 and divided once by an exactly representable power of ten,
+//    so the result is the correctly rounded value of the decimal string,
+//    which is also what strtod() returns.
+
+static const double exactPowersOf10[] = {
+   1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+   1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+static bool decodeFixedDouble(const char *p, size_t n, double &output)
+{
+  size_t    i = 0;
+  bool      negative = false;
+  long long mantissa = 0;
+  int       numDigits = 0;
+  int       numDecimals = 0;
+
+   while( i < n && p[i] == ' ' ) i++;
+   if( i == n )
+   {
+     output = 0.0;          // blank field, as strtod() leaves it
+     return true;
+   }
+
+   if( p[i] == '-' || p[i] == '+' )
+   {
+     negative = ( p[i] == '-' );
+     i++;
+   }
+   for( ; i < n && isdigit(p[i]); i++, numDigits++ )
+     mantissa = mantissa*10 + (p[i] - '0');
+   if( i < n && p[i] == '.' )
+   {
+     for( i++; i < n && isdigit(p[i]); i++, numDigits++, numDecimals++ )
+       mantissa = mantissa*10 + (p[i] - '0');
+   }
+   while( i < n && p[i] == ' ' ) i++;
+
+   if( i != n || numDigits == 0 || numDigits > 15 || numDecimals > 22 )
+     return false;
+
+   output = (double)mantissa / exactPowersOf10[numDecimals];
+   if( negative ) output = -output;
+   return true;
+}
+
+static bool decodeFixedLong(const char *p, size_t n, long &output)
+{
+  size_t    i = 0;
+  bool      negative = false;
+  long      value = 0;
+  int       numDigits = 0;
+
+   while( i < n && p[i] == ' ' ) i++;
+   if( i == n )
+   {
+     output = 0;
+     return true;
+   }
+
+   if( p[i] == '-' || p[i] == '+' )
+   {
+     negative = ( p[i] == '-' );
+     i++;
+   }
+   for( ; i < n && isdigit(p[i]); i++, numDigits++ )
+     value = value*10 + (p[i] - '0');
+   while( i < n && p[i] == ' ' ) i++;
+
+   if( i != n || numDigits == 0 || numDigits > 18 )
+     return false;
+
+   output = negative ? -value : value;
+   return true;
+}
+
+// True when record[pos, pos+len) holds only blanks.
+static bool blankColumns(const string &record, size_t pos, size_t len)
+{
+   for( size_t i = pos; i < pos + len && i < record.length(); i++ )
+     if( record[i] != ' ' )
+       return false;
+   return true;
+}
+
+
+bool RinexFile::getDoubleField(const string &record, size_t pos, size_t len,
+                               double &output)
+{
+   if( fastParse && pos <= record.length() &&
+       decodeFixedDouble( record.data() + pos,
+                          min( len, record.length() - pos ), output ) )
+     return true;
+
+   return getDouble( record.substr(pos, len), output );
+}
+
+
+// Same as above for a record span that has not been blank-padded to 80
+// columns: columns beyond recordLength read as blanks.
+bool RinexFile::getDoubleField(const char *record, size_t recordLength,
+                               size_t pos, size_t len, double &output)
+{
+  size_t available = ( pos < recordLength ) ? min( len, recordLength - pos ) : 0;
+
+   if( fastParse && decodeFixedDouble( record + pos, available, output ) )
+     return true;
+
+   string field( len, ' ' );
+   if( available > 0 )
+     field.replace( 0, available, record + pos, available );
+   return getDouble( field, output );
+}
+
+
+bool RinexFile::getLongField(const string &record, size_t pos, size_t len,
+                             long &output)
+{
+   if( fastParse && pos <= record.length() &&
+       decodeFixedLong( record.data() + pos,
+                        min( len, record.length() - pos ), output ) )
+     return true;
+
+   return getLong( record.substr(pos, len), output );
+}
+
+
+bool RinexFile::getLongField(const char *record, size_t recordLength,
+                             size_t pos, size_t len, long &output)
+{
+  size_t available = ( pos < recordLength ) ? min( len, recordLength - pos ) : 0;
+
+   if( fastParse && decodeFixedLong( record + pos, available, output ) )
+     return true;
+
+   string field( len, ' ' );
+   if( available > 0 )
+     field.replace( 0, available, record + pos, available );
+   return getLong( field, output );
+}
+
+
 bool RinexFile::validYMDHMS(long year, long month, long day, long hour,
                             long minute, double second, string &warningString)
 {
@@ -2012,8 +2676,63 @@ bool RinexFile::validYMDHMS(long year, long month, long day, long hour,
 
 //========================== RinexObsFile Class ===============================
 
+// The epoch index sidecar: a header, then one entry per epoch, all in the
+// byte order of the machine that wrote it.
+namespace {
+
+   const char      INDEXMAGIC[8] = { 'R','N','X','O','I','D','X','\n' };
+   const uint32_t  INDEXBYTEORDER = 0x01020304;
+   const uint32_t  INDEXVERSION = 2;
+   const unsigned long long  NORANGEEND = ~0ULL;
+
+   struct IndexFileHeader
+   {
+      char      magic[8];
+      uint32_t  byteOrder;
+      uint32_t  version;
+      uint64_t  fileSize;      // of the observation file
+      int64_t   fileTime;      // its modification time, in file clock ticks
+      uint64_t  numEntries;
+      uint64_t  numLines;      // read when the index ended
+   };
+
+   struct IndexFileEntry
+   {
+      double    gpsTime;
+      uint64_t  offset;
+      uint64_t  lineNumber;
+      uint16_t  numSat;
+      uint16_t  epochFlag;
+      uint32_t  reserved;
+   };
+
+   bool fileStamp( const string &filename, unsigned long long &size,
+                   long long &time )
+   {
+      std::error_code  error;
+      std::filesystem::path  path( filename );
+
+      size = std::filesystem::file_size( path, error );
+      if( error )
+        return false;
+      time = std::filesystem::last_write_time( path, error ).time_since_epoch().count();
+      return !error;
+   }
+
+   double gpsSeconds( DateTime time )
+   {
+      GPSTime gps = time.GetGPSTime();
+      return gps.GPSWeek * 604800.0 + gps.secsOfWeek;
+   }
+
+   bool entryBefore( const ObsIndexEntry &entry, double gpsTime )
+   {
+      return entry.gpsTime < gpsTime;
+   }
+}
+
 // Initialize static data member
-unsigned int  RinexObsFile::numberObsFiles = 0;   // no objects yet
+atomic<unsigned int>  RinexObsFile::numberObsFiles( 0 );   // no objects yet
 
 // Constructors
 RinexObsFile::RinexObsFile() : RinexFile()  // calls the base class constructor
@@ -2021,6 +2740,10 @@ RinexObsFile::RinexObsFile() : RinexFile()  // calls the base class constructor
     initializeData();
     numberObsEpochs = 0;
     numberObsFiles++;
+    indexedSize = 0;
+    indexedLines = 0;
+    rangeEnd = NORANGEEND;
+    projected = false;
 }
 
 RinexObsFile::RinexObsFile(string inputFilePath, ios::openmode mode)
@@ -2029,6 +2752,10 @@ RinexObsFile::RinexObsFile(string inputFilePath, ios::openmode mode)
     initializeData();
     numberObsEpochs = 0;
     numberObsFiles++;
+    indexedSize = 0;
+    indexedLines = 0;
+    rangeEnd = NORANGEEND;
+    projected = false;
 }
 
 // Destructor
@@ -2565,7 +3292,7 @@ unsigned short RinexObsFile::readHeader()
    // read all Header lines from line 2 until the end of header
    while( !endOfHeaderFound )
    {
-     if( !getline( inputStream, inputRec, '\n') )
+     if( !readLine( inputRec ) )
      {
        // Error reading a header line of the OBS File
        tempStream << "Error reading a header line of file:" << endl
@@ -2591,7 +3318,7 @@ unsigned short RinexObsFile::readHeader()
            tempStream << "Warning! On line #" << getNumberLinesRead() << ":"
 	   << endl << inputRec << endl
 	   << " Blank header record found, skipping to next line. " << endl;
-           appendToWarningMessages( tempStream.str() );
+           appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
            continue;   // go to read the next record
          }
      }
@@ -2614,14 +3341,14 @@ unsigned short RinexObsFile::readHeader()
         << endl	<< inputRec << endl
 	<< "EPOCH/SAT Flag Record found in Header, skipping to next line."
         << endl << "Check file for location of END OF HEADER record." << endl;
-        appendToWarningMessages( tempStream.str() );
+        appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
         continue;  // go to read the next record
      }
 
      tempStream << "Warning! On line #" << getNumberLinesRead() << ":"
      << endl << inputRec << endl
      << "Unknown Record Type found in Header, skipping to next line." << endl;
-     appendToWarningMessages( tempStream.str() );
+     appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
 
    } // end of while loop over all header records
 
@@ -2742,7 +3469,7 @@ bool RinexObsFile::validHeaderRecord(string inputRec)
            << " Distance of XYZ coords from origin = " << distance << endl
 	   << "6,000,000.0 < Allowed Distance from earth center < 6,400,000.0 "
 	   << " meters." << endl;
-           appendToWarningMessages( tempStream.str() );
+           appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
          }
          return true;
       }
@@ -2781,7 +3508,7 @@ bool RinexObsFile::validHeaderRecord(string inputRec)
 	     << " a bad L1 Wavelength factor was found: " << L1_fac << endl
 	     << " The program will set L1_fac = 1 ." << endl;
              L1_fac = 1;
-             appendToWarningMessages( tempStream.str() );
+             appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
          }
          if( L2_fac > 2 )
 	 {
@@ -2790,7 +3517,7 @@ bool RinexObsFile::validHeaderRecord(string inputRec)
 	     << " a bad L2 Wavelength factor was found: " << L2_fac << endl
 	     << " The program will set L2_fac = 1 ." << endl;
              L2_fac = 1;
-             appendToWarningMessages( tempStream.str() );
+             appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
          }
 
          if( num_sat == 0 )
@@ -2855,7 +3582,7 @@ bool RinexObsFile::validHeaderRecord(string inputRec)
 	     tempStream << "On line #" << getNumberLinesRead() << ":"
              << endl << inputRec << endl
              << "Warning! Unrecognized Observation Type: " << obsType << endl;
-             appendToWarningMessages( tempStream.str() );
+             appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
            }
            i++;
          }
@@ -2873,7 +3600,7 @@ bool RinexObsFile::validHeaderRecord(string inputRec)
 	   tempStream << "On line #" << getNumberLinesRead() << ":"
            << endl << inputRec << endl
            << "Negative Observation Interval: " << obsInterval << endl;
-           appendToWarningMessages( tempStream.str() );
+           appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
          }
          return true;
       }
@@ -2900,7 +3627,7 @@ bool RinexObsFile::validHeaderRecord(string inputRec)
            << endl << inputRec << endl
            << "Error reading RCV CLOCK OFFS APPL flag: "
 	   << rcvrClockApplied << endl;
-           appendToWarningMessages( tempStream.str() );
+           appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
          }
          return true;
       }
@@ -2940,7 +3667,7 @@ bool RinexObsFile::validHeaderRecord(string inputRec)
            << endl << inputRec << endl
            << "Problems reading Date and Time of First Obs: " << endl
 	   << warningString << endl;
-           appendToWarningMessages( tempStream.str() );
+           appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
          }
 
          firstObsTimeSystem = inputRec.substr( 48,  3 );
@@ -2951,7 +3678,7 @@ bool RinexObsFile::validHeaderRecord(string inputRec)
            << endl << inputRec << endl
            << "Unrecognized Time System for First Obs: "
 	   << firstObsTimeSystem << endl;
-           appendToWarningMessages( tempStream.str() );
+           appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
          }
 // Check for years that are not four digits
 
@@ -2963,7 +3690,7 @@ bool RinexObsFile::validHeaderRecord(string inputRec)
                  << headerRecs[ FirstObsTimeRec ].recID
                  << " record is not four digits: "
                  << firstObs.year << "." << endl;
-                 appendToWarningMessages( tempStream.str() );
+                 appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
 
             firstObs.year = firstObs.year % 100;
 
@@ -3011,7 +3738,7 @@ bool RinexObsFile::validHeaderRecord(string inputRec)
            << endl << inputRec << endl
            << "Problems reading Date and Time of Last Obs: "
 	   << warningString << endl;
-           appendToWarningMessages( tempStream.str() );
+           appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
          }
 
          lastObsTimeSystem = inputRec.substr( 48,  3 );
@@ -3022,7 +3749,7 @@ bool RinexObsFile::validHeaderRecord(string inputRec)
            << endl << inputRec << endl
            << "Unrecognized Time System for Last Obs: "
 	   << lastObsTimeSystem << endl;
-           appendToWarningMessages( tempStream.str() );
+           appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
          }
 // Check for years that are not four digits
 
@@ -3034,7 +3761,7 @@ bool RinexObsFile::validHeaderRecord(string inputRec)
                  << headerRecs[ LastObsTimeRec ].recID
                  << " record is not four digits: "
                  << lastObs.year << "." << endl;
-            appendToWarningMessages( tempStream.str() );
+            appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
 
             lastObs.year = lastObs.year % 100;
 
@@ -3090,7 +3817,7 @@ bool RinexObsFile::validHeaderRecord(string inputRec)
            << "Number of PRN / # OF OBS records exceeds program"
            << endl << "limit for maximum number of satellites. Record ignored."
            << endl;
-           appendToWarningMessages( tempStream.str() );
+           appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
          }
          nextSat++;
          return true;
@@ -3105,34 +3832,40 @@ bool RinexObsFile::validHeaderRecord(string inputRec)
          tempStream << "On line #" << getNumberLinesRead() << ":"
          << endl << inputRec << endl
          << " there is an invalid header record." << endl;
-         appendToWarningMessages( tempStream.str() );
+         appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
 	 return false;
       }
 }
 
-bool RinexObsFile::validEventFlagRecord(string inputRec)
+bool RinexObsFile::validEventFlagRecord(const string &record)
 {
   // Note: an Event Flag record may have only 2 fields filled: the event flag
   // and the number of records to follow.
 
   string  warningString;
-  string  cols71thru80;
-  string  cols2thru26;
+  string  padded;
   string  temp;
   YMDHMS  ymdhms;   // defined in datetime.h
   long    tempL, col29 = -1;
   double  tempD;
+  size_t  i;
 
-  makeRecordLength80(inputRec);
+  // readEpochRecords() hands over records already padded to 80 columns
+  if( record.length() != 80 )
+  {
+    padded = record;
+    makeRecordLength80(padded);
+  }
+  const string &inputRec = ( record.length() != 80 ) ? padded : record;
 
-  cols71thru80 = inputRec.substr(70,10);
   // there should be no letters in the rcvr clk offset field
-  if( alphasInString(cols71thru80) )
+  for( i = 70; i < 80 && !isalpha(inputRec[i]); i++ ) ;
+  if( i < 80 )
   {
     tempStream << "On line #" << getNumberLinesRead() << ":"
     << endl << inputRec << endl
     << " letters were found the Receiver Clock Offset field." << endl;
-    appendToWarningMessages( tempStream.str() );
+    appendToWarningMessages( tempStream.str(), DIAG_EPOCHRECORD );
     return false;
   }
 
@@ -3152,33 +3885,26 @@ bool RinexObsFile::validEventFlagRecord(string inputRec)
     tempStream << " On line #" << getNumberLinesRead() << ":"
     << endl << inputRec << endl
     << " a formatting error was found in columns 1 through 29."  << endl;
-    appendToWarningMessages( tempStream.str() );
+    appendToWarningMessages( tempStream.str(), DIAG_EPOCHRECORD );
     return false;
   }
 
    // Check the YMDHMS values if they are present
-   cols2thru26 = inputRec.substr(1,25);
-   if( !blankString(cols2thru26) )
+   if( !blankColumns(inputRec, 1, 25) )
    {
-     temp = inputRec.substr( 1, 2 );
-     if( getLong(temp, tempL) )
+     if( getLongField(inputRec, 1, 2, tempL) )
        ymdhms.year = tempL;
      if(ymdhms.year >= 80 && ymdhms.year <= 99)ymdhms.year = ymdhms.year + 1900;
      if(ymdhms.year >= 0 && ymdhms.year <= 79)ymdhms.year = ymdhms.year + 2000;
-     temp = inputRec.substr( 4, 2 );
-     if( getLong(temp, tempL) )
+     if( getLongField(inputRec, 4, 2, tempL) )
        ymdhms.month = tempL;
-     temp = inputRec.substr( 7, 2 );
-     if( getLong(temp, tempL) )
+     if( getLongField(inputRec, 7, 2, tempL) )
        ymdhms.day = tempL;
-     temp = inputRec.substr( 10, 2 );
-     if( getLong(temp, tempL) )
+     if( getLongField(inputRec, 10, 2, tempL) )
        ymdhms.hour = tempL;
-     temp = inputRec.substr( 13, 2 );
-     if( getLong(temp, tempL) )
+     if( getLongField(inputRec, 13, 2, tempL) )
        ymdhms.min = tempL;
-     temp = inputRec.substr( 15, 11 );
-     if( getDouble(temp, tempD) )
+     if( getDoubleField(inputRec, 15, 11, tempD) )
        ymdhms.sec = tempD;
      if( !validYMDHMS(ymdhms.year, ymdhms.month, ymdhms.day,
                       ymdhms.hour, ymdhms.min, ymdhms.sec, warningString) )
@@ -3186,7 +3912,7 @@ bool RinexObsFile::validEventFlagRecord(string inputRec)
         tempStream << " On line #" << getNumberLinesRead() << ":"
         << endl << inputRec << endl
         << warningString << endl;
-        appendToWarningMessages( tempStream.str() );
+        appendToWarningMessages( tempStream.str(), DIAG_EPOCHRECORD );
         return false;
      }
    } // do only when a date/time is present in the Event Flag record
@@ -3209,7 +3935,7 @@ bool RinexObsFile::validObservationsRecord(string inputRec)
     tempStream << "On line #" << getNumberLinesRead() << ":"
     << endl << inputRec << endl
     << "Illegal alphabetic characters found in Data record." << endl;
-    appendToWarningMessages( tempStream.str() );
+    appendToWarningMessages( tempStream.str(), DIAG_OBSERVATION );
     return false;
    }
 
@@ -3221,7 +3947,7 @@ bool RinexObsFile::validObservationsRecord(string inputRec)
     tempStream << "On line #" << getNumberLinesRead() << ":"
     << endl << inputRec << endl
     << "No decimal points found in Data record." << endl;
-    appendToWarningMessages( tempStream.str() );
+    appendToWarningMessages( tempStream.str(), DIAG_OBSERVATION );
     return false;
    }
 
@@ -3235,7 +3961,7 @@ bool RinexObsFile::validObservationsRecord(string inputRec)
        tempStream << "On line #" << getNumberLinesRead() << ":"
        << endl << inputRec << endl
        << "Illegal observation found in Data record: " << obs[i] << endl;
-       appendToWarningMessages( tempStream.str() );
+       appendToWarningMessages( tempStream.str(), DIAG_OBSERVATION );
        return false;
      }
    }
@@ -3249,124 +3975,152 @@ void RinexObsFile::writeHeaderImage(ofstream &outputStream)
 }
 
 unsigned short RinexObsFile::readEpoch( ObsEpoch &inputEpoch )
+{
+   if( pastRangeEnd() )
+     return( 0 );
+   return( readEpochRecords( inputEpoch, 0 ) );
+}
+
+//---------------------------------------------------------------------------
+// readEpoch()
+//    Reads a single "epoch" into the observation type columns of an ObsBatch.
+//    Event records (flags 2-5) leave the batch with no satellites.
+
+unsigned short RinexObsFile::readEpoch( ObsBatch &batch )
+{
+   if( pastRangeEnd() )
+     return( 0 );
+   return( readEpochRecords( batchEpoch, &batch ) );
+}
+
+//---------------------------------------------------------------------------
+// readEpochRecords()
+//    Reads the time-tag record and the records that follow it.  The epoch
+//    header always goes to inputEpoch; the observations go to the batch
+//    columns when a batch is given and to inputEpoch's satList otherwise.
+
+unsigned short RinexObsFile::readEpochRecords( ObsEpoch &inputEpoch,
+                                               ObsBatch *batch )
 {
    unsigned short tempUS;
    ostringstream  stringStream;
    unsigned short appendLen;
-   string         saveSatCode = "";
-   unsigned short saveSatNum[MAXSATPEREPOCH];
    unsigned short i;
-   string         inputRec;
    short          j;
    size_t         slen;
-   string         temp;
-   string         tempLLI;
-   string         tempSigStrength;
-   string         working;
-   string         cols2thru26;
+   const char    *line;
+   size_t         lineLength;
+   const char    *prnLine;
+   size_t         prnLength;
+   const char    *recLine[2];
+   size_t         recLength[2];
+   bool           inPlace;
+   short          k, col;
+   char           lliChar, sigChar;
    YMDHMS         ymdhms;
    DateTime       tempDateTime;
    SatObsAtEpoch  tempSatObsAtEpoch;
    double         tempDouble, tempD;
    long           tempL;
+   unsigned short tempLLI, tempSig;
+   bool           satOK;
+   bool           decodeType[MAXOBSTYPES];
+   bool           decodeSat;
+   char           sysCode;
    bool eventFlagRecordOK = false;
    bool timeTagOK = false;
    inputEpoch.initializeData();
+   if( batch )
+     batch->reset( numObsTypes, obsTypeList );
 
  // Find the next good "time-tag"/Event Flag record.
  while( !eventFlagRecordOK )
  {
-  if( !getline( inputStream, inputRec, '\n') )
+  if( !readLineSpan( line, lineLength ) )
   {
     return (0);   // return 0 when end of file is encountered
   }
   incrementNumberLinesRead(1);
-  makeRecordLength80( inputRec );  // missing fields have been filled in
+  epochRecord.assign( line, lineLength );
+  makeRecordLength80( epochRecord );  // missing fields have been filled in
 
 
 
-  if( validEventFlagRecord(inputRec) )
+  if( validEventFlagRecord(epochRecord) )
   {
     eventFlagRecordOK = true;
 
     // Check the YMDHMS values if they are present
-    cols2thru26 = inputRec.substr(1,25);
-    if( !blankString(cols2thru26) )
+    if( !blankColumns(epochRecord, 1, 25) )
     {
       timeTagOK = true;
 
-      temp = inputRec.substr( 1, 2 );
-      if( temp == "  " )
+      if( blankColumns(epochRecord, 1, 2) )
       {
        tempStream << "On line #" << getNumberLinesRead() << ":"
-       << endl << inputRec << endl
+       << endl << epochRecord << endl
        << "Warning ! Year in time tag is missing." << endl;
-       appendToWarningMessages( tempStream.str() );
+       appendToWarningMessages( tempStream.str(), DIAG_EPOCHRECORD );
        timeTagOK = false;
       }
-      if( getLong(temp, tempL) )
+      if( getLongField(epochRecord, 1, 2, tempL) )
         ymdhms.year = tempL;
       if(ymdhms.year >= 80 && ymdhms.year <= 99)ymdhms.year = ymdhms.year + 1900;
       if(ymdhms.year >= 0 && ymdhms.year <= 79)ymdhms.year = ymdhms.year + 2000;
 
-      temp = inputRec.substr( 4, 2 );
-      if( temp == "  " )
+      if( blankColumns(epochRecord, 4, 2) )
       {
        tempStream << "On line #" << getNumberLinesRead() << ":"
-       << endl << inputRec << endl
+       << endl << epochRecord << endl
        << "Warning ! Month in time tag is missing." << endl;
-       appendToWarningMessages( tempStream.str() );
+       appendToWarningMessages( tempStream.str(), DIAG_EPOCHRECORD );
        timeTagOK = false;
       }
-      if( getLong(temp, tempL) )
+      if( getLongField(epochRecord, 4, 2, tempL) )
         ymdhms.month = tempL;
 
-      temp = inputRec.substr( 7, 2 );
-      if( temp == "  " )
+      if( blankColumns(epochRecord, 7, 2) )
       {
        tempStream << "On line #" << getNumberLinesRead() << ":"
-       << endl << inputRec << endl
+       << endl << epochRecord << endl
        << "Warning ! Day in time tag is missing." << endl;
-       appendToWarningMessages( tempStream.str() );
+       appendToWarningMessages( tempStream.str(), DIAG_EPOCHRECORD );
        timeTagOK = false;
       }
-      if( getLong(temp, tempL) )
+      if( getLongField(epochRecord, 7, 2, tempL) )
         ymdhms.day = tempL;
 
-      temp = inputRec.substr( 10, 2 );
-      if( temp == "  " )
+      if( blankColumns(epochRecord, 10, 2) )
       {
        tempStream << "On line #" << getNumberLinesRead() << ":"
-       << endl << inputRec << endl
+       << endl << epochRecord << endl
        << "Warning ! Hour in time tag is missing." << endl;
-       appendToWarningMessages( tempStream.str() );
+       appendToWarningMessages( tempStream.str(), DIAG_EPOCHRECORD );
        timeTagOK = false;
       }
-      if( getLong(temp, tempL) )
+      if( getLongField(epochRecord, 10, 2, tempL) )
         ymdhms.hour = tempL;
 
-      temp = inputRec.substr( 13, 2 );
-      if( temp == "  " )
+      if( blankColumns(epochRecord, 13, 2) )
       {
        tempStream << "On line #" << getNumberLinesRead() << ":"
-       << endl << inputRec << endl
+       << endl << epochRecord << endl
        << "Warning ! Minute in time tag is missing." << endl;
-       appendToWarningMessages( tempStream.str() );
+       appendToWarningMessages( tempStream.str(), DIAG_EPOCHRECORD );
        timeTagOK = false;
       }
-      if( getLong(temp, tempL) )
+      if( getLongField(epochRecord, 13, 2, tempL) )
         ymdhms.min = tempL;
 
-      temp = inputRec.substr( 15, 11 );
-      if( temp == "           " )
+      if( blankColumns(epochRecord, 15, 11) )
       {
        tempStream << "On line #" << getNumberLinesRead() << ":"
-       << endl << inputRec << endl
+       << endl << epochRecord << endl
        << "Warning ! Seconds in time tag is missing." << endl;
-       appendToWarningMessages( tempStream.str() );
+       appendToWarningMessages( tempStream.str(), DIAG_EPOCHRECORD );
        timeTagOK = false;
       }
-      if( getDouble(temp, tempD) )
+      if( getDoubleField(epochRecord, 15, 11, tempD) )
         ymdhms.sec = tempD;
       // Note: these ymdhms values have already
       // been validated in validEventFlagRecord()
@@ -3379,26 +4133,25 @@ unsigned short RinexObsFile::readEpoch( ObsEpoch &inputEpoch )
     } // do this only if there is a time tag in columns 2 through 26
 
 
-    temp = inputRec.substr( 26, 3 );
-    if( getLong(temp, tempL) )
+    if( getLongField(epochRecord, 26, 3, tempL) )
       tempUS = static_cast< unsigned short >( tempL );
     if( !inputEpoch.setEpochFlag(tempUS) )
     {
       tempStream << "On line #" << getNumberLinesRead() << ":"
-      << endl << inputRec << endl
-      << "   Bad epoch flag encountered: " << temp << "." << endl;
-      appendToWarningMessages( tempStream.str() );
+      << endl << epochRecord << endl
+      << "   Bad epoch flag encountered: " << epochRecord.substr( 26, 3 )
+      << "." << endl;
+      appendToWarningMessages( tempStream.str(), DIAG_EPOCHRECORD );
     }
 
-    temp = inputRec.substr( 29, 3 );
-    if( getLong(temp, tempL) )
+    if( getLongField(epochRecord, 29, 3, tempL) )
         tempUS = static_cast< unsigned short >( tempL );
     if( !inputEpoch.setNumSat(tempUS) )
     {
      tempStream << "On line #" << getNumberLinesRead() << ":"
-     << endl << inputRec << endl
+     << endl << epochRecord << endl
      << "Warning ! More than 999 satellites/#lines found." << endl;
-     appendToWarningMessages( tempStream.str() );
+     appendToWarningMessages( tempStream.str(), DIAG_EPOCHRECORD );
     }
 
     break; // exit this while loop once a good EPOCH/SAT record has been found
@@ -3406,12 +4159,15 @@ unsigned short RinexObsFile::readEpoch( ObsEpoch &inputEpoch )
   else
   {
      tempStream << "Warning ! A valid EPOCH/SAT record has not been found yet:"
-     << endl << inputRec << endl
+     << endl << epochRecord << endl
      << "Now searching ahead for the next good time tag line." << endl;
-     appendToWarningMessages( tempStream.str() );
+     appendToWarningMessages( tempStream.str(), DIAG_EPOCHRECORD );
   }
 } // end of while loop to search for next good Time Tag/Event Flag Record
 
+if( batch )
+  batch->setEpochHeader( inputEpoch );
+
 
 
 
@@ -3420,14 +4176,14 @@ unsigned short RinexObsFile::readEpoch( ObsEpoch &inputEpoch )
 if( inputEpoch.getEpochFlag() >= 2  &&  inputEpoch.getEpochFlag() <= 5 )
 {
    tempStream << "On line # " << getNumberLinesRead() << ":"
-   << endl << inputRec << endl
+   << endl << epochRecord << endl
    << "Warning! An Event Flag has been found of type: "
    << inputEpoch.getEpochFlag() << "."
    << endl << inputEpoch.getEpochHeaderRecords();
 
    for( i = 0; i < inputEpoch.getNumSat(); i++ )
    {
-     if( !getline( inputStream, inputRec, '\n') )
+     if( !readLine( spareRecord ) )
      {
        // Error reading records following an Event Flag
        tempStream << "Error reading records after Event Flag in file:" << endl
@@ -3438,18 +4194,18 @@ if( inputEpoch.getEpochFlag() >= 2  &&  inputEpoch.getEpochFlag() <= 5 )
        throw excep;
      }
      incrementNumberLinesRead(1);
-     makeRecordLength80( inputRec );
-     inputEpoch.appendToEpochHeaderRecords(inputRec);
-     tempStream << inputRec << endl;  // append epoch header records to warn.
-     if( !validHeaderRecord(inputRec) ) // update private data in RinexObsFile
+     makeRecordLength80( spareRecord );
+     inputEpoch.appendToEpochHeaderRecords(spareRecord);
+     tempStream << spareRecord << endl;  // append epoch header records to warn.
+     if( !validHeaderRecord(spareRecord) ) // update private data in RinexObsFile
      {
        tempStream << "Warning ! On line #" << getNumberLinesRead() << ":"
-       << endl << inputRec << endl
+       << endl << spareRecord << endl
        << "  an invalid epoch header record was found." << endl;
-       appendToWarningMessages( tempStream.str() );
+       appendToWarningMessages( tempStream.str(), DIAG_EVENTFLAG );
      }
    } // end of loop over all records following event flag 2,3,4,5
-   appendToWarningMessages( tempStream.str() );
+   appendToWarningMessages( tempStream.str(), DIAG_EVENTFLAG );
 
 } // do the above when event flags 2,3,4,5 are encountered
 
@@ -3458,81 +4214,83 @@ if( inputEpoch.getEpochFlag() >= 2  &&  inputEpoch.getEpochFlag() <= 5 )
 if( inputEpoch.getEpochFlag() == 0 || inputEpoch.getEpochFlag() == 1 ||
     inputEpoch.getEpochFlag() == 6 )
 {
-   temp = inputRec.substr( 68, 12 );
-   if( getDouble(temp, tempD) )
+   if( getDoubleField(epochRecord, 68, 12, tempD) )
    {
      if( !inputEpoch.setRecClockOffset(tempD) )
      {
       tempStream << "On line #" << getNumberLinesRead() << ":"
-      << endl << inputRec << endl
-      << "   bad receiver clock offset encountered: " << temp << "." << endl;
-      appendToWarningMessages( tempStream.str() );
+      << endl << epochRecord << endl
+      << "   bad receiver clock offset encountered: "
+      << epochRecord.substr( 68, 12 ) << "." << endl;
+      appendToWarningMessages( tempStream.str(), DIAG_EPOCHRECORD );
      }
    }
    if( inputEpoch.getNumSat() > MAXSATPEREPOCH )
    {
      tempStream << " On line #" << getNumberLinesRead() << ":"
-     << endl << inputRec << endl
+     << endl << epochRecord << endl
      << "Warning ! More than " << MAXSATPEREPOCH << " Satellites: "
      << inputEpoch.getNumSat() << "." << endl;
      inputEpoch.setNumSat( 12 ); // reset numSat, try to skip to the next epoch
    }
+   if( batch )
+     batch->setNumSat( inputEpoch.getNumSat() );
 
-   if( inputEpoch.getNumSat() <= 12 )
+   // 12 PRNs per record; more satellites continue on the following records,
+   // which are decoded where they lie
+   prnListCodes.clear();
+   prnListNums.assign( inputEpoch.getNumSat(), 9999 );
+   prnLine = epochRecord.data();
+   prnLength = epochRecord.length();
+   for ( i = 0; i < inputEpoch.getNumSat(); i++ )
    {
-      for ( i = 0; i < inputEpoch.getNumSat(); i++ )
-      {
-        temp = inputRec.substr( (32 + i*3), 1 );
-        saveSatCode.append( temp );
-        temp = inputRec.substr( (32 + (i*3) + 1), 2 );
-        if( getLong(temp, tempL) )
-          saveSatNum[i] = static_cast< unsigned short >( tempL );
-      }
-   }
-   else
-   {
-      for ( i = 0; i < 12; i++ )
-      {
-        temp = inputRec.substr( (32 + i*3), 1 );
-        saveSatCode.append( temp );
-        temp = inputRec.substr( (32 + (i*3) + 1), 2 );
-        if( getLong(temp, tempL) )
-          saveSatNum[i] = static_cast< unsigned short >( tempL );
-      }
-      temp = inputRec;
-      if( !getline( inputStream, inputRec, '\n') )
+      if( i > 0  &&  i % 12 == 0 )
       {
-        // Error reading more than 12 PRNs following a EPOCH/SAT record
-        tempStream << "Error reading more than 12 PRNs after record: "
-        << temp << endl << "in file: " << getPathFilename() << endl;
-        appendToErrorMessages( tempStream.str() );
-
-        RinexReadingException  excep( tempStream.str() );
-        throw excep;
-      }
-      incrementNumberLinesRead(1);
-      for (int  k = 12; k < inputEpoch.getNumSat(); k++ )
-      {
-        i = k - 12;
-        temp = inputRec.substr( (32 + i*3), 1 );
-        saveSatCode.append( temp );
-        temp = inputRec.substr( (32 + (i*3) + 1), 2 );
-        if( getLong(temp, tempL) )
-          saveSatNum[k] = static_cast< unsigned short >( tempL );
+        if( !readLineSpan( prnLine, prnLength ) )
+        {
+          // Error reading more than 12 PRNs following a EPOCH/SAT record
+          tempStream << "Error reading more than " << i
+          << " PRNs after record: "
+          << epochRecord << endl << "in file: " << getPathFilename() << endl;
+          appendToErrorMessages( tempStream.str() );
+
+          RinexReadingException  excep( tempStream.str() );
+          throw excep;
+        }
+        incrementNumberLinesRead(1);
+        if( prnLength > 80 )   // warn about and cut an overlong record
+        {
+          spareRecord.assign( prnLine, prnLength );
+          makeRecordLength80( spareRecord );
+          prnLine = spareRecord.data();
+          prnLength = spareRecord.length();
+        }
       }
+      col = 32 + (i % 12)*3;
+      prnListCodes.push_back( (size_t)col < prnLength ? prnLine[col] : ' ' );
+      if( getLongField(prnLine, prnLength, col + 1, 2, tempL) )
+        prnListNums[i] = static_cast< unsigned short >( tempL );
    }
 
    if( inputEpoch.getEpochFlag() == 6 )
    {
+     spareRecord.assign( prnLine, prnLength );
+     makeRecordLength80( spareRecord );
      tempStream << " On line #" << getNumberLinesRead() << ":"
-     << endl << inputRec << endl
+     << endl << spareRecord << endl
      << "Warning ! An Event Flag has been found of type: "
      << inputEpoch.getEpochFlag() << "." << endl;
    }
 
+   // the fields left out of the projection are skipped, not decoded
+   for( j = 0; j < numObsTypes; j++ )
+     decodeType[j] = !projected ||
+                     find( projectedTypes.begin(), projectedTypes.end(),
+                           obsTypeList[j] ) != projectedTypes.end();
+
    for( i = 0; i < inputEpoch.getNumSat(); i++ )
    {
-     if( !getline( inputStream, inputRec, '\n') )
+     if( !readLineSpan( line, lineLength ) )
      {
        // Error reading observation/cycle slip records following an Epoch Flag
        tempStream << "Error reading data records after Epoch Flag, in file:"
@@ -3543,14 +4301,29 @@ if( inputEpoch.getEpochFlag() == 0 || inputEpoch.getEpochFlag() == 1 ||
        throw excep;
      }
      incrementNumberLinesRead(1);
-     working = inputRec;
-     makeRecordLength80( working );
 
-     if( inputEpoch.getEpochFlag() == 6 ) tempStream << working << endl;
+     // Decode the fields straight from the input record(s) when possible;
+     // otherwise build the blank-padded 80 (or 160) column working record.
+     inPlace = fastParse && inputEpoch.getEpochFlag() != 6 &&
+               lineLength <= RINEXRECSIZE &&
+               ( numObsTypes <= 5 || lineSource->linesPersist() );
+     if( inPlace )
+     {
+       recLine[0] = line;
+       recLength[0] = min( lineLength, (size_t)80 );
+       recLength[1] = 0;
+     }
+     else
+     {
+       dataRecord.assign( line, lineLength );
+       makeRecordLength80( dataRecord );
+     }
+
+     if( inputEpoch.getEpochFlag() == 6 ) tempStream << dataRecord << endl;
 
      if ( numObsTypes > 5 )
      {
-         if( !getline( inputStream, inputRec, '\n') )
+         if( !readLineSpan( line, lineLength ) )
          {
            // Error reading observation/cycle slip records when #obs > 5
            tempStream << "Error reading data records when #obs > 5, in file:"
@@ -3561,41 +4334,83 @@ if( inputEpoch.getEpochFlag() == 0 || inputEpoch.getEpochFlag() == 1 ||
            throw excep;
          }
          incrementNumberLinesRead(1);
-         makeRecordLength80( inputRec );
-         working.append( inputRec );   // add second line to first line
+         if( inPlace && lineLength <= RINEXRECSIZE )
+         {
+           recLine[1] = line;
+           recLength[1] = min( lineLength, (size_t)80 );
+         }
+         else
+         {
+           if( inPlace )   // the first line is still mapped
+           {
+             dataRecord.assign( recLine[0], recLength[0] );
+             makeRecordLength80( dataRecord );
+             inPlace = false;
+           }
+           spareRecord.assign( line, lineLength );
+           makeRecordLength80( spareRecord );
+           dataRecord.append( spareRecord );   // add second line to first line
+         }
      }
 
+     satOK = !batch || batch->setSatellite( i, prnListCodes[i], prnListNums[i] );
+     sysCode = ( prnListCodes[i] == ' ' ) ? 'G' : prnListCodes[i];
+     decodeSat = !projected || projectedSystems.find( sysCode ) != string::npos;
+
      for ( j = 0; j < numObsTypes ; j++ )
       {
          tempDouble      = 0.0;
-         temp            = working.substr( (j*16),   14 );
-         if( getDouble(temp, tempD) ) tempDouble = tempD;
-         tempLLI         = working.substr( (j*16)+14, 1 );
-         tempSigStrength = working.substr( (j*16)+15, 1 );
+         if( !decodeSat || !decodeType[j] )
+         {
+           if( batch )
+           {
+             batch->clearObservation( j, i );
+             continue;
+           }
+           lliChar = sigChar = ' ';   // an ObsEpoch gets a blank field
+         }
+         else if( inPlace )
+         {
+           k = j / 5;        // record line holding this field
+           col = (j % 5)*16;
+           if( k < 2 && getDoubleField(recLine[k], recLength[k], col, 14, tempD) )
+             tempDouble = tempD;
+           lliChar = ( k < 2 && (size_t)(col + 14) < recLength[k] ) ? recLine[k][col+14] : ' ';
+           sigChar = ( k < 2 && (size_t)(col + 15) < recLength[k] ) ? recLine[k][col+15] : ' ';
+         }
+         else
+         {
+           if( getDoubleField(dataRecord, (j*16), 14, tempD) ) tempDouble = tempD;
+           lliChar = ( (size_t)(j*16)+14 < dataRecord.length() ) ? dataRecord[(j*16)+14] : '\0';
+           sigChar = ( (size_t)(j*16)+15 < dataRecord.length() ) ? dataRecord[(j*16)+15] : '\0';
+         }
 
-         if ( fabs(tempDouble) > 0.0001 )
+         if( batch )
+         {
+            tempLLI = isdigit(lliChar) ?
+                      static_cast< unsigned short >( lliChar - '0' ) : 0;
+            tempSig = isdigit(sigChar) ?
+                      static_cast< unsigned short >( sigChar - '0' ) : 0;
+            if( !batch->setObservation( j, i, tempDouble, tempLLI, tempSig ) )
+              satOK = false;
+         }
+         else if ( fabs(tempDouble) > 0.0001 )
          {
             tempSatObsAtEpoch.obsList[ j ].obsPresent = true;
             tempSatObsAtEpoch.obsList[ j ].observation = tempDouble;
             tempSatObsAtEpoch.obsList[ j ].obsType = obsTypeList[j];
 
-            if( tempLLI == " " )
+            if( lliChar == ' ' )
                tempSatObsAtEpoch.obsList[ j ].LLI = 0;
-            if( isdigit(tempLLI[0]) )
-            {
-               if( getLong(tempLLI, tempL) )
-                 tempSatObsAtEpoch.obsList[ j ].LLI =
-	         static_cast< unsigned short >( tempL );
-            }
+            if( isdigit(lliChar) )
+               tempSatObsAtEpoch.obsList[ j ].LLI =
+               static_cast< unsigned short >( lliChar - '0' );
 
-            if( tempSigStrength == " " )
+            if( sigChar == ' ' )
                tempSatObsAtEpoch.obsList[ j ].sigStrength = 0;
-            if( isdigit(tempSigStrength[0]) )
-            {
-               if( getLong(tempSigStrength, tempL) )
-                 tempSatObsAtEpoch.obsList[ j ].sigStrength =
-                 static_cast< unsigned short >( tempL );
-            }
+            if( isdigit(sigChar) )
+               tempSatObsAtEpoch.obsList[ j ].sigStrength =
+               static_cast< unsigned short >( sigChar - '0' );
          }
          else
          {
@@ -3607,20 +4422,35 @@ if( inputEpoch.getEpochFlag() == 0 || inputEpoch.getEpochFlag() == 1 ||
          }
       }  // for ( j=0; ...
 
-      tempSatObsAtEpoch.satCode = saveSatCode[i];
-      tempSatObsAtEpoch.satNum = saveSatNum[i];
-      if( !inputEpoch.setSatListElement(tempSatObsAtEpoch, numObsTypes, i) )
+      if( !batch )
       {
+        tempSatObsAtEpoch.satCode = prnListCodes[i];
+        tempSatObsAtEpoch.satNum = prnListNums[i];
+        satOK = inputEpoch.setSatListElement(tempSatObsAtEpoch, numObsTypes, i);
+      }
+      if( !satOK )
+      {
+        if( inPlace )   // rebuild the text of the record for the warning
+        {
+          dataRecord.assign( recLine[0], recLength[0] );
+          makeRecordLength80( dataRecord );
+          if( numObsTypes > 5 )
+          {
+            spareRecord.assign( recLine[1], recLength[1] );
+            makeRecordLength80( spareRecord );
+            dataRecord.append( spareRecord );
+          }
+        }
         tempStream << "Warning ! On line #" << getNumberLinesRead()
         << "   bad SV name, observation, LLI, or S/N value encountered: "
-        << endl << working << endl;
-        appendToWarningMessages( tempStream.str() );
+        << endl << dataRecord << endl;
+        appendToWarningMessages( tempStream.str(), DIAG_OBSERVATION );
       }
 
    }  // for ( i=0; ...
 
    if( inputEpoch.getEpochFlag() == 6 )
-     appendToWarningMessages( tempStream.str() );
+     appendToWarningMessages( tempStream.str(), DIAG_OBSERVATION );
 
 }// do the above when the Event Flag is 0,1,6
 
@@ -3630,11 +4460,164 @@ if( inputEpoch.getEpochFlag() == 0 || inputEpoch.getEpochFlag() == 1 ||
 //---------------------------------------------------------------------------
 // writeEpoch()
 //    Writes a single "epoch" of data with time-tag record and all satellite
-//    records to the output data file.
+//    records to the output data file.  The records are built in outputRecord
+//    and written with one call; writeEpochStream() is the original ostream
+//    version of the same output, used when fastFormat is off.
 
 void RinexObsFile::writeEpoch(ofstream &outputOBS, ObsEpoch &outputEpoch)
 {
-   unsigned short   i, j;
+   unsigned short   i, j, k;
+   YMDHMS           ymdhms;
+
+   if( !fastFormat )
+   {
+     writeEpochStream( outputOBS, outputEpoch );
+     return;
+   }
+
+   RecordFormatter &record = outputRecord;
+   unsigned short numSat = outputEpoch.getNumSat();
+   unsigned short epochFlag = outputEpoch.getEpochFlag();
+   unsigned short numTypes = getNumObsTypes();
+   double clockOffset = outputEpoch.getRecClockOffset();
+   record.clear();
+
+// Write the EPOCH/SAT record.
+   ymdhms = outputEpoch.getEpochTime().GetYMDHMS();
+
+   if( ymdhms.year != 9999 )
+   {
+     record.append( ' ' );
+     record.appendInt( ymdhms.year % 100, 2, '0' );
+     record.append( ' ' );
+     record.appendInt( ymdhms.month, 2 );
+     record.append( ' ' );
+     record.appendInt( ymdhms.day, 2 );
+     record.append( ' ' );
+     record.appendInt( ymdhms.hour, 2 );
+     record.append( ' ' );
+     record.appendInt( ymdhms.min, 2 );
+     record.appendFixed( ymdhms.sec, 11, 7 );
+   }
+   else
+     record.appendBlanks( 26 );  // 26 blanks if no ymdhms
+
+   if ( epochFlag != 9999 )
+   {
+      record.appendBlanks( 2 );
+      record.appendInt( epochFlag, 1 );
+   }
+   else
+      record.appendBlanks( 3 );
+
+   if ( numSat != 9999 )
+      record.appendInt( numSat, 3 );
+   else
+      record.appendBlanks( 3 );
+
+   for ( i = 0; i < 12; i++ )  // do all 12 so that spacers can be inserted
+   {
+      const SatObsAtEpoch &satObs = outputEpoch.getSatListElementRef(i);
+      if ( satObs.satNum != 9999 )
+      {
+         record.append( satObs.satCode );
+         record.appendInt( satObs.satNum, 2 );
+      }
+      else   // output spacers for PRN-list when rcvr clk offset is present
+      {
+         if ( clockOffset != 9999.0  && fabs(clockOffset) > 0.0000000001 )
+            record.appendBlanks( 3 );
+      }
+   }
+
+   // Note: the recever clock offset is written to 9 decimal places (f12.9)
+   // so test for values larger than zero or larger than 0.0000000001 .
+   if ( !(clockOffset == 9999.0  || fabs(clockOffset) < 0.0000000001) )
+      record.appendFixed( clockOffset, 12, 9 );
+   record.append( '\n' );
+
+
+// Write either satellite obs records or header records, if there are any.
+
+   if ( numSat != ( unsigned short ) 9999  &&
+        (epochFlag == 0 || epochFlag == 1 || epochFlag == 6)  )
+   {
+
+     // Write PRN list extension lines here, if necessary (no rcvr clock offset)
+     for ( k = 12; k < numSat; k += 12 )
+     {
+        record.appendBlanks( 32 );
+        for ( i = k; i < k + 12; i++ ) // add up to 12 more svs per line
+        {
+           const SatObsAtEpoch &satObs = outputEpoch.getSatListElementRef(i);
+           if ( satObs.satNum != 9999 )
+           {
+              record.append( satObs.satCode );
+              record.appendInt( satObs.satNum, 2 );
+           }
+        }
+        record.append( '\n' );
+     }
+
+      for ( i = 0; i < numSat; i++ )
+      {
+         const SatObsAtEpoch &satObs = outputEpoch.getSatListElementRef(i);
+
+         // Write each observation value for each satellite.
+         for( j = 0; j < numTypes; j++ )
+         {
+            bool padded = j != (numTypes - 1)  &&  ((j+1) % 5) != 0;
+            const ObsSet &obs = satObs.obsList[j];
+
+            if ( j != 0 &&  j % 5 == 0 )  // Max. 5 obs. per line
+               record.append( '\n' );
+
+            if ( obs.obsPresent )
+            {
+               record.appendFixed( obs.observation, 14, 3 );
+
+               if( obs.LLI == (unsigned short)9999 || obs.LLI == 0 )
+               {
+                  if( padded )
+                    record.append( ' ' );
+               }
+               else
+                  record.appendInt( obs.LLI, 1 );
+
+               if( obs.sigStrength == (unsigned short)9999 || obs.sigStrength == 0 )
+               {
+                  if( padded )
+                    record.append( ' ' );
+               }
+               else
+                  record.appendInt( obs.sigStrength, 1 );
+            }
+            else if( padded )
+            {
+               // If this type of obs. is missing from the record for this
+               // satellite, fill it in with blanks (when obsPresent = false).
+               record.appendBlanks( 16 );
+            }
+         } // j-loop over numObsTypes
+         record.append( '\n' );
+      } // i-loop over numSat
+   }
+   else if( epochFlag >= 2 && epochFlag <= 5 )
+   {
+      // output Event Flag records
+      record.append( outputEpoch.getEpochHeaderRecords() );
+   }
+
+   record.flush( outputOBS );
+}
+
+//---------------------------------------------------------------------------
+// writeEpochStream()
+//    writeEpoch() through ostream insertions, one field at a time.
+
+void RinexObsFile::writeEpochStream(ofstream &outputOBS, ObsEpoch &outputEpoch)
+{
+   unsigned short   i, j, k;
    YMDHMS       ymdhms;
 
 // Write the EPOCH/SAT record.
@@ -3676,10 +4659,11 @@ void RinexObsFile::writeEpoch(ofstream &outputOBS, ObsEpoch &outputEpoch)
 
    for ( i = 0; i < 12; i++ )  // do all 12 so that spacers can be inserted
    {
-      if ( outputEpoch.getSatListElement(i).satNum != 9999 )
+      const SatObsAtEpoch &satObs = outputEpoch.getSatListElementRef(i);
+      if ( satObs.satNum != 9999 )
       {
-         outputOBS << setw( 1 ) << outputEpoch.getSatListElement(i).satCode;
-         outputOBS << setw( 2 ) << outputEpoch.getSatListElement(i).satNum;
+         outputOBS << setw( 1 ) << satObs.satCode;
+         outputOBS << setw( 2 ) << satObs.satNum;
       }
       else   // output spacers for PRN-list when rcvr clk offset is present
       {
@@ -3712,16 +4696,17 @@ void RinexObsFile::writeEpoch(ofstream &outputOBS, ObsEpoch &outputEpoch)
          || outputEpoch.getEpochFlag() == 6)  )
    {
 
-     // Write PRN list extension line here, if necessary (no rcvr clock offset)
-     if( outputEpoch.getNumSat() > 12 )
+     // Write PRN list extension lines here, if necessary (no rcvr clock offset)
+     for ( k = 12; k < outputEpoch.getNumSat(); k += 12 )
      {
         outputOBS << "                                ";     // 32 blanks
-        for ( i = 12; i < 24; i++ ) // add up to 12 more svs
+        for ( i = k; i < k + 12; i++ ) // add up to 12 more svs per line
         {
-           if ( outputEpoch.getSatListElement(i).satNum != 9999 )
+           const SatObsAtEpoch &satObs = outputEpoch.getSatListElementRef(i);
+           if ( satObs.satNum != 9999 )
            {
-            outputOBS << setw( 1 ) << outputEpoch.getSatListElement(i).satCode;
-            outputOBS << setw( 2 ) << outputEpoch.getSatListElement(i).satNum;
+            outputOBS << setw( 1 ) << satObs.satCode;
+            outputOBS << setw( 2 ) << satObs.satNum;
            }
         }
         outputOBS << endl;
@@ -3729,6 +4714,8 @@ void RinexObsFile::writeEpoch(ofstream &outputOBS, ObsEpoch &outputEpoch)
 
       for ( i = 0; i < (unsigned short) outputEpoch.getNumSat(); i++ )
       {
+         const SatObsAtEpoch &satObs = outputEpoch.getSatListElementRef(i);
+
          // Write each observation value for each satellite.
          for( j = 0; j < getNumObsTypes(); j++ )
          {
@@ -3737,19 +4724,19 @@ void RinexObsFile::writeEpoch(ofstream &outputOBS, ObsEpoch &outputEpoch)
                outputOBS << endl;
             }
 
-            if ( outputEpoch.getSatListElement(i).obsList[ j ].obsPresent )
+            if ( satObs.obsList[ j ].obsPresent )
             {
 
                outputOBS.setf( ios::fixed );
                outputOBS.setf( ios::showpoint );
 
                outputOBS << setw( 14 ) << setprecision( 3 )
-               << outputEpoch.getSatListElement(i).obsList[j].observation;
+               << satObs.obsList[j].observation;
 
 
-               if( outputEpoch.getSatListElement(i).obsList[j].LLI ==
+               if( satObs.obsList[j].LLI ==
                    (unsigned short)9999 ||
-                   outputEpoch.getSatListElement(i).obsList[j].LLI == 0 )
+                   satObs.obsList[j].LLI == 0 )
                {
                   if( j != (getNumObsTypes() - 1)  &&   ((j+1) % 5) != 0 )
                   outputOBS << " ";
@@ -3757,13 +4744,13 @@ void RinexObsFile::writeEpoch(ofstream &outputOBS, ObsEpoch &outputEpoch)
                else
                {
                   outputOBS << setw(1)
-                  << outputEpoch.getSatListElement(i).obsList[j].LLI;
+                  << satObs.obsList[j].LLI;
                }
 
 
-               if(outputEpoch.getSatListElement(i).obsList[j].sigStrength ==
+               if(satObs.obsList[j].sigStrength ==
                   (unsigned short)9999 ||
-                  outputEpoch.getSatListElement(i).obsList[j].sigStrength == 0 )
+                  satObs.obsList[j].sigStrength == 0 )
                {
                   if( j != (getNumObsTypes() - 1)  &&   ((j+1) % 5) != 0 )
                   outputOBS << " ";
@@ -3771,7 +4758,7 @@ void RinexObsFile::writeEpoch(ofstream &outputOBS, ObsEpoch &outputEpoch)
                else
                {
                  outputOBS << setw(1)
-                 << outputEpoch.getSatListElement(i).obsList[j].sigStrength;
+                 << satObs.obsList[j].sigStrength;
                }
             }
             else
@@ -3850,10 +4837,259 @@ unsigned int RinexObsFile::getObsFilesCount()
   return( numberObsFiles );
 }
 
+//---------------------------------------------------------------------------
+// openIndex()
+//    Loads the epoch index from its sidecar file, or, when there is none or
+//    it was made for a different size or modification time of the
+//    observation file, builds the index and writes the sidecar.  A sidecar
+//    that cannot be written (e.g. in a read-only directory) only means that
+//    the index is built again next time.
+
+bool RinexObsFile::openIndex(string indexFilename)
+{
+   unsigned long long  fileSize;
+   long long           fileTime;
+
+   if( indexFilename.empty() )
+     indexFilename = pathFilename + ".idx";
+   if( !fileStamp( pathFilename, fileSize, fileTime ) )
+     return false;
+
+   indexedSize = fileSize;
+   if( loadIndex( indexFilename, fileSize, fileTime ) )
+     return true;
+   if( !buildIndex() )
+     return false;
+   saveIndex( indexFilename, fileSize, fileTime );
+   return true;
+}
+
+//---------------------------------------------------------------------------
+// seekToTime()
+//    Positions the file so that the next readEpoch() returns the first
+//    epoch at or after time, by a binary search of the epoch index.  A time
+//    after the last epoch leaves the file at its end.
+
+bool RinexObsFile::seekToTime(DateTime time)
+{
+   vector<ObsIndexEntry>::iterator  entry;
+
+   if( lineSource == 0 || ( epochIndex.empty() && !openIndex() ) )
+     return false;
+
+   entry = lower_bound( epochIndex.begin(), epochIndex.end(),
+                        gpsSeconds( time ), entryBefore );
+   if( !lineSource->seek( entry == epochIndex.end() ? indexedSize
+                                                    : entry->offset ) )
+     return false;
+
+   // line numbers in warnings continue from the new position
+   numberLinesRead = ( entry == epochIndex.end() ) ? indexedLines
+                                                   : entry->lineNumber;
+   return true;
+}
+
+//---------------------------------------------------------------------------
+// readRange()
+//    Restricts reading to a time window: seeks to the first epoch at or
+//    after startTime, and readEpoch() returns 0 after the last epoch at or
+//    before endTime (and the events that follow it).
+
+bool RinexObsFile::readRange(DateTime startTime, DateTime endTime)
+{
+   vector<ObsIndexEntry>::iterator  entry;
+
+   if( !seekToTime( startTime ) )
+     return false;
+
+   // the first entry after endTime; later events share an earlier time
+   entry = upper_bound( epochIndex.begin(), epochIndex.end(),
+                        gpsSeconds( endTime ),
+                        []( double gpsTime, const ObsIndexEntry &e )
+                        { return gpsTime < e.gpsTime; } );
+   rangeEnd = ( entry == epochIndex.end() ) ? NORANGEEND : entry->offset;
+   return true;
+}
+
+void RinexObsFile::clearRange()
+{
+   rangeEnd = NORANGEEND;
+}
+
+unsigned long RinexObsFile::getNumIndexedEpochs()
+{
+   return( epochIndex.size() );
+}
+
+ObsIndexEntry RinexObsFile::getIndexEntry(unsigned long i)
+{
+   return( epochIndex[i] );
+}
+
+void RinexObsFile::setProjection(const string &satCodes,
+                                 const vector<enum OBSTYPE> &types)
+{
+   projected = true;
+   projectedSystems = satCodes;
+   projectedTypes = types;
+}
+
+void RinexObsFile::clearProjection()
+{
+   projected = false;
+   projectedSystems.clear();
+   projectedTypes.clear();
+}
+
+bool RinexObsFile::getProjected()
+{
+   return( projected );
+}
+
+string RinexObsFile::getProjectedSystems()
+{
+   return( projectedSystems );
+}
+
+vector<enum OBSTYPE> RinexObsFile::getProjectedTypes()
+{
+   return( projectedTypes );
+}
+
+bool RinexObsFile::pastRangeEnd()
+{
+   return( rangeEnd != NORANGEEND && lineSource != 0 &&
+           lineSource->tell() >= rangeEnd );
+}
+
+//---------------------------------------------------------------------------
+// buildIndex()
+//    Reads every epoch of the file with a reader of its own, so that this
+//    file's position, warnings and errors are left alone.  An epoch's
+//    offset is where the reader stood before reading it.  The index ends at
+//    the first epoch that cannot be read.
+
+bool RinexObsFile::buildIndex()
+{
+   RinexObsFile   scanner;
+   ObsBatch       batch;
+   ObsIndexEntry  entry;
+   double         lastTime = 0.0;
+
+   scanner.setUseMemoryMap( useMemoryMap );
+   try
+   {
+     scanner.setPathFilenameMode( pathFilename, ios::in );
+     scanner.readHeader();
+   }
+   catch( ... )
+   {
+     return false;
+   }
+   scanner.setFastParse( true );
+   scanner.setProjection( "", vector<enum OBSTYPE>() );   // only the epoch headers
+
+   epochIndex.clear();
+   try
+   {
+     for( ;; )
+     {
+       entry.offset = scanner.lineSource->tell();
+       entry.lineNumber = scanner.numberLinesRead;
+       if( scanner.readEpoch( batch ) == 0 )
+         break;
+
+       if( scanner.batchEpoch.getEpochTime().GetYMDHMS().year != 9999 )
+         lastTime = gpsSeconds( scanner.batchEpoch.getEpochTime() );
+       entry.gpsTime = lastTime;
+       entry.numSat = scanner.batchEpoch.getNumSat();
+       entry.epochFlag = scanner.batchEpoch.getEpochFlag();
+       epochIndex.push_back( entry );
+     }
+   }
+   catch( RinexReadingException & )
+   {
+     // index the epochs before the one that could not be read
+   }
+   indexedLines = scanner.numberLinesRead;
+
+   return true;
+}
+
+bool RinexObsFile::loadIndex(string indexFilename,
+                             unsigned long long fileSize, long long fileTime)
+{
+   IndexFileHeader  header;
+   IndexFileEntry   record;
+   ObsIndexEntry    entry;
+
+   ifstream  indexFile( indexFilename.c_str(), ios::in | ios::binary );
+   if( !indexFile.read( reinterpret_cast< char * >( &header ), sizeof( header ) ) )
+     return false;
+   if( memcmp( header.magic, INDEXMAGIC, sizeof( INDEXMAGIC ) ) != 0 ||
+       header.byteOrder != INDEXBYTEORDER || header.version != INDEXVERSION ||
+       header.fileSize != fileSize || header.fileTime != fileTime ||
+       header.numEntries > fileSize )
+     return false;
+   indexedLines = static_cast< unsigned long >( header.numLines );
+
+   epochIndex.clear();
+   epochIndex.reserve( static_cast< size_t >( header.numEntries ) );
+   for( uint64_t i = 0; i < header.numEntries; i++ )
+   {
+     if( !indexFile.read( reinterpret_cast< char * >( &record ), sizeof( record ) ) )
+     {
+       epochIndex.clear();   // truncated
+       return false;
+     }
+     entry.gpsTime = record.gpsTime;
+     entry.offset = record.offset;
+     entry.lineNumber = static_cast< unsigned long >( record.lineNumber );
+     entry.numSat = record.numSat;
+     entry.epochFlag = record.epochFlag;
+     epochIndex.push_back( entry );
+   }
+   return true;
+}
+
+bool RinexObsFile::saveIndex(string indexFilename,
+                             unsigned long long fileSize, long long fileTime)
+{
+   IndexFileHeader  header;
+   IndexFileEntry   record;
+
+   ofstream  indexFile( indexFilename.c_str(),
+                        ios::out | ios::binary | ios::trunc );
+   if( !indexFile )
+     return false;
+
+   memcpy( header.magic, INDEXMAGIC, sizeof( INDEXMAGIC ) );
+   header.byteOrder = INDEXBYTEORDER;
+   header.version = INDEXVERSION;
+   header.fileSize = fileSize;
+   header.fileTime = fileTime;
+   header.numEntries = epochIndex.size();
+   header.numLines = indexedLines;
+   indexFile.write( reinterpret_cast< const char * >( &header ), sizeof( header ) );
+
+   record.reserved = 0;
+   for( size_t i = 0; i < epochIndex.size(); i++ )
+   {
+     record.gpsTime = epochIndex[i].gpsTime;
+     record.offset = epochIndex[i].offset;
+     record.lineNumber = epochIndex[i].lineNumber;
+     record.numSat = epochIndex[i].numSat;
+     record.epochFlag = epochIndex[i].epochFlag;
+     indexFile.write( reinterpret_cast< const char * >( &record ), sizeof( record ) );
+   }
+   indexFile.close();
+   return !indexFile.fail();
+}
+
 //========================== RinexNavFile Class ===============================
 
 // Initialize static data member
-unsigned int  RinexNavFile::numberNavFiles = 0;   // no objects yet
+atomic<unsigned int>  RinexNavFile::numberNavFiles( 0 );   // no objects yet
 
 // Constructors
 
@@ -3945,7 +5181,7 @@ unsigned short RinexNavFile::readHeader()
    // read from line 2 until the end of header
    while( !endOfHeaderFound )
    {
-     if( !getline( inputStream, inputRec, '\n') )
+     if( !readLine( inputRec ) )
      {
        // Error reading a header line of the NAV File
        tempStream << "Error reading a header line of file:" << endl
@@ -3969,7 +5205,7 @@ unsigned short RinexNavFile::readHeader()
            tempStream << "Warning! On line #" << getNumberLinesRead() << ":"
 	   << endl << inputRec << endl
 	   << " Not a Valid Header record, skipping to next line. " << endl;
-           appendToWarningMessages( tempStream.str() );
+           appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
            continue;   // go to read the next record
          }
      }
@@ -4117,7 +5353,7 @@ bool RinexNavFile::validHeaderRecord(string inputRec)
       {
          tempStream << "Invalid NAV header record: " << endl
          << inputRec << endl;
-         appendToWarningMessages( tempStream.str() );
+         appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
 	 return false;
       }
 }
@@ -4182,7 +5418,7 @@ unsigned short RinexNavFile::readPRNBlock( PRNBlock &prnBlock )
 
 // Read epoch "time-tag" record.
 
-   if ( !getline( inputStream, inputRec, '\n') )
+   if ( !readLine( inputRec ) )
    {
       return 0;   // EOF encountered
    }
@@ -4198,7 +5434,7 @@ unsigned short RinexNavFile::readPRNBlock( PRNBlock &prnBlock )
       tempStream << "On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  an invalid Satellite PRN was found: " << temp << "." << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
    }
    temp = inputRec.substr( 3, 2 );
    if( getLong(temp, tempL) )
@@ -4212,7 +5448,7 @@ unsigned short RinexNavFile::readPRNBlock( PRNBlock &prnBlock )
       tempStream << "On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  an invalid TOC year was found: " << temp << "." << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
    }
 
    temp = inputRec.substr( 6, 2 );
@@ -4223,7 +5459,7 @@ unsigned short RinexNavFile::readPRNBlock( PRNBlock &prnBlock )
       tempStream << "On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  an invalid TOC month was found: " << temp << "." << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
    }
 
    temp = inputRec.substr( 9, 2 );
@@ -4234,7 +5470,7 @@ unsigned short RinexNavFile::readPRNBlock( PRNBlock &prnBlock )
       tempStream << "On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  an invalid TOC day was found: " << temp << "." << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
    }
 
    temp = inputRec.substr( 12, 2 );
@@ -4245,7 +5481,7 @@ unsigned short RinexNavFile::readPRNBlock( PRNBlock &prnBlock )
       tempStream << "On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  an invalid TOC hour was found: " << temp << "." << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
    }
 
    temp = inputRec.substr( 15, 2 );
@@ -4256,7 +5492,7 @@ unsigned short RinexNavFile::readPRNBlock( PRNBlock &prnBlock )
       tempStream << "On line #" << getNumberLinesRead() << ":"
      << endl << inputRec << endl
       << "  and invalid TOC minute was found: " << temp << "." << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
    }
 
    temp = inputRec.substr( 17, 5 );
@@ -4267,7 +5503,7 @@ unsigned short RinexNavFile::readPRNBlock( PRNBlock &prnBlock )
       tempStream << "On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  an invalid TOC second was found: " << temp << "." << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
      }
    }
    temp = inputRec.substr( 22, 19);
@@ -4285,12 +5521,12 @@ unsigned short RinexNavFile::readPRNBlock( PRNBlock &prnBlock )
 
 // Read the first line after the PRN number and time tag
 
-   if (  !getline( inputStream, inputRec, '\n') )
+   if (  !readLine( inputRec ) )
    {
       tempStream << "Warning! On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  error reading the first data line of a PRN Block." << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
       return 0;
    }
    incrementNumberLinesRead(1);
@@ -4316,12 +5552,12 @@ unsigned short RinexNavFile::readPRNBlock( PRNBlock &prnBlock )
 
 // Read the 2nd line after the PRN number and time tag
 
-   if (  !getline( inputStream, inputRec, '\n') )
+   if (  !readLine( inputRec ) )
    {
       tempStream << "Warning! On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  error reading the second data line of a PRN Block: " << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
       return 0;
    }
    incrementNumberLinesRead(1);
@@ -4347,12 +5583,12 @@ unsigned short RinexNavFile::readPRNBlock( PRNBlock &prnBlock )
 
 // Read the 3rd line after the PRN number and time tag
 
-   if ( !getline( inputStream, inputRec, '\n') )
+   if ( !readLine( inputRec ) )
    {
       tempStream << "Warning! On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  error reading the third data line of a PRN Block." << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
       return 0;
    }
    incrementNumberLinesRead(1);
@@ -4378,12 +5614,12 @@ unsigned short RinexNavFile::readPRNBlock( PRNBlock &prnBlock )
 
 // Read the 4th line after the PRN number and time tag
 
-   if ( !getline( inputStream, inputRec, '\n') )
+   if ( !readLine( inputRec ) )
    {
       tempStream << "Warning! On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  error reading the fourth data line of a PRN Block." << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
       return 0;
    }
    incrementNumberLinesRead(1);
@@ -4410,12 +5646,12 @@ unsigned short RinexNavFile::readPRNBlock( PRNBlock &prnBlock )
 
 // Read the 5th line after the PRN number and time tag
 
-   if ( !getline( inputStream, inputRec, '\n') )
+   if ( !readLine( inputRec ) )
    {
       tempStream << "Warning! On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  error reading the fifth data line of a PRN Block."  << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
       return 0;
    }
    incrementNumberLinesRead(1);
@@ -4441,12 +5677,12 @@ unsigned short RinexNavFile::readPRNBlock( PRNBlock &prnBlock )
 
 // Read the 6th line after the PRN number and time tag
 
-   if ( !getline( inputStream, inputRec, '\n') )
+   if ( !readLine( inputRec ) )
    {
       tempStream << "Warning ! On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  error reading the sixth data line of a PRN Block."  << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
       return 0;
    }
    incrementNumberLinesRead(1);
@@ -4471,12 +5707,12 @@ unsigned short RinexNavFile::readPRNBlock( PRNBlock &prnBlock )
 
 // Read the 7th line after the PRN number and time tag
 
-   if ( !getline( inputStream, inputRec, '\n') )
+   if ( !readLine( inputRec ) )
    {
       tempStream << "Warning! On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  error reading the seventh data line of a PRN Block."  << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
       return 0;
    }
    incrementNumberLinesRead(1);
@@ -4657,7 +5893,7 @@ unsigned int RinexNavFile::getNavFilesCount()
 //======================= GlonassNavFile Class =============================
 
 // Initialize static data member
-unsigned int  GlonassNavFile::numberFiles = 0;   // no objects yet
+atomic<unsigned int>  GlonassNavFile::numberFiles( 0 );   // no objects yet
 
 
 // Constructors
@@ -4735,7 +5971,7 @@ unsigned short GlonassNavFile::readHeader()
    // read from line 2 until the end of header
    while( !endOfHeaderFound )
    {
-     if( !getline( inputStream, inputRec, '\n') )
+     if( !readLine( inputRec ) )
      {
        // Error reading a header line of the NAV File
        tempStream << "Error reading a header line of file:" << endl
@@ -4760,7 +5996,7 @@ unsigned short GlonassNavFile::readHeader()
            tempStream << "Warning! On line #" << getNumberLinesRead() << ":"
 	   << endl << inputRec << endl
 	   << " Not a Valid Header record, skipping to next line. " << endl;
-           appendToWarningMessages( tempStream.str() );
+           appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
            continue;   // go to read the next record
          }
      }
@@ -4870,7 +6106,7 @@ bool GlonassNavFile::validHeaderRecord(string inputRec)
       {
          tempStream << "Invalid NAV header record: " << endl
          << inputRec << endl;
-         appendToWarningMessages( tempStream.str() );
+         appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
 	 return false;
       }
 }
@@ -4921,7 +6157,7 @@ unsigned short GlonassNavFile::readEphemEpoch( GlonassEphemEpoch &navEpoch )
 
 // Read epoch "time-tag" record.
 
-   if ( !getline( inputStream, inputRec, '\n') )
+   if ( !readLine( inputRec ) )
    {
       return 0;   // EOF encountered
    }
@@ -4938,7 +6174,7 @@ unsigned short GlonassNavFile::readEphemEpoch( GlonassEphemEpoch &navEpoch )
       << endl << inputRec << endl
       << "  an invalid Satellite Almanac Number was found: " 
       << temp << "." << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
    }
    temp = inputRec.substr( 3, 2 );
    if( getLong(temp, tempL) )
@@ -4952,7 +6188,7 @@ unsigned short GlonassNavFile::readEphemEpoch( GlonassEphemEpoch &navEpoch )
       tempStream << "On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  an invalid epoch year was found: " << temp << "." << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
    }
 
    temp = inputRec.substr( 6, 2 );
@@ -4963,7 +6199,7 @@ unsigned short GlonassNavFile::readEphemEpoch( GlonassEphemEpoch &navEpoch )
       tempStream << "On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  an invalid epoch month was found: " << temp << "." << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
    }
 
    temp = inputRec.substr( 9, 2 );
@@ -4974,7 +6210,7 @@ unsigned short GlonassNavFile::readEphemEpoch( GlonassEphemEpoch &navEpoch )
       tempStream << "On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  an invalid epoch day was found: " << temp << "." << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
    }
 
    temp = inputRec.substr( 12, 2 );
@@ -4985,7 +6221,7 @@ unsigned short GlonassNavFile::readEphemEpoch( GlonassEphemEpoch &navEpoch )
       tempStream << "On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  an invalid epoch hour was found: " << temp << "." << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
    }
 
    temp = inputRec.substr( 15, 2 );
@@ -4996,7 +6232,7 @@ unsigned short GlonassNavFile::readEphemEpoch( GlonassEphemEpoch &navEpoch )
       tempStream << "On line #" << getNumberLinesRead() << ":"
      << endl << inputRec << endl
       << "  and invalid epoch minute was found: " << temp << "." << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
    }
 
    temp = inputRec.substr( 17, 5 );
@@ -5007,7 +6243,7 @@ unsigned short GlonassNavFile::readEphemEpoch( GlonassEphemEpoch &navEpoch )
       tempStream << "On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  an invalid epoch second was found: " << temp << "." << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
      }
    }
    temp = inputRec.substr( 22, 19);
@@ -5025,12 +6261,12 @@ unsigned short GlonassNavFile::readEphemEpoch( GlonassEphemEpoch &navEpoch )
 
 // Read the first line after the Satellite Almanac number and time tag
 
-   if (  !getline( inputStream, inputRec, '\n') )
+   if (  !readLine( inputRec ) )
    {
       tempStream << "Warning! On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  error reading the first data line of a Nav Epoch." << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
       return 0;
    }
    incrementNumberLinesRead(1);
@@ -5056,12 +6292,12 @@ unsigned short GlonassNavFile::readEphemEpoch( GlonassEphemEpoch &navEpoch )
 
 // Read the 2nd line after the Satellite Almanac number and time tag
 
-   if (  !getline( inputStream, inputRec, '\n') )
+   if (  !readLine( inputRec ) )
    {
       tempStream << "Warning! On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  error reading the second data line of a Nav Epoch: " << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
       return 0;
    }
    incrementNumberLinesRead(1);
@@ -5087,12 +6323,12 @@ unsigned short GlonassNavFile::readEphemEpoch( GlonassEphemEpoch &navEpoch )
 
 // Read the 3rd line after the Satellite Almanac number and time tag
 
-   if ( !getline( inputStream, inputRec, '\n') )
+   if ( !readLine( inputRec ) )
    {
       tempStream << "Warning! On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  error reading the third data line of a Nav Epoch." << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
       return 0;
    }
    incrementNumberLinesRead(1);
@@ -5224,7 +6460,7 @@ unsigned int GlonassNavFile::getFilesCount()
 //===================== Geostationary NavFile Class ===========================
 
 // Initialize static data member
-unsigned int  GeostationaryNavFile::numberFiles = 0;   // no objects yet
+atomic<unsigned int>  GeostationaryNavFile::numberFiles( 0 );   // no objects yet
 
 
 // Constructors
@@ -5302,7 +6538,7 @@ unsigned short GeostationaryNavFile::readHeader()
    // read from line 2 until the end of header
    while( !endOfHeaderFound )
    {
-     if( !getline( inputStream, inputRec, '\n') )
+     if( !readLine( inputRec ) )
      {
        // Error reading a header line of the NAV File
        tempStream << "Error reading a header line of file:" << endl
@@ -5327,7 +6563,7 @@ unsigned short GeostationaryNavFile::readHeader()
            tempStream << "Warning! On line #" << getNumberLinesRead() << ":"
 	   << endl << inputRec << endl
 	   << " Not a Valid Header record, skipping to next line. " << endl;
-           appendToWarningMessages( tempStream.str() );
+           appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
            continue;   // go to read the next record
          }
      }
@@ -5437,7 +6673,7 @@ bool GeostationaryNavFile::validHeaderRecord(string inputRec)
       {
          tempStream << "Invalid NAV header record: " << endl
          << inputRec << endl;
-         appendToWarningMessages( tempStream.str() );
+         appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
 	 return false;
       }
 }
@@ -5489,7 +6725,7 @@ unsigned short GeostationaryNavFile::readEphemEpoch(
 
 // Read epoch "time-tag" record.
 
-   if ( !getline( inputStream, inputRec, '\n') )
+   if ( !readLine( inputRec ) )
    {
       return 0;   // EOF encountered
    }
@@ -5506,7 +6742,7 @@ unsigned short GeostationaryNavFile::readEphemEpoch(
       << endl << inputRec << endl
       << "  an invalid Satellite Number was found: "
       << temp << "." << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
    }
    temp = inputRec.substr( 3, 2 );
    if( getLong(temp, tempL) )
@@ -5520,7 +6756,7 @@ unsigned short GeostationaryNavFile::readEphemEpoch(
       tempStream << "On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  an invalid epoch year was found: " << temp << "." << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
    }
 
    temp = inputRec.substr( 6, 2 );
@@ -5531,7 +6767,7 @@ unsigned short GeostationaryNavFile::readEphemEpoch(
       tempStream << "On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  an invalid epoch month was found: " << temp << "." << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
    }
 
    temp = inputRec.substr( 9, 2 );
@@ -5542,7 +6778,7 @@ unsigned short GeostationaryNavFile::readEphemEpoch(
       tempStream << "On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  an invalid epoch day was found: " << temp << "." << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
    }
 
    temp = inputRec.substr( 12, 2 );
@@ -5553,7 +6789,7 @@ unsigned short GeostationaryNavFile::readEphemEpoch(
       tempStream << "On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  an invalid epoch hour was found: " << temp << "." << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
    }
 
    temp = inputRec.substr( 15, 2 );
@@ -5564,7 +6800,7 @@ unsigned short GeostationaryNavFile::readEphemEpoch(
       tempStream << "On line #" << getNumberLinesRead() << ":"
      << endl << inputRec << endl
       << "  and invalid epoch minute was found: " << temp << "." << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
    }
 
    temp = inputRec.substr( 17, 5 );
@@ -5575,7 +6811,7 @@ unsigned short GeostationaryNavFile::readEphemEpoch(
       tempStream << "On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  an invalid epoch second was found: " << temp << "." << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
      }
    }
    temp = inputRec.substr( 22, 19);
@@ -5593,12 +6829,12 @@ unsigned short GeostationaryNavFile::readEphemEpoch(
 
 // Read the first line after the Satellite number and time tag
 
-   if (  !getline( inputStream, inputRec, '\n') )
+   if (  !readLine( inputRec ) )
    {
       tempStream << "Warning! On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  error reading the first data line of a Nav Epoch." << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
       return 0;
    }
    incrementNumberLinesRead(1);
@@ -5624,12 +6860,12 @@ unsigned short GeostationaryNavFile::readEphemEpoch(
 
 // Read the 2nd line after the Satellite Almanac number and time tag
 
-   if (  !getline( inputStream, inputRec, '\n') )
+   if (  !readLine( inputRec ) )
    {
       tempStream << "Warning! On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  error reading the second data line of a Nav Epoch: " << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
       return 0;
    }
    incrementNumberLinesRead(1);
@@ -5655,12 +6891,12 @@ unsigned short GeostationaryNavFile::readEphemEpoch(
 
 // Read the 3rd line after the Satellite Almanac number and time tag
 
-   if ( !getline( inputStream, inputRec, '\n') )
+   if ( !readLine( inputRec ) )
    {
       tempStream << "Warning! On line #" << getNumberLinesRead() << ":"
       << endl << inputRec << endl
       << "  error reading the third data line of a Nav Epoch." << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
       return 0;
    }
    incrementNumberLinesRead(1);
@@ -5791,7 +7027,7 @@ unsigned int GeostationaryNavFile::getFilesCount()
 //========================== RinexMetFile Class ===============================
 
 // Initialize static data member
-unsigned int  RinexMetFile::numberMetFiles = 0;   // no objects yet
+atomic<unsigned int>  RinexMetFile::numberMetFiles( 0 );   // no objects yet
 
 // Constructors
 RinexMetFile::RinexMetFile() : RinexFile()
@@ -5864,7 +7100,7 @@ unsigned short RinexMetFile::readHeader()
    // read from line 2 until the end of header
    while( !endOfHeaderFound )
    {
-     if( !getline( inputStream, inputRec, '\n') )
+     if( !readLine( inputRec ) )
      {
        // Error reading a header line of the MET File
        tempStream << "Error, cannot read a header line from file:" << endl
@@ -5888,7 +7124,7 @@ unsigned short RinexMetFile::readHeader()
            tempStream << "Warning! On line: " << getNumberLinesRead() << ":"
 	   << endl << inputRec << endl
 	   << " Not a Valid Header record, skipping to next line. " << endl;
-           appendToWarningMessages( tempStream.str() );
+           appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
            continue;   // go to read the next record
          }
      }
@@ -6045,7 +7281,7 @@ bool RinexMetFile::validHeaderRecord(string inputRec)
       {
          tempStream << "Invalid MET header record: " << endl
          << inputRec << endl;
-         appendToWarningMessages( tempStream.str() );
+         appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
 	 return false;
       }
 }
@@ -6135,7 +7371,7 @@ unsigned short RinexMetFile::readEpoch( MetEpoch &epoch )
 
 // Read epoch "time-tag" record.
 
-   if ( !getline( inputStream, inputRec, '\n') )
+   if ( !readLine( inputRec ) )
    {
       return 0;    // EOF encountered
    }
@@ -6174,7 +7410,7 @@ unsigned short RinexMetFile::readEpoch( MetEpoch &epoch )
    {
     tempStream << "Problems reading Date and Time in MET record: "
     << warningString << inputRec << endl;
-    appendToWarningMessages( tempStream.str() );
+    appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
    }
 
    DateTime tempDateTime( ymdhms );
@@ -6275,7 +7511,7 @@ unsigned int RinexMetFile::getMetFilesCount()
 //========================== ClockDataFile Class ===============================
 
 // Initialize static data member
-unsigned short  ClockDataFile::numberClkFiles = 0;   // no objects yet
+atomic<unsigned short>  ClockDataFile::numberClkFiles( 0 );   // no objects yet
 
 // Constructors
 ClockDataFile::ClockDataFile() : RinexFile()
@@ -6389,7 +7625,7 @@ unsigned short ClockDataFile::readHeader()
    // read from line 2 until the end of header
    while( !endOfHeaderFound )
    {
-     if( !getline( inputStream, inputRec, '\n') )
+     if( !readLine( inputRec ) )
      {
        // Error reading a header line of the CLK File
        tempStream << "Error, cannot read a header line from file:" << endl
@@ -6413,7 +7649,7 @@ unsigned short ClockDataFile::readHeader()
            tempStream << "Warning! On line: " << getNumberLinesRead() << ":"
 	   << endl << inputRec << endl
 	   << " Not a Valid Header record, skipping to next line. " << endl;
-           appendToWarningMessages( tempStream.str() );
+           appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
            continue;   // go to read the next record
          }
      }
@@ -6629,7 +7865,7 @@ bool ClockDataFile::validHeaderRecord(string inputRec)
          {
            tempStream << "Problems reading Date & Time in Analysis Start Time:"
            << endl << warningString << endl << inputRec << endl;
-           appendToWarningMessages( tempStream.str() );
+           appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
          }
 
 
@@ -6663,7 +7899,7 @@ bool ClockDataFile::validHeaderRecord(string inputRec)
          {
            tempStream << "Problems reading Date & Time in Analysis Stop Time:"
            << endl << warningString << endl << inputRec << endl;
-           appendToWarningMessages( tempStream.str() );
+           appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
          }
 
          clkRefList = new AnalysisClkRefData[ numberAnalysisClkRef ];
@@ -6762,7 +7998,7 @@ bool ClockDataFile::validHeaderRecord(string inputRec)
       {
          tempStream << "Invalid CLK header record: " << endl
          << inputRec << endl;
-         appendToWarningMessages( tempStream.str() );
+         appendToWarningMessages( tempStream.str(), DIAG_HEADERRECORD );
 	 return false;
       }
 }
@@ -6875,7 +8111,7 @@ unsigned short ClockDataFile::readEpoch( ClkEpoch &epoch )
 
 // Read epoch "time-tag" record.
 
-   if ( !getline( inputStream, inputRec, '\n') )
+   if ( !readLine( inputRec ) )
    {
       return 0;    // EOF encountered
    }
@@ -6893,7 +8129,7 @@ unsigned short ClockDataFile::readEpoch( ClkEpoch &epoch )
    {
       tempStream << "Warning! Cannot read Clock Data Type on line:"
       << endl << inputRec << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
       epoch.setClockDataType(NOCLK);
    }
 
@@ -6931,7 +8167,7 @@ unsigned short ClockDataFile::readEpoch( ClkEpoch &epoch )
    {
     tempStream << "Problems reading Date and Time in CLK epoch: "
     << endl << warningString << inputRec << endl;
-    appendToWarningMessages( tempStream.str() );
+    appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
    }
 
    DateTime tempDateTime( ymdhms );
@@ -6944,7 +8180,7 @@ unsigned short ClockDataFile::readEpoch( ClkEpoch &epoch )
    {
       tempStream << "Warning ! Number Data Values at epoch > 6 : "
       << endl << inputRec << endl;
-      appendToWarningMessages( tempStream.str() );
+      appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
       epoch.setNumberDataValues(6);
    }
 
@@ -6964,11 +8200,11 @@ unsigned short ClockDataFile::readEpoch( ClkEpoch &epoch )
 
    if( epoch.getNumberDataValues() >= 3 ) // read a second line of clock data
    {
-     if ( !getline( inputStream, inputRec, '\n') )
+     if ( !readLine( inputRec ) )
      {
         tempStream << "Unexpected EOF reading 2nd line of clock data:"
         << endl << inputRec << endl;
-        appendToWarningMessages( tempStream.str() );
+        appendToWarningMessages( tempStream.str(), DIAG_DATARECORD );
         return 0;    // EOF encountered
      }
      incrementNumberLinesRead(1);
@@ -33,11 +33,31 @@
 #define LIST_
 #endif
 
+#if !defined( VECTOR_ )
+#include <vector>
+#define VECTOR_
+#endif
+
+#if !defined( FUNCTIONAL_ )
+#include <functional>
+#define FUNCTIONAL_
+#endif
+
+#if !defined( ATOMIC_ )
+#include <atomic>
+#define ATOMIC_
+#endif
+
 #if !defined( DATETIME_H_ )
 #include  "datetime.h"
 #define DATETIME_H_
 #endif
 
+#if !defined( RINEXIO_H_ )
+#include  "rinexio.h"
+#define RINEXIO_H_
+#endif
+
 
 namespace NGSrinex {
 
@@ -59,8 +79,12 @@ using namespace NGSdatetime;
    const unsigned short   NUMREQRCLKHEADERREC  =  4;
 
    const unsigned short   MAXPRNID = 36;
+   const unsigned short   MINSBASPRNID = 20;     // SBAS satellites are
+   const unsigned short   MAXSBASPRNID = 58;     // S20-S58 (PRN 120-158)
    const unsigned short   MAXGEOSTATIONARYID = 99;
-   const unsigned short   MAXSATPEREPOCH = 24;
+   const unsigned short   MAXSATPEREPOCH = 999;  // I3 # of satellites field
+   const unsigned short   SATLISTBUFSIZE = 12;   // satellites kept in ObsEpoch
+                                                 // itself, one PRN-list line
    const unsigned short   RINEXRECSIZE = 83;   // 80 cols plus \r \n etc.
    const unsigned short   MAXOBSTYPES = 11;
    const unsigned short   MAXMETTYPES =  6;
@@ -75,6 +99,22 @@ using namespace NGSdatetime;
    enum CLKTYPE { NOCLK = 0, AR = 1, AS = 2,
                   CR = 3, DR = 4, MS = 5 };
 
+   // Kinds of warnings and errors reported while reading a RINEX file.
+   enum DIAGCODE { DIAG_OTHER = 0,
+                   DIAG_RECORDLENGTH = 1,  // record longer than 80 columns
+                   DIAG_NUMBERFORMAT = 2,  // illegal characters in a number
+                   DIAG_HEADERRECORD = 3,  // bad or unrecognized header record
+                   DIAG_EPOCHRECORD  = 4,  // bad EPOCH/SAT or time tag record
+                   DIAG_OBSERVATION  = 5,  // bad SV name, obs, LLI or S/N
+                   DIAG_EVENTFLAG    = 6,  // event flag records
+                   DIAG_DATARECORD   = 7,  // bad nav/met/clock data record
+                   DIAG_FILEERROR    = 8,  // unable to open or read the file
+                   NUMDIAGCODES      = 9 };
+
+   const unsigned long    DEFMAXDIAGENTRIES = 1000;     // retained per file
+   const unsigned long    DEFMAXDIAGBYTES   = 1000000;  // retained per file
+   const unsigned long    MAXDIAGMSGLENGTH  = 2000;     // per message
+
 
 //=================== Classes with public data only ==========================
   class RecStruct {
@@ -228,6 +268,63 @@ using namespace NGSdatetime;
       double   staZ;            // geocentric Z-coordinate for analysis clk.
    };
 
+  class DiagnosticEntry {
+     public:
+      DiagnosticEntry(){
+        lineNumber = 0;
+        code = DIAG_OTHER;
+        isError = false;
+        message = "";
+      };
+      unsigned long    lineNumber;    // line being read when it was reported.
+      DIAGCODE         code;          // kind of warning or error.
+      bool             isError;       // True = error, False = warning.
+      string           message;
+   };
+
+   typedef std::function< void ( const DiagnosticEntry & ) > DiagnosticCallback;
+
+//======================== RinexDiagnostics Class ========================
+
+   // Bounded sink for the warnings and errors of one RINEX file.  Every
+   // report is counted by code and passed to the optional callback, but only
+   // the first maxEntries (and maxBytes of message text) are kept, so a
+   // corrupt file cannot grow the messages without limit.
+
+   class RinexDiagnostics {
+
+     public:
+      RinexDiagnostics();
+      ~RinexDiagnostics();
+
+      // Initializers
+      void setMaxEntries(unsigned long input);
+      void setMaxBytes(unsigned long input);
+      void setCallback(DiagnosticCallback input);
+      void report(bool isError, DIAGCODE code, unsigned long lineNumber,
+                  const string &message);
+      void clear();
+
+      // Selectors
+      unsigned long   getMaxEntries();
+      unsigned long   getMaxBytes();
+      unsigned long   getCount(DIAGCODE code);
+      unsigned long   getNumberReported();
+      unsigned long   getNumberDropped();
+      const vector<DiagnosticEntry> &getEntries();
+      string          getMessages(bool errors);
+
+     private:
+      vector<DiagnosticEntry>  entries;
+      unsigned long            maxEntries;
+      unsigned long            maxBytes;
+      unsigned long            retainedBytes;
+      unsigned long            numberReported;
+      unsigned long            numberDropped[2];   // [0]=warnings, [1]=errors
+      unsigned long            counts[NUMDIAGCODES];
+      DiagnosticCallback       callback;
+   };
+
 //======================== ObsEpoch Class =============================
 
    class ObsEpoch {
@@ -251,6 +348,7 @@ using namespace NGSdatetime;
       unsigned short  getEpochFlag();
       unsigned short  getNumSat();
       SatObsAtEpoch   getSatListElement(int i);
+      const SatObsAtEpoch &getSatListElementRef(int i) const;   // no copy
       double          getRecClockOffset();
       string          getEpochHeaderRecords();
 
@@ -260,9 +358,78 @@ using namespace NGSdatetime;
       unsigned short       numSat;      // if more than 12 satellites,
                                         // then continue on the next line.
 
-      SatObsAtEpoch        satList[MAXSATPEREPOCH];
+      // The first SATLISTBUFSIZE satellites live in satList; larger epochs
+      // spill into satListOverflow, which keeps its capacity between epochs
+      // so that reusing one ObsEpoch does not touch the heap again.
+      SatObsAtEpoch           satList[SATLISTBUFSIZE];
+      vector<SatObsAtEpoch>   satListOverflow;
       double               recClockOffset; // receiver clock offset in seconds
       string               epochHeaderRecords;
+
+      SatObsAtEpoch& satListElement(int i);
+      const SatObsAtEpoch& satListElement(int i) const;
+   };
+
+//======================== ObsBatch Class =============================
+
+   // Structure-of-arrays view of one OBS epoch.  Each observation type in the
+   // header has its own contiguous value, LLI and signal strength column, all
+   // indexed by the satellite's position in the epoch's PRN list, so a user
+   // can take e.g. the C1 column for every satellite without copying
+   // SatObsAtEpoch records.  Filled by RinexObsFile::readEpoch(ObsBatch &).
+   // The columns grow to the largest epoch seen and are then reused.
+
+   class ObsBatch {
+
+     public:
+      ObsBatch();   // default Constructor
+      ~ObsBatch();  // Destructor
+
+      // Initializers
+      void reset(unsigned short numTypes, const enum OBSTYPE types[]);
+      void setEpochHeader(ObsEpoch &input);   // time, flag, clock offset
+      void setEpochHeader(DateTime time, unsigned short flag,
+                          double clockOffset);
+      void setNumSat(unsigned short input);   // call before setSatellite()
+      bool setSatellite(int i, char satCode, unsigned short satNum);
+      bool setObservation(int j, int i, double value,
+                          unsigned short LLI, unsigned short sigStrength);
+      void clearObservation(int j, int i);   // blank, for any type
+      void swap(ObsBatch &other);   // exchanges the columns, no copying
+
+      // Selectors
+      DateTime               getEpochTime();
+      unsigned short         getEpochFlag();
+      unsigned short         getNumSat();   // satellites in the columns
+      double                 getRecClockOffset();
+      unsigned short         getNumObsTypes();
+      enum OBSTYPE           getObsType(int j);
+      int                    findObsType(enum OBSTYPE type); // -1 = none
+      const char*            getSatCodes();
+      const unsigned short*  getSatNums();
+      const double*          getValues(int j);       // 0.0 = blank
+      const unsigned char*   getPresent(int j);      // 0 = blank
+      const unsigned short*  getLLI(int j);
+      const unsigned short*  getSigStrength(int j);
+
+     private:
+      DateTime             epochTime;
+      unsigned short       epochFlag;
+      unsigned short       numSat;
+      double               recClockOffset;
+      unsigned short       numObsTypes;
+      enum OBSTYPE         obsTypes[ MAXOBSTYPES ];
+      bool                 typeValid[ MAXOBSTYPES ];
+
+      // column j of values, present, LLIs and sigStrengths starts at
+      // element j * capacity
+      unsigned short          capacity;
+      vector<char>            satCodes;
+      vector<unsigned short>  satNums;
+      vector<double>          values;
+      vector<unsigned char>   present;
+      vector<unsigned short>  LLIs;
+      vector<unsigned short>  sigStrengths;
    };
 
 //======================== MetEpoch Class =============================
@@ -728,9 +895,15 @@ using namespace NGSdatetime;
          bool  incrementNumberWarnings(unsigned long n);
          bool  incrementNumberLinesRead(unsigned long n);
          bool  setCurrentEpoch(DateTime input);
-         void  appendToErrorMessages(string errMessage);
-         void  appendToWarningMessages(string warnMessage);
+         void  appendToErrorMessages(string errMessage,
+                                     DIAGCODE code = DIAG_FILEERROR);
+         void  appendToWarningMessages(string warnMessage,
+                                       DIAGCODE code = DIAG_OTHER);
          void  readFileTypeAndProgramName();
+         void  setFastParse(bool input);
+         void  setFastFormat(bool input);
+         void  setUseMemoryMap(bool input);  // call before opening the file
+         void  setInputSpan(string name, const char *data, size_t size);
 
 
          // Selectors
@@ -749,6 +922,11 @@ using namespace NGSdatetime;
          DateTime           getCurrentEpoch();
          string             getErrorMessages();
          string             getWarningMessages();
+         RinexDiagnostics&  getDiagnostics();
+         bool               getFastParse();
+         bool               getFastFormat();
+         bool               isMemoryMapped();
+         bool               isDecodedInput();   // gzip or Compact RINEX
 
        protected:
          string              pathFilename;
@@ -764,11 +942,21 @@ using namespace NGSdatetime;
          unsigned long       numberWarnings;
          unsigned long       numberLinesRead;
          DateTime            currentEpoch;
+         bool                fastParse;   // decode fixed-width fields in place
+         bool                fastFormat;  // format records with RecordFormatter
+         bool                useMemoryMap;
+         LineSource          *lineSource;  // mmap, or inputStream as fallback
+         bool                memoryMapped;
+         bool                decodedInput;  // lineSource restores the text
 
          ostringstream       tempStream;
-         ostringstream       errorMessages;
-         ostringstream       warningMessages;
+         RinexDiagnostics    diagnostics;   // warning and error messages
 
+         void openInputSource();
+         void closeInputSource();
+         void checkInputSource();
+         bool readLine(string &record);
+         bool readLineSpan(const char *&line, size_t &length);
          bool validFirstLine(string &recordReadIn);
          bool blankString(string inputStr);
          bool alphasInString(string inputStr);
@@ -776,10 +964,33 @@ using namespace NGSdatetime;
          void truncateHeaderRec(string &inputRec);
          bool getDouble(string input, double &output);
          bool getLong(string input, long &output);
+         bool getDoubleField(const string &record, size_t pos, size_t len,
+                             double &output);
+         bool getDoubleField(const char *record, size_t recordLength,
+                             size_t pos, size_t len, double &output);
+         bool getLongField(const string &record, size_t pos, size_t len,
+                           long &output);
+         bool getLongField(const char *record, size_t recordLength,
+                           size_t pos, size_t len, long &output);
          bool validYMDHMS(long year, long month, long day, long hour,
                           long minute, double second, string &warningString);
    };
 
+//======================== ObsIndexEntry ====================================
+
+   // One epoch in the epoch index of an observation file.  Times are GPS
+   // seconds since the GPS epoch (week * 604800 + seconds of week); event
+   // records without a time tag take the time of the epoch before them.
+
+   struct ObsIndexEntry
+   {
+      double              gpsTime;
+      unsigned long long  offset;      // byte offset of the time-tag record
+      unsigned long       lineNumber;  // lines before the time-tag record
+      unsigned short      numSat;      // or number of special records
+      unsigned short      epochFlag;
+   };
+
 //======================== RinexObsFile Class ===============================
 
    class RinexObsFile : public RinexFile
@@ -833,6 +1044,7 @@ using namespace NGSdatetime;
     void incrementNumberObsEpochs( unsigned int n );
     unsigned short readHeader();
     unsigned short readEpoch(ObsEpoch &epoch);
+    unsigned short readEpoch(ObsBatch &batch);
 
     // Selectors
     string getMarkerName();
@@ -877,6 +1089,30 @@ using namespace NGSdatetime;
     unsigned int         getNumberObsEpochs();
     static unsigned int  getObsFilesCount();
 
+    // Epoch index, kept in a sidecar file (by default the observation file
+    // name plus ".idx") for time-window access without reading the epochs
+    // before the window.  The sidecar records the observation file's size
+    // and modification time and is rebuilt when either changes.  Call these
+    // after readHeader().
+    bool           openIndex(string indexFilename = "");
+    bool           seekToTime(DateTime time);   // to the first epoch at or after time
+    bool           readRange(DateTime startTime, DateTime endTime);
+    void           clearRange();                // read on to the end of the file
+    unsigned long  getNumIndexedEpochs();
+    ObsIndexEntry  getIndexEntry(unsigned long i);
+
+    // Projection: readEpoch() decodes only the observations of the given
+    // satellite systems ('G', 'R', 'S'; a blank system code counts as 'G')
+    // and observation types.  The other fields are left blank without being
+    // converted or checked, while every record is still read and every
+    // satellite ID still checked.  clearProjection() decodes everything.
+    void           setProjection(const string &satCodes,
+                                 const vector<enum OBSTYPE> &types);
+    void           clearProjection();
+    bool           getProjected();
+    string         getProjectedSystems();
+    vector<enum OBSTYPE>  getProjectedTypes();
+
 
     private:
       RecStruct   headerRecs[MAXOBSHEADERRECTYPES];
@@ -947,11 +1183,36 @@ using namespace NGSdatetime;
       unsigned short    nextSat;            // index for satObsTypeList
 
       unsigned int         numberObsEpochs;
-      static unsigned int  numberObsFiles;  // # Obs Files instantiated
+      static atomic<unsigned int>  numberObsFiles;  // # Obs Files instantiated
+
+      ObsEpoch          batchEpoch;   // epoch header for readEpoch(ObsBatch&)
+      string                  prnListCodes;  // PRN list of the current epoch,
+      vector<unsigned short>  prnListNums;   //   reused from epoch to epoch
+      string                  epochRecord;   // EPOCH/SAT record and working
+      string                  dataRecord;    //   copies of the data records,
+      string                  spareRecord;   //   reused from epoch to epoch
+      RecordFormatter         outputRecord;  // epoch being written
+
+      vector<ObsIndexEntry>   epochIndex;    // empty until openIndex()
+      unsigned long long      indexedSize;   // bytes of the indexed file
+      unsigned long           indexedLines;  // lines read when the index ended
+      unsigned long long      rangeEnd;      // readEpoch() stops at this offset
+
+      bool                    projected;          // decode only these:
+      string                  projectedSystems;
+      vector<enum OBSTYPE>    projectedTypes;
 
       void initializeData();
+      void writeEpochStream(ofstream &outputOBS, ObsEpoch &outputEpoch);
+      bool buildIndex();
+      bool loadIndex(string indexFilename, unsigned long long fileSize,
+                     long long fileTime);
+      bool saveIndex(string indexFilename, unsigned long long fileSize,
+                     long long fileTime);
+      bool pastRangeEnd();
+      unsigned short readEpochRecords(ObsEpoch &epoch, ObsBatch *batch);
       bool validHeaderRecord(string inputRec);
-      bool validEventFlagRecord(string inputRec);
+      bool validEventFlagRecord(const string &record);
       bool validObservationsRecord(string inputRec);
    };
 
@@ -1023,7 +1284,7 @@ using namespace NGSdatetime;
       long        utcRefWeek;              // W : UTC ref. week number
       unsigned short       leapSec;        // Delta time due to leap seconds
       unsigned int         numberPRNBlocks;
-      static unsigned int  numberNavFiles; // # Nav Files instantiated
+      static atomic<unsigned int>  numberNavFiles; // # Nav Files instantiated
 
       void initializeData();
       bool validHeaderRecord(string inputRec);
@@ -1073,7 +1334,7 @@ using namespace NGSdatetime;
                                            // UTC(SU)  (-TauC).
       unsigned short       leapSec;        // Leap seconds since 6-Jan-1980
       unsigned int         numberEpochs;   // # epochs in the Nav File
-      static unsigned int  numberFiles;    // # GLONASS Nav Files instantiated
+      static atomic<unsigned int>  numberFiles;    // # GLONASS Nav Files instantiated
 
       void initializeData();
       bool validHeaderRecord(string inputRec);
@@ -1123,7 +1384,7 @@ using namespace NGSdatetime;
       double           corrToUTC;          // Correct GEO system time to UTC
       unsigned short       leapSec;        // Leap seconds since 6-Jan-1980
       unsigned int         numberEpochs;   // # epochs in the Nav File
-      static unsigned int  numberFiles;    // # GLONASS Nav Files instantiated
+      static atomic<unsigned int>  numberFiles;    // # GLONASS Nav Files instantiated
 
       void initializeData();
       bool validHeaderRecord(string inputRec);
@@ -1186,7 +1447,7 @@ using namespace NGSdatetime;
       SensorPosition   sensorXYZh[ MAXMETTYPES ];
 
       unsigned int         numberMetEpochs;
-      static unsigned int  numberMetFiles;  // # Met Files instantiated
+      static atomic<unsigned int>  numberMetFiles;  // # Met Files instantiated
 
       void initializeData();
       bool validHeaderRecord(string inputRec);
@@ -1286,7 +1547,7 @@ using namespace NGSdatetime;
       string           *prnList;           // allocated in readHeader()
 
       unsigned short          numberClkEpochs;
-      static unsigned short   numberClkFiles;
+      static atomic<unsigned short>  numberClkFiles;
       void initializeData();
       bool validHeaderRecord(string inputRec);
     };
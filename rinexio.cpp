@@ -0,0 +1,762 @@
+// rinexio.cpp
+// Line sources for the RINEX file readers: memory mapped files with an
+// istream fallback, gzip and Compact RINEX decoding.  The record formatter
+// for the writers.
+
+#include "rinexio.h"
+
+#if !defined(CSTRING_)
+#include <cstring>
+#define CSTRING_
+#endif
+
+#if !defined(CHARCONV_)
+#include <charconv>
+#define CHARCONV_
+#endif
+
+#if !defined(FSTREAM_)
+#include <fstream>
+#define FSTREAM_
+#endif
+
+#if !defined(ALGORITHM_)
+#include <algorithm>
+#define ALGORITHM_
+#endif
+
+#if defined( RINEX_HAVE_ZLIB )
+#include <zlib.h>
+#endif
+
+#if defined( RINEX_HAVE_MMAP )
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+namespace NGSrinex {
+
+using namespace std;
+
+//========================== LineSource Class =================================
+
+LineSource::~LineSource()
+{ }
+
+bool LineSource::linesPersist() const
+{
+   return false;
+}
+
+string LineSource::getError() const
+{
+   return string();
+}
+
+//========================== StreamLineSource Class ===========================
+
+StreamLineSource::StreamLineSource( istream &input ) : inputStream( input )
+{ }
+
+StreamLineSource::~StreamLineSource()
+{ }
+
+bool StreamLineSource::nextLine( const char *&line, size_t &length )
+{
+   if( !getline( inputStream, lineBuffer, '\n' ) )
+     return false;
+
+   line = lineBuffer.data();
+   length = lineBuffer.length();
+   return true;
+}
+
+unsigned long long StreamLineSource::tell()
+{
+   return static_cast< unsigned long long >( inputStream.tellg() );
+}
+
+bool StreamLineSource::seek( unsigned long long offset )
+{
+   inputStream.clear();    // a previous read may have hit end of file
+   inputStream.seekg( static_cast< streamoff >( offset ) );
+   return !inputStream.fail();
+}
+
+//========================== SpanLineSource Class =============================
+
+SpanLineSource::SpanLineSource( const char *spanData, size_t spanSize )
+{
+   data = spanData;
+   size = spanSize;
+   position = 0;
+}
+
+bool SpanLineSource::nextLine( const char *&line, size_t &length )
+{
+   const char *newline;
+
+   if( position >= size )
+     return false;
+
+   line = data + position;
+   newline = static_cast< const char * >(
+               memchr( line, '\n', size - position ) );
+   if( newline != 0 )
+   {
+     length = static_cast< size_t >( newline - line );
+     position += length + 1;
+   }
+   else
+   {
+     length = size - position;   // last record has no '\n'
+     position = size;
+   }
+   return true;
+}
+
+unsigned long long SpanLineSource::tell()
+{
+   return position;
+}
+
+bool SpanLineSource::seek( unsigned long long offset )
+{
+   if( offset > size )
+     return false;
+   position = static_cast< size_t >( offset );
+   return true;
+}
+
+bool SpanLineSource::linesPersist() const
+{
+   return true;
+}
+
+//========================== MappedLineSource Class ===========================
+
+MappedLineSource::MappedLineSource()
+{
+}
+
+MappedLineSource::~MappedLineSource()
+{
+#if defined( RINEX_HAVE_MMAP )
+   if( data != 0 )
+     munmap( const_cast< char * >( data ), size );
+#endif
+}
+
+bool MappedLineSource::open( const string &pathFilename )
+{
+#if defined( RINEX_HAVE_MMAP )
+   struct stat  fileStat;
+   void        *mapped;
+   int          fd;
+
+   fd = ::open( pathFilename.c_str(), O_RDONLY );
+   if( fd < 0 )
+     return false;
+
+   // an empty file cannot be mapped; let the stream reader handle it
+   if( fstat( fd, &fileStat ) != 0 || !S_ISREG( fileStat.st_mode ) ||
+       fileStat.st_size == 0 )
+   {
+     ::close( fd );
+     return false;
+   }
+
+   mapped = mmap( 0, static_cast< size_t >( fileStat.st_size ), PROT_READ,
+                  MAP_PRIVATE, fd, 0 );
+   ::close( fd );          // the mapping keeps its own reference
+   if( mapped == MAP_FAILED )
+     return false;
+
+   madvise( mapped, static_cast< size_t >( fileStat.st_size ), MADV_SEQUENTIAL );
+
+   data = static_cast< const char * >( mapped );
+   size = static_cast< size_t >( fileStat.st_size );
+   position = 0;
+   return true;
+#else
+   return false;
+#endif
+}
+
+//========================== GzipLineSource Class =============================
+
+namespace
+{
+   const size_t GZIPBUFFERBYTES = 256 * 1024;
+}
+
+GzipLineSource::GzipLineSource()
+{
+   file = 0;
+   begin = 0;
+   end = 0;
+   bufferOffset = 0;
+   atEnd = false;
+}
+
+GzipLineSource::~GzipLineSource()
+{
+#if defined( RINEX_HAVE_ZLIB )
+   if( file != 0 )
+     gzclose( file );
+#endif
+}
+
+bool GzipLineSource::isGzipFile( const string &pathFilename )
+{
+   ifstream  input( pathFilename.c_str(), ios::in | ios::binary );
+   unsigned char  magic[2];
+
+   return input.read( reinterpret_cast< char * >( magic ), 2 ) &&
+          magic[0] == 0x1f && magic[1] == 0x8b;
+}
+
+bool GzipLineSource::open( const string &pathFilename )
+{
+#if defined( RINEX_HAVE_ZLIB )
+   file = gzopen( pathFilename.c_str(), "rb" );
+   if( file == 0 )
+     return false;
+   gzbuffer( file, GZIPBUFFERBYTES );
+   buffer.resize( GZIPBUFFERBYTES );
+   return true;
+#else
+   (void)pathFilename;
+   return false;
+#endif
+}
+
+bool GzipLineSource::nextLine( const char *&line, size_t &length )
+{
+#if defined( RINEX_HAVE_ZLIB )
+   const char  *newline;
+   int          count;
+
+   for( ;; )
+   {
+     newline = static_cast< const char * >(
+                 memchr( buffer.data() + begin, '\n', end - begin ) );
+     if( newline != 0 )
+     {
+       line = buffer.data() + begin;
+       length = static_cast< size_t >( newline - line );
+       begin += length + 1;
+       return true;
+     }
+     if( atEnd )
+     {
+       if( begin == end )
+         return false;
+       line = buffer.data() + begin;   // last record has no '\n'
+       length = end - begin;
+       begin = end;
+       return true;
+     }
+
+     // keep the partial record and inflate more behind it
+     if( begin > 0 )
+     {
+       memmove( buffer.data(), buffer.data() + begin, end - begin );
+       bufferOffset += begin;
+       end -= begin;
+       begin = 0;
+     }
+     if( end == buffer.size() )
+       buffer.resize( 2 * buffer.size() );
+     count = gzread( file, buffer.data() + end,
+                     static_cast< unsigned >( buffer.size() - end ) );
+     if( count < 0 )
+     {
+       int  errnum;
+       error = gzerror( file, &errnum );
+       atEnd = true;
+       return false;
+     }
+     if( count == 0 )
+       atEnd = true;
+     end += static_cast< size_t >( count );
+   }
+#else
+   (void)line;
+   (void)length;
+   return false;
+#endif
+}
+
+unsigned long long GzipLineSource::tell()
+{
+   return bufferOffset + begin;
+}
+
+bool GzipLineSource::seek( unsigned long long offset )
+{
+#if defined( RINEX_HAVE_ZLIB )
+   if( offset >= bufferOffset && offset <= bufferOffset + end )
+   {
+     begin = static_cast< size_t >( offset - bufferOffset );   // still buffered
+     return true;
+   }
+   if( gzseek( file, static_cast< z_off_t >( offset ), SEEK_SET ) < 0 )
+     return false;
+   begin = 0;
+   end = 0;
+   bufferOffset = offset;
+   atEnd = false;
+   error.clear();
+   return true;
+#else
+   (void)offset;
+   return false;
+#endif
+}
+
+string GzipLineSource::getError() const
+{
+   return error;
+}
+
+//========================== HatanakaLineSource Class =========================
+
+namespace
+{
+   const char CRINEXLABEL[] = "CRINEX VERS   / TYPE";
+   const char ENDOFHEADER[] = "END OF HEADER";
+   const char TYPESLABEL[] = "# / TYPES OF OBSERV";
+
+   bool hasLabel( const char *line, size_t length, const char *label )
+   {
+      size_t  labelLength = strlen( label );
+      return length >= 60 + labelLength &&
+             memcmp( line + 60, label, labelLength ) == 0;
+   }
+
+   // Text difference: a blank keeps the character, '&' blanks it, anything
+   // else replaces it; a longer difference extends the text.
+   void repairText( string &text, const char *diff, size_t length )
+   {
+      for( size_t k = 0; k < length; k++ )
+      {
+        char  c = ( diff[k] == '&' ) ? ' ' : diff[k];
+        if( k >= text.length() )
+          text.push_back( c );
+        else if( diff[k] != ' ' )
+          text[k] = c;
+      }
+   }
+
+   // value / 10^decimals in fixed notation, right-justified in width
+   void appendScaled( string &record, long long value, int decimals, size_t width )
+   {
+      char  digits[32];
+      char *p = digits + sizeof( digits );
+      unsigned long long  magnitude = value < 0 ? 0ULL - static_cast< unsigned long long >( value )
+                                                : static_cast< unsigned long long >( value );
+      for( int k = 0; k < decimals; k++ )
+      {
+        *--p = static_cast< char >( '0' + magnitude % 10 );
+        magnitude /= 10;
+      }
+      *--p = '.';
+      do
+      {
+        *--p = static_cast< char >( '0' + magnitude % 10 );
+        magnitude /= 10;
+      } while( magnitude > 0 );
+      if( value < 0 )
+        *--p = '-';
+
+      size_t  length = static_cast< size_t >( digits + sizeof( digits ) - p );
+      if( length < width )
+        record.append( width - length, ' ' );
+      record.append( p, length );
+   }
+
+   unsigned systemIndex( char satCode )
+   {
+      static const char SYSTEMS[] = "GRSEJCI";
+      const char *found = satCode == ' ' ? SYSTEMS : strchr( SYSTEMS, satCode );
+      return ( found != 0 && *found != '\0' ) ? static_cast< unsigned >( found - SYSTEMS ) : 7;
+   }
+
+   void trimRecord( string &record )
+   {
+      size_t  last = record.find_last_not_of( ' ' );
+      record.resize( last == string::npos ? 0 : last + 1 );
+   }
+
+   // a right-justified count in the columns of text
+   unsigned fieldCount( const string &text, size_t pos, size_t length )
+   {
+      unsigned  count = 0;
+      for( size_t k = pos; k < pos + length && k < text.length(); k++ )
+        if( text[k] >= '0' && text[k] <= '9' )
+          count = 10 * count + static_cast< unsigned >( text[k] - '0' );
+      return count;
+   }
+}
+
+HatanakaLineSource::HatanakaLineSource( LineSource *compact )
+{
+   input = compact;
+   satellites.resize( NUMSYSTEMS * MAXSATNUM );
+   restart();
+}
+
+HatanakaLineSource::~HatanakaLineSource()
+{
+   delete input;
+}
+
+bool HatanakaLineSource::isCompactRinex( const char *line, size_t length )
+{
+   return hasLabel( line, length, CRINEXLABEL );
+}
+
+void HatanakaLineSource::restart()
+{
+   inHeader = true;
+   numTypes = 0;
+   epochRecord.clear();
+   clock.order = -1;
+   for( size_t k = 0; k < satellites.size(); k++ )
+     satellites[k].epoch = 0;
+   numEpochs = 1;   // so that no satellite was in the previous epoch
+   numOutput = 0;
+   nextOutput = 0;
+   offset = 0;
+   error.clear();
+}
+
+bool HatanakaLineSource::nextLine( const char *&line, size_t &length )
+{
+   while( nextOutput == numOutput )
+   {
+     numOutput = 0;
+     nextOutput = 0;
+     if( !error.empty() || !decodeNext() )
+       return false;
+   }
+
+   const string &restored = output[ nextOutput++ ];
+   line = restored.data();
+   length = restored.length();
+   offset += length + 1;
+   return true;
+}
+
+unsigned long long HatanakaLineSource::tell()
+{
+   return offset;
+}
+
+bool HatanakaLineSource::seek( unsigned long long target )
+{
+   const char  *line;
+   size_t       length;
+
+   if( target < offset )
+   {
+     if( !input->seek( 0 ) )
+       return false;
+     restart();
+   }
+   while( offset < target )
+   {
+     if( !nextLine( line, length ) )
+       return false;
+   }
+   return offset == target;
+}
+
+string HatanakaLineSource::getError() const
+{
+   return error.empty() ? input->getError() : error;
+}
+
+string &HatanakaLineSource::newRecord()
+{
+   if( numOutput == output.size() )
+     output.push_back( string() );
+   string &restored = output[ numOutput++ ];
+   restored.clear();
+   return restored;
+}
+
+// Restore the records of the next header record or epoch.  Returns false at
+// the end of the input or on an error.
+bool HatanakaLineSource::decodeNext()
+{
+   const char  *line;
+   size_t       length;
+
+   if( !input->nextLine( line, length ) )
+     return false;
+   if( length > 0 && line[ length - 1 ] == '\r' )
+     length--;
+
+   if( !inHeader )
+     return decodeEpoch( line, length );
+
+   if( hasLabel( line, length, CRINEXLABEL ) )
+   {
+     if( length < 3 || line[0] != '1' || line[1] != '.' )
+     {
+       error = "Compact RINEX version " + string( line, min( length, (size_t)20 ) ) +
+               " is not supported, only 1.0 (RINEX 2)";
+       return false;
+     }
+     return true;
+   }
+   if( length >= 66 && memcmp( line + 60, "CRINEX", 6 ) == 0 )
+     return true;   // CRINEX PROG / DATE
+
+   if( numTypes == 0 && hasLabel( line, length, TYPESLABEL ) )
+   {
+     numTypes = fieldCount( string( line, min( length, (size_t)6 ) ), 0, 6 );
+     if( numTypes > MAXTYPES )
+     {
+       error = "too many observation types in Compact RINEX file";
+       return false;
+     }
+   }
+   if( hasLabel( line, length, ENDOFHEADER ) )
+     inHeader = false;
+   newRecord().assign( line, length );
+   return true;
+}
+
+bool HatanakaLineSource::decodeEpoch( const char *line, size_t length )
+{
+   const char  *data;
+   size_t       dataLength;
+   int          flag;
+   unsigned     numSat, i, j, k;
+   bool         haveClock;
+
+   if( length == 0 )
+     return true;
+
+   // the epoch record, in full after '&' and as a difference otherwise
+   if( line[0] == '&' )
+   {
+     record.assign( line, length );
+     record[0] = ' ';
+   }
+   else
+   {
+     record = epochRecord;
+     repairText( record, line, length );
+   }
+   if( record.length() < 32 )
+     record.append( 32 - record.length(), ' ' );
+   flag = record[28] - '0';
+   numSat = fieldCount( record, 29, 3 );
+
+   // event records follow as they are
+   if( flag >= 2 && flag <= 5 )
+   {
+     string &event = newRecord();
+     event = record;
+     trimRecord( event );
+     for( i = 0; i < numSat; i++ )
+     {
+       if( !input->nextLine( data, dataLength ) )
+       {
+         error = "Compact RINEX file ends within event records";
+         return false;
+       }
+       newRecord().assign( data, dataLength );
+     }
+     return true;
+   }
+   epochRecord = record;
+   numEpochs++;
+   if( record.length() < 32 + 3 * numSat )
+     record.append( 32 + 3 * numSat - record.length(), ' ' );
+
+   // the receiver clock offset, in nanoseconds, or a blank record
+   if( !input->nextLine( data, dataLength ) )
+   {
+     error = "Compact RINEX file ends before a clock offset record";
+     return false;
+   }
+   if( dataLength > 0 && data[ dataLength - 1 ] == '\r' )
+     dataLength--;
+   haveClock = dataLength > 0;
+   if( !haveClock )
+     clock.order = -1;
+   else if( !decodeValue( clock, data, dataLength ) )
+     return false;
+
+   // RINEX 2 epoch records: 12 satellites each, the clock on the first.
+   // (A record is finished before the next one is added, since adding one
+   // may move the others.)
+   string &epoch = newRecord();
+   epoch.assign( record, 0, 32 + 3 * min( numSat, 12u ) );
+   if( haveClock )
+   {
+     epoch.append( 68 - epoch.length(), ' ' );
+     appendScaled( epoch, clock.diff[0], 9, 12 );
+   }
+   trimRecord( epoch );
+   for( i = 12; i < numSat; i += 12 )
+   {
+     string &more = newRecord();
+     more.assign( 32, ' ' );
+     more.append( record, 32 + 3 * i, 3 * min( numSat - i, 12u ) );
+     trimRecord( more );
+   }
+
+   // one record of differences per satellite, then its flags' difference
+   for( i = 0; i < numSat; i++ )
+   {
+     if( !input->nextLine( data, dataLength ) )
+     {
+       error = "Compact RINEX file ends within an epoch";
+       return false;
+     }
+     if( dataLength > 0 && data[ dataLength - 1 ] == '\r' )
+       dataLength--;
+
+     char  satCode = record[ 32 + 3 * i ];
+     unsigned satNum = fieldCount( record, 33 + 3 * i, 2 );
+     Satellite &sat = satellites[ systemIndex( satCode ) * MAXSATNUM + satNum % MAXSATNUM ];
+     if( sat.epoch != numEpochs - 1 )
+     {
+       for( j = 0; j < numTypes; j++ )
+         sat.obs[j].order = -1;
+       sat.flags.clear();
+     }
+     sat.epoch = numEpochs;
+
+     const char *field = data;
+     const char *dataEnd = data + dataLength;
+     for( j = 0; j < numTypes; j++ )
+     {
+       const char *fieldEnd = field < dataEnd ? static_cast< const char * >(
+                                memchr( field, ' ', dataEnd - field ) ) : 0;
+       if( fieldEnd == 0 )
+         fieldEnd = dataEnd;
+       if( fieldEnd == field )
+         sat.obs[j].order = -1;   // blank
+       else if( !decodeValue( sat.obs[j], field, fieldEnd - field ) )
+         return false;
+       field = fieldEnd < dataEnd ? fieldEnd + 1 : dataEnd;
+     }
+     repairText( sat.flags, field, dataEnd - field );
+
+     // five observations of 16 columns per record
+     for( j = 0; j < numTypes; j += 5 )
+     {
+       string &observations = newRecord();
+       for( k = j; k < j + 5 && k < numTypes; k++ )
+       {
+         if( sat.obs[k].order >= 0 )
+           appendScaled( observations, sat.obs[k].diff[0], 3, 14 );
+         else
+           observations.append( 14, ' ' );
+         observations.push_back( 2 * k < sat.flags.length() ? sat.flags[2 * k] : ' ' );
+         observations.push_back( 2 * k + 1 < sat.flags.length() ? sat.flags[2 * k + 1] : ' ' );
+       }
+       trimRecord( observations );
+     }
+   }
+   return true;
+}
+
+// The next value of an arc: "n&value" starts an arc of differences of order
+// n, a plain integer is its next difference.
+bool HatanakaLineSource::decodeValue( Arc &arc, const char *field, size_t length )
+{
+   long long    value;
+   const char  *number = field;
+
+   if( length >= 2 && field[1] == '&' )
+   {
+     if( field[0] < '1' || field[0] > '0' + MAXORDER )
+     {
+       error = "bad difference order in Compact RINEX field " + string( field, length );
+       return false;
+     }
+     arc.maxOrder = field[0] - '0';
+     arc.order = -1;
+     number = field + 2;
+   }
+   else if( arc.order < 0 )
+   {
+     error = "Compact RINEX difference without the start of its arc: " + string( field, length );
+     return false;
+   }
+
+   from_chars_result result = from_chars( number, field + length, value );
+   if( result.ec != errc() || result.ptr != field + length )
+   {
+     error = "bad Compact RINEX field " + string( field, length );
+     return false;
+   }
+
+   if( arc.order < 0 )
+   {
+     arc.order = 0;
+     arc.diff[0] = value;
+     return true;
+   }
+   if( arc.order < arc.maxOrder )
+     arc.order++;
+   arc.diff[ arc.order ] = value;
+   for( int m = arc.order; m > 0; m-- )
+     arc.diff[ m - 1 ] += arc.diff[m];
+   return true;
+}
+
+//========================== RecordFormatter Class ============================
+
+RecordFormatter::RecordFormatter()
+{
+   buffer.reserve( 256 );
+}
+
+void RecordFormatter::appendInt( long value, int width, char fill )
+{
+   char digits[24];
+   to_chars_result result = to_chars( digits, digits + sizeof( digits ), value );
+   appendPadded( digits, result.ptr, width, fill );
+}
+
+void RecordFormatter::appendFixed( double value, int width, int precision )
+{
+   // 309 integer digits for the largest double, the sign, the point and the
+   // decimals
+   char digits[384];
+   to_chars_result result = to_chars( digits, digits + sizeof( digits ), value,
+                                      chars_format::fixed, precision );
+   if( result.ec != errc() )
+     result.ptr = digits;   // only for precisions no writer uses
+   appendPadded( digits, result.ptr, width, ' ' );
+}
+
+void RecordFormatter::flush( ostream &output )
+{
+   output.write( buffer.data(), static_cast< streamsize >( buffer.size() ) );
+   buffer.clear();
+}
+
+// ostream pads on the left (right-justified) and never truncates
+void RecordFormatter::appendPadded( const char *first, const char *last,
+                                    int width, char fill )
+{
+   long length = last - first;
+   if( length < width )
+     buffer.append( static_cast< size_t >( width - length ), fill );
+   buffer.append( first, static_cast< size_t >( length ) );
+}
+
+} // namespace NGSrinex
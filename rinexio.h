@@ -0,0 +1,284 @@
+// rinexio.h
+
+// Line sources for the RINEX file readers.  A LineSource hands out one
+// record at a time as a (pointer, length) span without the trailing '\n',
+// which is how the RinexFile classes see their input.  MappedLineSource
+// serves the spans straight out of a read-only memory mapping of the file,
+// SpanLineSource out of part of a buffer owned by someone else;
+// StreamLineSource is the portable fallback built on an istream.
+// GzipLineSource inflates a gzip file as it is read, and HatanakaLineSource
+// restores the RINEX records of a Compact RINEX file from any other source,
+// so compressed archives are read in place without temporary files.
+//
+// RecordFormatter is the output side: the writers append fixed-width fields
+// to it and hand the finished record to the stream in one write.
+
+#if !defined( __RINEXIO__ )
+#define __RINEXIO__
+
+#if !defined( ISTREAM_ )
+#include <istream>
+#define ISTREAM_
+#endif
+
+#if !defined( STRING_ )
+#include <string>
+#define STRING_
+#endif
+
+#if !defined( OSTREAM_ )
+#include <ostream>
+#define OSTREAM_
+#endif
+
+#if !defined( VECTOR_ )
+#include <vector>
+#define VECTOR_
+#endif
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+#define RINEX_HAVE_MMAP
+#endif
+
+struct gzFile_s;   // zlib's file handle, when built with RINEX_HAVE_ZLIB
+
+
+namespace NGSrinex {
+
+using namespace std;
+
+//======================== LineSource Class ================================
+
+   class LineSource   // this is a base class
+   {
+       public:
+         virtual ~LineSource();
+
+         // Return the next record, or false at the end of the input.  The
+         // span stays valid until the next call unless linesPersist().
+         virtual bool nextLine( const char *&line, size_t &length ) = 0;
+
+         // Byte offset of the next record, and repositioning to an offset
+         // previously returned by tell().
+         virtual unsigned long long tell() = 0;
+         virtual bool seek( unsigned long long offset ) = 0;
+
+         // True when earlier spans remain valid after later nextLine() calls.
+         virtual bool linesPersist() const;
+
+         // Why nextLine() returned false before the end of the input, or
+         // empty at the end of the input.
+         virtual string getError() const;
+   };
+
+//======================== StreamLineSource Class ==========================
+
+   class StreamLineSource : public LineSource
+   {
+       public:
+         StreamLineSource( istream &input );
+         ~StreamLineSource();
+
+         bool nextLine( const char *&line, size_t &length );
+         unsigned long long tell();
+         bool seek( unsigned long long offset );
+
+       private:
+         istream    &inputStream;
+         string      lineBuffer;    // reused for every record
+   };
+
+//======================== SpanLineSource Class ============================
+
+   // Serves the records of a buffer that the caller keeps valid, such as a
+   // range of a mapping shared by several readers.
+
+   class SpanLineSource : public LineSource
+   {
+       public:
+         SpanLineSource( const char *data = 0, size_t size = 0 );
+
+         bool nextLine( const char *&line, size_t &length );
+         unsigned long long tell();
+         bool seek( unsigned long long offset );
+         bool linesPersist() const;
+
+         const char *getData() const { return data; }
+         size_t      getSize() const { return size; }
+
+       protected:
+         const char *data;
+         size_t      size;
+         size_t      position;
+   };
+
+//======================== MappedLineSource Class ==========================
+
+   class MappedLineSource : public SpanLineSource
+   {
+       public:
+         MappedLineSource();
+         ~MappedLineSource();
+
+         // Map the whole file read-only and advise sequential access.
+         // Returns false (and maps nothing) if the file cannot be mapped,
+         // in which case the caller should fall back to a StreamLineSource.
+         bool open( const string &pathFilename );
+
+       private:
+         MappedLineSource( const MappedLineSource & );            // not copyable
+         MappedLineSource &operator=( const MappedLineSource & );
+   };
+
+//======================== GzipLineSource Class ============================
+
+   // Offsets are those of the inflated text.  Seeking backwards inflates
+   // again from the start of the file.
+
+   class GzipLineSource : public LineSource
+   {
+       public:
+         GzipLineSource();
+         ~GzipLineSource();
+
+         // True if the file starts with the gzip magic bytes.
+         static bool isGzipFile( const string &pathFilename );
+
+         // Returns false if the file cannot be opened, or if the readers
+         // were built without zlib (RINEX_HAVE_ZLIB).
+         bool open( const string &pathFilename );
+
+         bool nextLine( const char *&line, size_t &length );
+         unsigned long long tell();
+         bool seek( unsigned long long offset );
+         string getError() const;
+
+       private:
+         gzFile_s            *file;
+         vector<char>         buffer;        // grows to the longest record
+         size_t               begin;         // next record in the buffer
+         size_t               end;           // of the inflated bytes
+         unsigned long long   bufferOffset;  // of buffer[0] in the text
+         bool                 atEnd;
+         string               error;
+
+         GzipLineSource( const GzipLineSource & );            // not copyable
+         GzipLineSource &operator=( const GzipLineSource & );
+   };
+
+//======================== HatanakaLineSource Class ========================
+
+   // Restores the RINEX 2 records of a Compact RINEX 1.0 file, one epoch at
+   // a time: the epoch record from its text difference to the previous one,
+   // the receiver clock offset and the observations from their integer
+   // differences (of up to ninth order, on the values in units of the last
+   // RINEX decimal), and the LLI and signal strength flags from their text
+   // differences.  An observation arc restarts at "n&value" and ends at a
+   // blank field or an epoch without the satellite.
+   //
+   // Offsets are those of the restored text.  Seeking decodes forward to
+   // the offset, from the start of the file to go backwards.
+
+   class HatanakaLineSource : public LineSource
+   {
+       public:
+         HatanakaLineSource( LineSource *compact );   // takes ownership
+         ~HatanakaLineSource();
+
+         // True for the first record of a Compact RINEX file (CRINEX VERS
+         // / TYPE), of any version.
+         static bool isCompactRinex( const char *line, size_t length );
+
+         bool nextLine( const char *&line, size_t &length );
+         unsigned long long tell();
+         bool seek( unsigned long long offset );
+         string getError() const;
+
+       private:
+         enum
+         {
+           MAXTYPES = 30,       // observation types per satellite
+           MAXORDER = 9,        // of the differences
+           NUMSYSTEMS = 8,
+           MAXSATNUM = 100
+         };
+
+         struct Arc
+         {
+           int         order;        // -1 = not started
+           int         maxOrder;
+           long long   diff[ MAXORDER + 1 ];   // the value and its differences
+         };
+
+         struct Satellite
+         {
+           unsigned long  epoch;     // last epoch the satellite was in
+           Arc            obs[ MAXTYPES ];
+           string         flags;     // LLI and signal strength, two per type
+         };
+
+         LineSource          *input;
+         bool                 inHeader;
+         unsigned             numTypes;
+         string               epochRecord;   // the last epoch, restored
+         string               record;        // the epoch being restored
+         Arc                  clock;
+         vector<Satellite>    satellites;    // by system and number
+         unsigned long        numEpochs;
+         vector<string>       output;        // restored records of one epoch
+         size_t               numOutput;
+         size_t               nextOutput;
+         unsigned long long   offset;        // of the next record handed out
+         string               error;
+
+         void restart();
+         bool decodeNext();
+         bool decodeEpoch( const char *line, size_t length );
+         bool decodeValue( Arc &arc, const char *field, size_t length );
+         string &newRecord();
+
+         HatanakaLineSource( const HatanakaLineSource & );            // not copyable
+         HatanakaLineSource &operator=( const HatanakaLineSource & );
+   };
+
+//======================== RecordFormatter Class ===========================
+
+   // Formats fixed-width fields into a reusable buffer with std::to_chars.
+   // The fields are byte-for-byte what an ostream in fixed mode produces with
+   // setw(), setfill() and setprecision(), without the locale and stream
+   // state of every insertion.
+   class RecordFormatter
+   {
+       public:
+         RecordFormatter();
+
+         void clear() { buffer.clear(); }
+
+         void append( char c ) { buffer.push_back( c ); }
+         void append( const char *text, size_t length ) { buffer.append( text, length ); }
+         void append( const string &text ) { buffer.append( text ); }
+         void appendBlanks( size_t count ) { buffer.append( count, ' ' ); }
+
+         // An integer right-justified in width characters (setw(width),
+         // setfill(fill)).
+         void appendInt( long value, int width = 0, char fill = ' ' );
+
+         // A double in fixed notation with precision decimals, right-justified
+         // in width characters (fixed, setw(width), setprecision(precision)).
+         void appendFixed( double value, int width, int precision );
+
+         const char *data() const { return buffer.data(); }
+         size_t      size() const { return buffer.size(); }
+
+         // Write the record to a stream and clear it.
+         void flush( ostream &output );
+
+       private:
+         string      buffer;
+
+         void appendPadded( const char *first, const char *last, int width, char fill );
+   };
+
+} // namespace NGSrinex
+
+#endif
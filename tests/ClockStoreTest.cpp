@@ -0,0 +1,111 @@
+// Summary:
+//    Checks the interpolation of ClockStore around gaps in a satellite's
+//    records: a table with two gaps longer than the maximum is queried
+//    inside, between and across them, with linear and with Lagrange
+//    interpolation.  Also checks that correctSatellite() takes the
+//    relativistic effect from the satellite's velocity, so that a satellite
+//    is corrected on its first call.
+
+#include <cstdio>
+#include <cmath>
+#include <limits>
+
+#include "ClockStore.h"
+
+namespace
+{
+   const double C = 299792458.0;               // m/s
+   const long WEEK = 2192;
+   const double START = 522000.0;
+
+   // records every 30 s, with gaps after 90 s and after 1090 s; the bias is
+   // linear in time so that every interpolation is exact
+   const double TIMES[] = { 0.0, 30.0, 60.0, 90.0, 1000.0, 1030.0, 1060.0, 1090.0,
+                            2000.0, 2030.0, 2060.0 };
+
+   double biasAt( double t )
+   {
+      return 1e-4 + 2e-9 * t;
+   }
+
+   bool check( const ClockStore &clocks, double t, bool expected, const char *what )
+   {
+      double bias = 0.0;
+      bool found = clocks.interpolate('G', 5, WEEK, START + t, bias);
+      if (found != expected)
+      {
+         printf("FAILED: %s at %g s %s\n", what, t, found ? "was interpolated" : "was not interpolated");
+         return false;
+      }
+      if (found && fabs(bias - biasAt(t)) > 1e-15)
+      {
+         printf("FAILED: %s at %g s is %.15g instead of %.15g\n", what, t, bias, biasAt(t));
+         return false;
+      }
+      return true;
+   }
+}
+
+
+int main()
+{
+   ClockStore clocks;
+   for (size_t i = 0; i < sizeof(TIMES) / sizeof(TIMES[0]); ++i)
+      clocks.add('G', 5, WEEK, START + TIMES[i], biasAt(TIMES[i]));
+
+   bool ok = true;
+   const int points[] = { 2, 4, 6, 8 };
+   for (size_t k = 0; k < sizeof(points) / sizeof(points[0]); ++k)
+   {
+      clocks.setNumPoints(points[k]);
+      ok = check(clocks, 30.0, true, "a record") && ok;
+      ok = check(clocks, 45.0, true, "a time before the first gap") && ok;
+      ok = check(clocks, 1045.0, true, "a time between the gaps") && ok;
+      ok = check(clocks, 2015.0, true, "a time after the second gap") && ok;
+      ok = check(clocks, 500.0, false, "a time in the first gap") && ok;
+      ok = check(clocks, 1500.0, false, "a time in the second gap") && ok;
+      ok = check(clocks, -15.0, false, "a time before the records") && ok;
+      ok = check(clocks, 2075.0, false, "a time after the records") && ok;
+   }
+
+   // a satellite moving away from the centre of the Earth: r.v > 0
+   clocks.setNumPoints(2);
+   SatelliteData sat;
+   sat.prn = 5;
+   sat.system = 'G';
+   sat.x = 26560e3;
+   sat.y = 0.0;
+   sat.z = 0.0;
+   sat.vx = 10.0;
+   sat.vy = 3870.0;
+   sat.vz = 0.0;
+   sat.correction = 0.0;
+   double pseudorange = 0.07 * C;
+   if (!clocks.correctSatellite(sat, WEEK, START + 45.07, pseudorange))
+   {
+      printf("FAILED: a satellite was not corrected on its first call\n");
+      ok = false;
+   }
+   else
+   {
+      double expected = -C * (biasAt(45.0) - 2.0 * sat.x * sat.vx / (C * C));
+      if (fabs(sat.correction - expected) > 1e-6)
+      {
+         printf("FAILED: the correction is %.9f m instead of %.9f m\n", sat.correction, expected);
+         ok = false;
+      }
+   }
+
+   // satpos.txt satellites without a neighbouring epoch have no velocity
+   sat.vx = std::numeric_limits<double>::quiet_NaN();
+   if (clocks.correctSatellite(sat, WEEK, START + 45.07, pseudorange))
+   {
+      printf("FAILED: a satellite without a velocity was corrected\n");
+      ok = false;
+   }
+
+   if (ok)
+      printf("ClockStore: interpolation around two gaps with 2 to 8 points, "
+             "relativistic effect from the velocity\n");
+   return ok ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+// Summary:
+//    Checks that EphemerisBatch::evaluate() agrees with the scalar
+//    EphemerisStore::evaluate() for every satellite of a batch: positions,
+//    velocities and clocks.  The ephemerides are synthetic GPS orbits of all
+//    six planes with a spread of eccentricities, harmonic corrections and
+//    clock terms, evaluated at times on either side of toe and across the
+//    end of the week.  The batch sizes leave partial vectors at the end of
+//    every loop.  The batch kernels are the ones the loader picked for this
+//    CPU.
+
+#include <cstdio>
+#include <cmath>
+#include <vector>
+
+#include "EphemerisStore.h"
+#include "EphemerisBatch.h"
+
+namespace
+{
+   const double PI = 3.14159265358979323846;
+   const long WEEK = 2191;
+   const double TOE = 597600.0;                // 2 hours before the end of the week
+
+   // the largest differences accepted: the batch may use vector sin, cos
+   // and atan2, which are good to a few ulp
+   const double MAXPOSITIONDIFF = 1e-5;        // m
+   const double MAXVELOCITYDIFF = 1e-8;        // m/s
+   const double MAXCLOCKDIFF = 1e-16;          // s
+
+   GpsEphemeris makeEphemeris( int prn )
+   {
+      GpsEphemeris eph;
+      eph.prn = prn;
+      eph.week = WEEK;
+      eph.toe = TOE;
+      eph.tocWeek = WEEK;
+      eph.toc = TOE;
+      eph.af0 = 1e-4 * sin(prn * 1.7);
+      eph.af1 = -5e-12 * cos(prn * 0.3);
+      eph.af2 = prn % 3 ? 0.0 : 1e-19;
+      eph.tgd = -1e-8 * (prn % 5);
+      eph.iode = eph.iodc = prn;
+      eph.transmitTime = TOE - 7200.0;
+      eph.health = 0.0;
+      eph.sqrtA = 5153.6 + 0.3 * (prn % 7);
+      eph.e = 0.0005 + 0.003 * (prn % 9);
+      eph.M0 = -PI + 2.0 * PI * prn / 37.0;
+      eph.deltaN = 4.5e-9 + 1e-10 * (prn % 4);
+      eph.omega0 = PI / 3.0 * (prn % 6) - PI;
+      eph.omegaDot = -8.2e-9;
+      eph.i0 = 0.96 + 0.01 * (prn % 3);
+      eph.idot = 2e-10 * (prn % 2 ? 1 : -1);
+      eph.omega = 0.5 * prn - 3.0;
+      eph.cuc = 1e-6 * cos(prn * 1.1);
+      eph.cus = 8e-6 * sin(prn * 0.7);
+      eph.crc = 250.0 + 10.0 * (prn % 4);
+      eph.crs = -20.0 * cos(prn * 0.9);
+      eph.cic = 1e-7 * sin(prn * 0.5);
+      eph.cis = -1e-7 * cos(prn * 0.4);
+      return eph;
+   }
+
+   double largest( double a, double b, double c )
+   {
+      return fmax(fabs(a), fmax(fabs(b), fabs(c)));
+   }
+}
+
+
+int main()
+{
+   bool ok = true;
+   double maxPosition = 0.0, maxVelocity = 0.0, maxClock = 0.0;
+   const size_t sizes[] = { 1, 3, 8, 13, 32 };
+   const double offsets[] = { -7200.0, -0.07, 0.0, 1234.5678, 7199.9 };   // from toe
+
+   EphemerisBatch batch;
+   std::vector<GpsEphemeris> ephemerides;
+   for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+   {
+      batch.clear();
+      ephemerides.clear();
+      for (size_t i = 0; i < sizes[s]; ++i)
+      {
+         ephemerides.push_back(makeEphemeris(static_cast<int>(i) + 1));
+         batch.add(ephemerides.back());
+      }
+
+      for (size_t k = 0; k < sizeof(offsets) / sizeof(offsets[0]); ++k)
+      {
+         // a different time for each satellite, as for transmit times;
+         // past the end of the week the time is in the next week
+         std::vector<long> weeks(sizes[s]);
+         std::vector<double> times(sizes[s]);
+         for (size_t i = 0; i < sizes[s]; ++i)
+         {
+            weeks[i] = WEEK;
+            times[i] = TOE + offsets[k] + 0.003 * i;
+            if (times[i] >= 604800.0)
+            {
+               weeks[i]++;
+               times[i] -= 604800.0;
+            }
+            batch.setTime(i, weeks[i], times[i]);
+         }
+         batch.evaluate();
+
+         SatelliteState state;
+         for (size_t i = 0; i < sizes[s]; ++i)
+         {
+            EphemerisStore::evaluate(ephemerides[i], weeks[i], times[i], state);
+            if (batch.getPRNs()[i] != ephemerides[i].prn)
+            {
+               printf("FAILED: satellite %zu of %zu has PRN %d\n", i, sizes[s], batch.getPRNs()[i]);
+               ok = false;
+            }
+            maxPosition = fmax(maxPosition, largest(batch.getX()[i] - state.x,
+                                                    batch.getY()[i] - state.y,
+                                                    batch.getZ()[i] - state.z));
+            maxVelocity = fmax(maxVelocity, largest(batch.getVX()[i] - state.vx,
+                                                    batch.getVY()[i] - state.vy,
+                                                    batch.getVZ()[i] - state.vz));
+            maxClock = fmax(maxClock, fabs(batch.getClockBias()[i] - state.clockBias));
+         }
+      }
+   }
+
+   printf("EphemerisBatch: largest differences from EphemerisStore::evaluate() "
+          "%.2g m, %.2g m/s, %.2g s\n", maxPosition, maxVelocity, maxClock);
+   if (!(maxPosition <= MAXPOSITIONDIFF))
+   {
+      printf("FAILED: batched positions differ by more than %g m\n", MAXPOSITIONDIFF);
+      ok = false;
+   }
+   if (!(maxVelocity <= MAXVELOCITYDIFF))
+   {
+      printf("FAILED: batched velocities differ by more than %g m/s\n", MAXVELOCITYDIFF);
+      ok = false;
+   }
+   if (!(maxClock <= MAXCLOCKDIFF))
+   {
+      printf("FAILED: batched clocks differ by more than %g s\n", MAXCLOCKDIFF);
+      ok = false;
+   }
+   return ok ? 0 : 1;
+}
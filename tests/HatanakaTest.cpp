@@ -0,0 +1,205 @@
+// Summary:
+//    Checks that HatanakaLineSource restores a Compact RINEX 1.0 file to
+//    its RINEX 2 twin record for record, read directly and through
+//    GzipLineSource.  The fixture in tests/data is one minute of the
+//    observation file in data/, edited so that the compact file has arcs
+//    started at the first epoch and restarted after a blank field and
+//    after a satellite that drops out for five epochs, blank fields, a
+//    receiver clock offset that starts and stops, an event record and a
+//    full epoch record after 50 epochs.  The offsets handed out by tell()
+//    are those of the plain file, and seek() goes back and forth between
+//    them.  A file cut short within an epoch reports an error.
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "rinexio.h"
+
+using NGSrinex::LineSource;
+using NGSrinex::StreamLineSource;
+using NGSrinex::SpanLineSource;
+using NGSrinex::GzipLineSource;
+using NGSrinex::HatanakaLineSource;
+
+namespace
+{
+   // every record of a source, and the offset it starts at
+   struct Records
+   {
+      std::vector<std::string> text;
+      std::vector<unsigned long long> offsets;
+   };
+
+   void readAll( LineSource &source, Records &records )
+   {
+      const char *line;
+      size_t length;
+      records.text.clear();
+      records.offsets.clear();
+      unsigned long long offset = source.tell();
+      while (source.nextLine(line, length))
+      {
+         records.offsets.push_back(offset);
+         records.text.push_back(std::string(line, length));
+         offset = source.tell();
+      }
+   }
+
+   // the first record that starts with the given text
+   size_t findRecord( const Records &records, const char *start )
+   {
+      for (size_t i = 0; i < records.text.size(); ++i)
+         if (records.text[i].compare(0, std::string(start).length(), start) == 0)
+            return i;
+      return records.text.size();
+   }
+
+   bool compare( const Records &plain, const Records &restored, const char *what )
+   {
+      if (restored.text.size() != plain.text.size())
+      {
+         printf("FAILED: %s restores %zu records instead of %zu\n", what,
+                restored.text.size(), plain.text.size());
+         return false;
+      }
+      for (size_t i = 0; i < plain.text.size(); ++i)
+      {
+         if (restored.text[i] != plain.text[i])
+         {
+            printf("FAILED: %s record %zu is\n   \"%s\" instead of\n   \"%s\"\n", what, i + 1,
+                   restored.text[i].c_str(), plain.text[i].c_str());
+            return false;
+         }
+         if (restored.offsets[i] != plain.offsets[i])
+         {
+            printf("FAILED: %s record %zu is at offset %llu instead of %llu\n", what, i + 1,
+                   restored.offsets[i], plain.offsets[i]);
+            return false;
+         }
+      }
+      return true;
+   }
+
+   // seek to the record, then read from there to the end
+   bool seekAndCompare( LineSource &source, const Records &plain, size_t first, const char *what )
+   {
+      if (first >= plain.text.size())
+      {
+         printf("FAILED: the fixture has no record to seek to (%s)\n", what);
+         return false;
+      }
+      if (!source.seek(plain.offsets[first]) || source.tell() != plain.offsets[first])
+      {
+         printf("FAILED: %s cannot seek to record %zu\n", what, first + 1);
+         return false;
+      }
+
+      Records tail, expected;
+      readAll(source, tail);
+      expected.text.assign(plain.text.begin() + first, plain.text.end());
+      expected.offsets.assign(plain.offsets.begin() + first, plain.offsets.end());
+      return compare(expected, tail, what);
+   }
+
+   bool checkSource( LineSource &source, const Records &plain, const char *what )
+   {
+      Records restored;
+      readAll(source, restored);
+      if (!source.getError().empty())
+      {
+         printf("FAILED: %s: %s\n", what, source.getError().c_str());
+         return false;
+      }
+      bool ok = compare(plain, restored, what);
+
+      // backwards: before the dropout, from the start and into the header;
+      // forwards: to the full epoch record, then the event
+      ok = ok && seekAndCompare(source, plain, findRecord(plain, " 22 01 08 01 00 19.0000000"),
+                                "a backwards seek to an epoch");
+      ok = ok && seekAndCompare(source, plain, findRecord(plain, " 22 01 08 01 00 19.0000000") + 3,
+                                "a seek within an epoch");
+      ok = ok && seekAndCompare(source, plain, 0, "a seek to the start");
+      ok = ok && seekAndCompare(source, plain, 5, "a seek into the header");
+      ok = ok && seekAndCompare(source, plain, findRecord(plain, " 22 01 08 01 00 40.5000000"),
+                                "a seek to the event record");
+      return ok;
+   }
+}
+
+
+int main( int argc, char *argv[] )
+{
+   std::string directory = argc > 1 ? argv[1] : "tests/data";
+   std::string plainName = directory + "/hatanaka.22o";
+   std::string compactName = directory + "/hatanaka.22d";
+
+   std::ifstream plainFile(plainName.c_str(), std::ios::binary);
+   std::ifstream compactFile(compactName.c_str(), std::ios::binary);
+   if (!plainFile || !compactFile)
+   {
+      printf("FAILED: cannot open %s and %s\n", plainName.c_str(), compactName.c_str());
+      return 1;
+   }
+
+   Records plain;
+   StreamLineSource plainSource(plainFile);
+   readAll(plainSource, plain);
+
+   // the fixture covers what it is meant to
+   bool ok = true;
+   const char *needed[] = { " 22 01 08 01 00 20.0000000  0 11", " 22 01 08 01 00 40.5000000  4",
+                            " 22 01 08 01 00 05.0000000  0 12G01G06G07G10G13G14G15G17G19G21G24G30-0.0000107" };
+   for (size_t k = 0; k < sizeof(needed) / sizeof(needed[0]); ++k)
+   {
+      if (findRecord(plain, needed[k]) == plain.text.size())
+      {
+         printf("FAILED: the fixture has no record \"%s\"\n", needed[k]);
+         ok = false;
+      }
+   }
+
+   HatanakaLineSource compact(new StreamLineSource(compactFile));
+   ok = checkSource(compact, plain, "hatanaka.22d") && ok;
+
+   GzipLineSource *gzip = new GzipLineSource();
+   std::string gzipName = compactName + ".gz";
+   if (gzip->open(gzipName))
+   {
+      HatanakaLineSource compressed(gzip);
+      ok = checkSource(compressed, plain, "hatanaka.22d.gz") && ok;
+   }
+   else
+   {
+      delete gzip;
+#if defined( RINEX_HAVE_ZLIB )
+      printf("FAILED: cannot open %s\n", gzipName.c_str());
+      ok = false;
+#else
+      printf("Built without zlib: %s not read\n", gzipName.c_str());
+#endif
+   }
+
+   // the compact file cut after the clock offset of the full epoch record
+   compactFile.clear();
+   compactFile.seekg(0);
+   std::ostringstream contents;
+   contents << compactFile.rdbuf();
+   std::string text = contents.str();
+   size_t cut = text.find("\n", text.find("&22 01 08 01 00 50") + 1);
+   cut = text.find("\n", cut + 1);
+   Records truncated;
+   HatanakaLineSource cutShort(new SpanLineSource(text.data(), cut + 1));
+   readAll(cutShort, truncated);
+   if (cutShort.getError().empty())
+   {
+      printf("FAILED: a Compact RINEX file cut within an epoch reads without an error\n");
+      ok = false;
+   }
+
+   if (ok)
+      printf("HatanakaLineSource: %zu records restored, as read and after seeks\n", plain.text.size());
+   return ok ? 0 : 1;
+}
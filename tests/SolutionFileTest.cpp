@@ -0,0 +1,176 @@
+// Summary:
+//    Writes solutions with SolutionWriter, reads them back with
+//    SolutionReader and checks that every stored field comes back bit for
+//    bit: ordinary epochs, NaN and infinite values (rows whose solution is
+//    missing), signed zeros, subnormals and the integer extremes of
+//    NumSats.  Several chunk sizes cover full, partial and single-row
+//    chunks as well as an empty file.
+
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "SolutionFile.h"
+
+namespace
+{
+   const char *FILENAME = "SolutionFileTest.bin";
+
+   // the fields SolutionWriter stores, in CSV order
+   double SolutionRow::*const FLOATFIELDS[SolutionFile::NUMFLOATCOLUMNS] =
+   {
+      &SolutionRow::epochTime, &SolutionRow::x, &SolutionRow::y, &SolutionRow::z,
+      &SolutionRow::cdt, &SolutionRow::HDOP, &SolutionRow::VDOP, &SolutionRow::PDOP,
+      &SolutionRow::GDOP, &SolutionRow::east, &SolutionRow::north, &SolutionRow::up
+   };
+
+   double fromBits( uint64_t bits )
+   {
+      double value;
+      memcpy(&value, &bits, sizeof(value));
+      return value;
+   }
+
+   bool sameBits( double a, double b )
+   {
+      return memcmp(&a, &b, sizeof(a)) == 0;
+   }
+
+   void makeRows( std::vector<SolutionRow> &rows )
+   {
+      const double special[] =
+      {
+         std::numeric_limits<double>::quiet_NaN(),
+         -std::numeric_limits<double>::quiet_NaN(),
+         fromBits(0x7FF0000000000001ULL),          // signalling NaN payload
+         fromBits(0x7FF8DEADBEEF0001ULL),          // quiet NaN payload
+         std::numeric_limits<double>::infinity(),
+         -std::numeric_limits<double>::infinity(),
+         0.0, -0.0,
+         std::numeric_limits<double>::denorm_min(),
+         -std::numeric_limits<double>::max(),
+         std::numeric_limits<double>::epsilon()
+      };
+      const size_t numSpecial = sizeof(special) / sizeof(special[0]);
+      const int32_t numSats[] = { 0, 4, 12, -1, std::numeric_limits<int32_t>::max(),
+                                  std::numeric_limits<int32_t>::min() };
+
+      for (size_t i = 0; i < 100; ++i)
+      {
+         SolutionRow row;
+         memset(&row, 0, sizeof(row));
+         for (int c = 0; c < SolutionFile::NUMFLOATCOLUMNS; ++c)
+            row.*FLOATFIELDS[c] = 522000.0 + i + c * 0.1 / 3.0 - 1641890.118 * (c % 3);
+
+         // every fourth row is a missing solution: NaN everywhere but the time
+         if (i % 4 == 1)
+            for (int c = 1; c < SolutionFile::NUMFLOATCOLUMNS; ++c)
+               row.*FLOATFIELDS[c] = std::numeric_limits<double>::quiet_NaN();
+         if (i % 4 == 3)
+            for (int c = 0; c < SolutionFile::NUMFLOATCOLUMNS; ++c)
+               row.*FLOATFIELDS[c] = special[(i + c) % numSpecial];
+
+         row.numSats = numSats[i % (sizeof(numSats) / sizeof(numSats[0]))];
+         rows.push_back(row);
+      }
+   }
+
+   // write the rows with the given chunk size and compare what is read back
+   bool roundTrip( const std::vector<SolutionRow> &rows, unsigned chunkRows )
+   {
+      SolutionWriter writer;
+      if (!writer.open(FILENAME, chunkRows))
+      {
+         printf("FAILED: cannot create %s\n", FILENAME);
+         return false;
+      }
+      for (size_t i = 0; i < rows.size(); ++i)
+         writer.write(rows[i]);
+      if (!writer.close())
+      {
+         printf("FAILED: writing %s with %u rows per chunk\n", FILENAME, chunkRows);
+         return false;
+      }
+
+      SolutionReader reader;
+      if (!reader.open(FILENAME))
+      {
+         printf("FAILED: cannot read back %s with %u rows per chunk\n", FILENAME, chunkRows);
+         return false;
+      }
+      if (reader.getNumRows() != rows.size())
+      {
+         printf("FAILED: %zu rows read back, %zu written (%u rows per chunk)\n",
+                reader.getNumRows(), rows.size(), chunkRows);
+         return false;
+      }
+
+      for (size_t i = 0; i < rows.size(); ++i)
+      {
+         SolutionRow row;
+         if (!reader.readRow(i, row))
+         {
+            printf("FAILED: row %zu cannot be read (%u rows per chunk)\n", i, chunkRows);
+            return false;
+         }
+         for (int c = 0; c < SolutionFile::NUMFLOATCOLUMNS; ++c)
+         {
+            if (!sameBits(row.*FLOATFIELDS[c], rows[i].*FLOATFIELDS[c]))
+            {
+               printf("FAILED: row %zu column %d differs (%u rows per chunk)\n", i, c, chunkRows);
+               return false;
+            }
+         }
+         if (row.numSats != rows[i].numSats)
+         {
+            printf("FAILED: row %zu NumSats differs (%u rows per chunk)\n", i, chunkRows);
+            return false;
+         }
+      }
+
+      // the column chunks hold the same values as the rows
+      int column = reader.findColumn("Y");
+      size_t first = 0;
+      for (size_t chunk = 0; column >= 0 && chunk < reader.getNumChunks(); ++chunk)
+      {
+         size_t numChunkRows;
+         const double *values = static_cast<const double*>(reader.getColumnChunk(chunk, column, numChunkRows));
+         for (size_t i = 0; i < numChunkRows; ++i)
+         {
+            if (!sameBits(values[i], rows[first + i].y))
+            {
+               printf("FAILED: column Y of chunk %zu differs (%u rows per chunk)\n", chunk, chunkRows);
+               return false;
+            }
+         }
+         first += numChunkRows;
+      }
+      if (column < 0 || first != rows.size())
+      {
+         printf("FAILED: column Y does not cover the rows (%u rows per chunk)\n", chunkRows);
+         return false;
+      }
+      return true;
+   }
+}
+
+
+int main()
+{
+   std::vector<SolutionRow> rows;
+   makeRows(rows);
+
+   const unsigned chunkSizes[] = { 1, 7, 100, SolutionFile::DEFAULTCHUNKROWS };
+   bool ok = roundTrip(std::vector<SolutionRow>(), 7);
+   for (size_t k = 0; ok && k < sizeof(chunkSizes) / sizeof(chunkSizes[0]); ++k)
+      ok = roundTrip(rows, chunkSizes[k]);
+   std::remove(FILENAME);
+
+   if (ok)
+      printf("SolutionFile: %zu rows read back bit for bit with 1, 7, 100 and %d rows per chunk\n",
+             rows.size(), SolutionFile::DEFAULTCHUNKROWS);
+   return ok ? 0 : 1;
+}
@@ -0,0 +1,138 @@
+// Summary:
+//    Checks that solving an epoch with leastSquaresSolution() does not
+//    allocate heap memory.  malloc, calloc and realloc are replaced by
+//    counting versions that forward to glibc, so the allocations of
+//    operator new, of std::vector and of Eigen are all seen.  The epochs are
+//    synthetic: GPS, GLONASS and SBAS satellites around a known receiver, so
+//    every inter-system clock state is exercised.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+#include "LeastSquares.h"
+
+extern "C"
+{
+   void *__libc_malloc( size_t size );
+   void *__libc_calloc( size_t count, size_t size );
+   void *__libc_realloc( void *pointer, size_t size );
+   void __libc_free( void *pointer );
+}
+
+namespace
+{
+   bool counting = false;
+   unsigned long numAllocations = 0;
+
+   const ReferencePosition RECEIVER =
+      { -1641890.118, -3664879.354, 4939969.421, 51.0785, -114.1368 };
+   const double RECEIVERCDT = 1234.5;          // m
+   const double GLONASSBIAS = -30.0;           // m, w.r.t. GPS
+   const double SBASBIAS = 250.0;
+   const int NUMEPOCHS = 200;
+
+   // a satellite at the given radius, azimuth and elevation as seen from the
+   // receiver, and its pseudorange
+   void addSatellite( int prn, char system, double radius, double azDeg, double elDeg,
+                      double clockBias, std::vector<SatelliteData> &satellites,
+                      std::vector<double> &pseudoranges )
+   {
+      double lat = RECEIVER.lat * M_PI / 180.0;
+      double lon = RECEIVER.lon * M_PI / 180.0;
+      double az = azDeg * M_PI / 180.0;
+      double el = elDeg * M_PI / 180.0;
+
+      // unit line of sight in ENU, then ECEF
+      double e = cos(el) * sin(az), n = cos(el) * cos(az), u = sin(el);
+      double dx = -sin(lon) * e - sin(lat) * cos(lon) * n + cos(lat) * cos(lon) * u;
+      double dy =  cos(lon) * e - sin(lat) * sin(lon) * n + cos(lat) * sin(lon) * u;
+      double dz =  cos(lat) * n + sin(lat) * u;
+
+      // the distance along it that puts the satellite at the radius
+      double p = RECEIVER.x * dx + RECEIVER.y * dy + RECEIVER.z * dz;
+      double r2 = RECEIVER.x * RECEIVER.x + RECEIVER.y * RECEIVER.y + RECEIVER.z * RECEIVER.z;
+      double range = -p + sqrt(p * p - r2 + radius * radius);
+
+      SatelliteData sat;
+      sat.prn = prn;
+      sat.system = system;
+      sat.x = RECEIVER.x + range * dx;
+      sat.y = RECEIVER.y + range * dy;
+      sat.z = RECEIVER.z + range * dz;
+      sat.correction = 0.0;
+      satellites.push_back(sat);
+
+      // the solver models a pseudorange as rho - cdt
+      pseudoranges.push_back(range - RECEIVERCDT - clockBias);
+   }
+}
+
+extern "C" void *malloc( size_t size )
+{
+   if (counting)
+      numAllocations++;
+   return __libc_malloc(size);
+}
+
+extern "C" void *calloc( size_t count, size_t size )
+{
+   if (counting)
+      numAllocations++;
+   return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc( void *pointer, size_t size )
+{
+   if (counting)
+      numAllocations++;
+   return __libc_realloc(pointer, size);
+}
+
+extern "C" void free( void *pointer )
+{
+   __libc_free(pointer);
+}
+
+
+int main()
+{
+   std::vector<SatelliteData> satellites;
+   std::vector<double> pseudoranges;
+   const double GPSRADIUS = 26560e3, GLONASSRADIUS = 25510e3, GEORADIUS = 42164e3;
+   for (int i = 0; i < 8; ++i)
+      addSatellite(i + 1, 'G', GPSRADIUS, 45.0 * i, 15.0 + 9.0 * i, 0.0, satellites, pseudoranges);
+   addSatellite(3, 'R', GLONASSRADIUS, 100.0, 40.0, GLONASSBIAS, satellites, pseudoranges);
+   addSatellite(5, 'R', GLONASSRADIUS, 280.0, 25.0, GLONASSBIAS, satellites, pseudoranges);
+   addSatellite(31, 'S', GEORADIUS, 175.0, 30.0, SBASBIAS, satellites, pseudoranges);
+   addSatellite(38, 'S', GEORADIUS, 200.0, 29.0, SBASBIAS, satellites, pseudoranges);
+
+   ReceiverState start = { RECEIVER.x + 100.0, RECEIVER.y - 100.0, RECEIVER.z + 100.0,
+                           RECEIVERCDT, { 0.0, 0.0, 0.0 } };
+   SolutionRow row;
+
+   // cold and warm starts, as the single-threaded loop and the pool call it
+   counting = true;
+   for (int k = 0; k < NUMEPOCHS; ++k)
+      leastSquaresSolution(satellites, pseudoranges, 522000.0 + k, RECEIVER,
+                           k % 2 ? &start : nullptr, row);
+   counting = false;
+
+   double error = sqrt(row.east * row.east + row.north * row.north + row.up * row.up);
+   printf("leastSquaresSolution: %lu allocations in %d epochs, %d satellites, "
+          "position error %.3g m after %d iterations\n",
+          numAllocations, NUMEPOCHS, row.numSats, error, row.iterations);
+
+   if (error > 1e-3 || fabs(row.cdt - RECEIVERCDT) > 1e-3)
+   {
+      printf("FAILED: the solution does not match the simulated receiver\n");
+      return 1;
+   }
+   if (numAllocations != 0)
+   {
+      printf("FAILED: the per-epoch solve allocates heap memory\n");
+      return 1;
+   }
+   return 0;
+}